@@ -0,0 +1,214 @@
+// Batch parsing benchmark: what the allocator costs when many scripts are parsed one after another, as an indexer
+// does.
+//
+// Each input is loaded as one file (a corpus file from test/corpus contributes the source of every test in it,
+// joined, as in bench.c). The whole set is parsed --rounds times in each allocation mode, alternating, and every tree
+// is walked once before it's dropped:
+//
+//   malloc  One parser for every file, and each tree deleted with ts_tree_delete, so each allocation goes to the C
+//           library's allocator (jemalloc's in tree-sitter-autohotkey-batch-jemalloc).
+//   arena   tree_sitter_autohotkey_arena_begin before each file and _end after it. The parser is created and deleted
+//           inside the pair, as the arena requires, and the tree isn't deleted at all: _end drops it with the rest.
+//
+// The arena's functions are installed with ts_set_allocator in both modes; outside of a pair they only forward to
+// malloc and friends. Both modes must see the same trees, so the run fails if their node counts differ.
+//
+// Usage: tree-sitter-autohotkey-batch [--rounds N] [--min-bytes N] [--output PATH] FILE...
+//
+// Built and run by the `bench-batch` CMake target when the tree-sitter runtime library is available.
+
+#include <tree_sitter/api.h>
+#include <tree_sitter/tree-sitter-autohotkey.h>
+
+#include "support.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_ROUNDS 20
+
+// What malloc is in this build, for the output
+#ifndef BATCH_MALLOC_NAME
+#define BATCH_MALLOC_NAME "malloc"
+#endif
+
+enum { MODE_MALLOC, MODE_ARENA, MODE_COUNT };
+
+typedef struct {
+  uint64_t *round_ns;
+  uint64_t nodes;        ///< per round
+  uint64_t allocations;  ///< per round, arena only
+  size_t peak_bytes;     ///< largest arena any one file needed, arena only
+} ModeResult;
+
+static uint64_t count_nodes(TSTree *tree) {
+  TSTreeCursor cursor = ts_tree_cursor_new(ts_tree_root_node(tree));
+  uint64_t nodes = 1;
+  for (;;) {
+    if (ts_tree_cursor_goto_first_child(&cursor)) {
+      nodes++;
+      continue;
+    }
+    while (!ts_tree_cursor_goto_next_sibling(&cursor)) {
+      if (!ts_tree_cursor_goto_parent(&cursor)) goto done;
+    }
+    nodes++;
+  }
+done:
+  ts_tree_cursor_delete(&cursor);
+  return nodes;
+}
+
+static void round_malloc(TSParser *parser, const Buffer *files, int count, ModeResult *result) {
+  uint64_t nodes = 0;
+  for (int i = 0; i < count; i++) {
+    TSTree *tree = ts_parser_parse_string(parser, NULL, files[i].data, (uint32_t)files[i].len);
+    nodes += count_nodes(tree);
+    ts_tree_delete(tree);
+  }
+  result->nodes = nodes;
+}
+
+static void round_arena(const Buffer *files, int count, ModeResult *result) {
+  uint64_t nodes = 0, allocations = 0;
+  for (int i = 0; i < count; i++) {
+    tree_sitter_autohotkey_arena_begin();
+    TSParser *parser = ts_parser_new();
+    ts_parser_set_language(parser, tree_sitter_autohotkey());
+    TSTree *tree = ts_parser_parse_string(parser, NULL, files[i].data, (uint32_t)files[i].len);
+    nodes += count_nodes(tree);
+    ts_parser_delete(parser);
+
+    TSAutohotkeyArenaStats stats;
+    tree_sitter_autohotkey_arena_stats(&stats);
+    tree_sitter_autohotkey_arena_end();
+    allocations += stats.allocations;
+    if (stats.peak > result->peak_bytes) result->peak_bytes = stats.peak;
+  }
+  result->nodes = nodes;
+  result->allocations = allocations;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Output
+
+static const char *mode_name(int mode) { return mode == MODE_ARENA ? "arena" : BATCH_MALLOC_NAME; }
+
+static void write_results(FILE *out, ModeResult *results, int rounds, int files, size_t bytes) {
+  fprintf(out, "{\n  \"schema\": 1,\n  \"rounds\": %d,\n  \"files\": %d,\n  \"bytes\": %zu,\n  \"nodes\": %llu,\n",
+          rounds, files, bytes, (unsigned long long)results[MODE_MALLOC].nodes);
+  fprintf(out, "  \"modes\": [\n");
+  uint64_t baseline = 0;
+  for (int mode = 0; mode < MODE_COUNT; mode++) {
+    ModeResult *r = &results[mode];
+    qsort(r->round_ns, (size_t)rounds, sizeof(uint64_t), compare_u64);
+    uint64_t min_ns = r->round_ns[0], median_ns = r->round_ns[rounds / 2];
+    if (mode == MODE_MALLOC) baseline = min_ns;
+    double seconds = (double)min_ns / 1e9;
+    fprintf(out,
+            "    {\"allocator\": \"%s\", \"min_ns\": %llu, \"median_ns\": %llu, \"mb_per_s\": %.3f, "
+            "\"ns_per_byte\": %.3f, \"files_per_s\": %.1f, \"speedup\": %.3f",
+            mode_name(mode), (unsigned long long)min_ns, (unsigned long long)median_ns,
+            seconds > 0 ? (double)bytes / 1e6 / seconds : 0.0, bytes ? (double)min_ns / (double)bytes : 0.0,
+            seconds > 0 ? (double)files / seconds : 0.0, min_ns ? (double)baseline / (double)min_ns : 0.0);
+    if (mode == MODE_ARENA) {
+      TSAutohotkeyArenaStats stats;
+      tree_sitter_autohotkey_arena_stats(&stats);
+      fprintf(out, ", \"allocations\": %llu, \"peak_bytes\": %zu, \"reserved_bytes\": %zu",
+              (unsigned long long)r->allocations, r->peak_bytes, stats.reserved);
+    }
+    fprintf(out, "}%s\n", mode + 1 < MODE_COUNT ? "," : "");
+    fprintf(stderr, "%-10s %8.2f MB/s %10.1f files/s\n", mode_name(mode),
+            seconds > 0 ? (double)bytes / 1e6 / seconds : 0.0, seconds > 0 ? (double)files / seconds : 0.0);
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr, "usage: %s [--rounds N] [--min-bytes N] [--output PATH] FILE...\n", argv0);
+}
+
+int main(int argc, char **argv) {
+  int rounds = DEFAULT_ROUNDS;
+  size_t min_bytes = 0;
+  const char *output = NULL;
+  int first_input = argc;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+      rounds = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--min-bytes") == 0 && i + 1 < argc) {
+      min_bytes = (size_t)strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+      usage(argv[0]);
+      return 2;
+    } else {
+      first_input = i;
+      break;
+    }
+  }
+
+  if (first_input >= argc || rounds < 1) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  ts_set_allocator(tree_sitter_autohotkey_arena_malloc, tree_sitter_autohotkey_arena_calloc,
+                   tree_sitter_autohotkey_arena_realloc, tree_sitter_autohotkey_arena_free);
+
+  int count = argc - first_input;
+  Buffer *files = calloc((size_t)count, sizeof(Buffer));
+  size_t bytes = 0;
+  for (int i = 0; i < count; i++) {
+    if (!load_input(argv[first_input + i], min_bytes, &files[i])) return 1;
+    bytes += files[i].len;
+  }
+
+  ModeResult results[MODE_COUNT] = {{0}};
+  for (int mode = 0; mode < MODE_COUNT; mode++) {
+    results[mode].round_ns = malloc(sizeof(uint64_t) * (size_t)rounds);
+    if (!results[mode].round_ns) {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+    }
+  }
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_autohotkey());
+  for (int round = 0; round < rounds; round++) {
+    uint64_t start = now_ns();
+    round_malloc(parser, files, count, &results[MODE_MALLOC]);
+    results[MODE_MALLOC].round_ns[round] = now_ns() - start;
+
+    start = now_ns();
+    round_arena(files, count, &results[MODE_ARENA]);
+    results[MODE_ARENA].round_ns[round] = now_ns() - start;
+  }
+  ts_parser_delete(parser);
+
+  if (results[MODE_ARENA].nodes != results[MODE_MALLOC].nodes) {
+    fprintf(stderr, "arena trees have %llu nodes, malloc trees %llu\n",
+            (unsigned long long)results[MODE_ARENA].nodes, (unsigned long long)results[MODE_MALLOC].nodes);
+    return 1;
+  }
+
+  FILE *out = output ? fopen(output, "w") : stdout;
+  if (!out) {
+    fprintf(stderr, "%s: %s\n", output, strerror(errno));
+    return 1;
+  }
+  write_results(out, results, rounds, count, bytes);
+  if (output) fclose(out);
+
+  tree_sitter_autohotkey_arena_release();
+  for (int i = 0; i < count; i++) free(files[i].data);
+  for (int mode = 0; mode < MODE_COUNT; mode++) free(results[mode].round_ns);
+  free(files);
+  return 0;
+}
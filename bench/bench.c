@@ -0,0 +1,510 @@
+// Parse-throughput benchmark for the AutoHotkey grammar.
+//
+// Each input is either a corpus file from test/corpus (the source of every test in it is extracted and joined) or a
+// plain script. Inputs are repeated until they reach --min-bytes, parsed --iterations times from scratch, and the
+// results are written as one JSON document so runs can be diffed and compared by scripts.
+//
+// Usage: tree-sitter-autohotkey-bench [--min-bytes N] [--iterations N] [--glr] [--query FILE] [--utf16]
+//                                    [--output PATH] FILE...
+//
+// With --glr, each file is parsed once more with a logger attached to count how often the GLR stack splits (see
+// GlrStats); that parse is not timed. With --query, the query in FILE (say queries/tags.scm) is also run over each
+// tree --iterations times, and its time is reported next to the number of matches it produced (see QueryResult). With
+// --utf16, each input is also transcoded to UTF-16LE, timed the same way, and its tree checked node by node against
+// the UTF-8 one (see Utf16Result); any difference makes the run fail. Built with TREE_SITTER_AHK_STATS, each file also
+// gets the scanner's per-token probe counters (per parse).
+//
+// Built and run by the `bench` CMake target when the tree-sitter runtime library is available.
+
+#include <tree_sitter/api.h>
+#include <tree_sitter/tree-sitter-autohotkey.h>
+
+#include "support.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_MIN_BYTES (1u << 20)
+#define DEFAULT_ITERATIONS 10
+
+// ---------------------------------------------------------------------------------------------------------------------
+// GLR stack accounting. The runtime logs a "process version:V, version_count:N, ..." line each time it advances one
+// stack version; N is how many versions are alive at that point. A rise in N between two lines means a version forked
+// (a declared conflict let more than one action apply), a fall means versions were merged or dropped.
+
+typedef struct {
+  uint64_t processed;      ///< version advances
+  uint64_t single;         ///< of those, taken while only one version was alive
+  uint64_t version_sum;    ///< sum of N over all advances, for the mean
+  uint32_t max_versions;
+  uint64_t forks;          ///< total rise in N
+  uint32_t last_versions;
+} GlrStats;
+
+static void glr_log(void *payload, TSLogType type, const char *message) {
+  GlrStats *stats = payload;
+  if (type != TSLogTypeParse || strncmp(message, "process version:", 16) != 0) return;
+  const char *count = strstr(message, "version_count:");
+  if (!count) return;
+  uint32_t versions = (uint32_t)strtoul(count + 14, NULL, 10);
+
+  stats->processed++;
+  stats->version_sum += versions;
+  if (versions == 1) stats->single++;
+  if (versions > stats->max_versions) stats->max_versions = versions;
+  if (versions > stats->last_versions) stats->forks += versions - stats->last_versions;
+  stats->last_versions = versions;
+}
+
+static void measure_glr(const Buffer *input, GlrStats *stats) {
+  memset(stats, 0, sizeof(*stats));
+  stats->last_versions = 1;
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_autohotkey());
+  ts_parser_set_logger(parser, (TSLogger){.payload = stats, .log = glr_log});
+  TSTree *tree = ts_parser_parse_string(parser, NULL, input->data, (uint32_t)input->len);
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Queries. A query whose patterns are rooted at specific node types only visits candidate nodes, so its time should
+// follow `matches`; one that grows with the tree's node count instead has a pattern that makes every node a candidate.
+// The runtime doesn't evaluate text predicates (#match?, #eq?, ...) itself; every match of a pattern that has one is
+// left for the consumer to check, so those are counted separately as `guarded`.
+
+typedef struct {
+  uint64_t matches;
+  uint64_t guarded;    ///< matches of patterns with predicates
+  uint64_t captures;
+  uint64_t min_ns;
+  uint64_t median_ns;
+} QueryResult;
+
+static TSQuery *load_query(const char *path) {
+  Buffer source = {0};
+  if (!read_file(path, &source)) return NULL;
+
+  uint32_t error_offset;
+  TSQueryError error;
+  TSQuery *query = ts_query_new(tree_sitter_autohotkey(), source.data ? source.data : "", (uint32_t)source.len,
+                                &error_offset, &error);
+  if (!query) fprintf(stderr, "%s: query error %d at byte %u\n", path, (int)error, error_offset);
+  free(source.data);
+  return query;
+}
+
+static void bench_query(const TSQuery *query, TSNode root, int iterations, QueryResult *result) {
+  uint64_t *times = malloc(sizeof(uint64_t) * (size_t)iterations);
+  TSQueryCursor *cursor = ts_query_cursor_new();
+
+  for (int i = 0; i < iterations; i++) {
+    uint64_t matches = 0, captures = 0;
+    TSQueryMatch match;
+    uint64_t start = now_ns();
+    ts_query_cursor_exec(cursor, query, root);
+    while (ts_query_cursor_next_match(cursor, &match)) {
+      matches++;
+      captures += match.capture_count;
+    }
+    times[i] = now_ns() - start;
+    result->matches = matches;
+    result->captures = captures;
+  }
+
+  // Outside the timed loop: which of the matches a consumer would still have to filter
+  uint32_t pattern_count = ts_query_pattern_count(query);
+  bool *has_predicates = calloc(pattern_count ? pattern_count : 1, sizeof(bool));
+  for (uint32_t p = 0; p < pattern_count; p++) {
+    uint32_t steps;
+    ts_query_predicates_for_pattern(query, p, &steps);
+    has_predicates[p] = steps > 0;
+  }
+  TSQueryMatch match;
+  result->guarded = 0;
+  ts_query_cursor_exec(cursor, query, root);
+  while (ts_query_cursor_next_match(cursor, &match)) {
+    if (has_predicates[match.pattern_index]) result->guarded++;
+  }
+  free(has_predicates);
+
+  qsort(times, (size_t)iterations, sizeof(uint64_t), compare_u64);
+  result->min_ns = times[0];
+  result->median_ns = times[iterations / 2];
+
+  ts_query_cursor_delete(cursor);
+  free(times);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// UTF-16. The runtime decodes UTF-16 input to the same code points as UTF-8 before the lexer (and the external
+// scanner, which only compares code points) sees them, so a script must parse to the same tree in either encoding.
+// Byte offsets in a UTF-16 tree count UTF-16 bytes, and so do columns: two per code unit, four per surrogate pair.
+
+typedef struct {
+  uint64_t min_ns;
+  uint64_t median_ns;
+  size_t bytes;
+  uint32_t mismatch;   ///< UTF-8 offset of the first node whose UTF-16 twin differs, or UINT32_MAX
+} Utf16Result;
+
+/// Transcodes `input` to UTF-16LE, whatever the host byte order. `units_at[i]` receives the number of code units
+/// before UTF-8 offset `i`, for every offset that starts a character and for the end. Invalid bytes become U+FFFD,
+/// one per byte; the runtime reads them as decode errors instead, so such inputs can come out as mismatches.
+static void utf8_to_utf16le(const Buffer *input, Buffer *out, uint32_t *units_at) {
+  const unsigned char *s = (const unsigned char *)input->data;
+  size_t len = input->len, i = 0, units = 0;
+  while (i < len) {
+    uint32_t c = s[i], n = 1;
+    if (c >= 0xF0 && c < 0xF5 && i + 3 < len && (s[i + 1] & 0xC0) == 0x80 && (s[i + 2] & 0xC0) == 0x80 &&
+        (s[i + 3] & 0xC0) == 0x80) {
+      c = ((c & 0x07) << 18) | ((s[i + 1] & 0x3Fu) << 12) | ((s[i + 2] & 0x3Fu) << 6) | (s[i + 3] & 0x3Fu);
+      n = 4;
+    } else if (c >= 0xE0 && c < 0xF0 && i + 2 < len && (s[i + 1] & 0xC0) == 0x80 && (s[i + 2] & 0xC0) == 0x80) {
+      c = ((c & 0x0F) << 12) | ((s[i + 1] & 0x3Fu) << 6) | (s[i + 2] & 0x3Fu);
+      n = 3;
+    } else if (c >= 0xC2 && c < 0xE0 && i + 1 < len && (s[i + 1] & 0xC0) == 0x80) {
+      c = ((c & 0x1F) << 6) | (s[i + 1] & 0x3Fu);
+      n = 2;
+    } else if (c >= 0x80) {
+      c = 0xFFFD;
+    }
+
+    units_at[i] = (uint32_t)units;
+    if (c >= 0x10000) {
+      c -= 0x10000;
+      unsigned char pair[4] = {(unsigned char)(0xD800 + (c >> 10)), (unsigned char)((0xD800 + (c >> 10)) >> 8),
+                               (unsigned char)(0xDC00 + (c & 0x3FF)), (unsigned char)((0xDC00 + (c & 0x3FF)) >> 8)};
+      buffer_append(out, (const char *)pair, 4);
+      units += 2;
+    } else {
+      unsigned char unit[2] = {(unsigned char)c, (unsigned char)(c >> 8)};
+      buffer_append(out, (const char *)unit, 2);
+      units++;
+    }
+    i += n;
+  }
+  units_at[len] = (uint32_t)units;
+}
+
+/// Walks both trees in step and returns the UTF-8 start byte of the first node that differs in type, row, or byte
+/// range (after mapping offsets through `units_at`), or UINT32_MAX if they agree everywhere
+static uint32_t compare_utf16_tree(TSNode utf8_root, TSNode utf16_root, const uint32_t *units_at) {
+  TSTreeCursor a = ts_tree_cursor_new(utf8_root), b = ts_tree_cursor_new(utf16_root);
+  uint32_t mismatch;
+  for (;;) {
+    TSNode x = ts_tree_cursor_current_node(&a), y = ts_tree_cursor_current_node(&b);
+    mismatch = ts_node_start_byte(x);
+    if (ts_node_symbol(x) != ts_node_symbol(y) || ts_node_is_missing(x) != ts_node_is_missing(y) ||
+        ts_node_start_point(x).row != ts_node_start_point(y).row ||
+        ts_node_start_byte(y) != 2 * units_at[ts_node_start_byte(x)] ||
+        ts_node_end_byte(y) != 2 * units_at[ts_node_end_byte(x)]) {
+      goto done;
+    }
+    if (ts_tree_cursor_goto_first_child(&a)) {
+      if (!ts_tree_cursor_goto_first_child(&b)) goto done;
+      continue;
+    }
+    if (ts_tree_cursor_goto_first_child(&b)) goto done;
+    while (!ts_tree_cursor_goto_next_sibling(&a)) {
+      if (ts_tree_cursor_goto_next_sibling(&b)) goto done;
+      if (!ts_tree_cursor_goto_parent(&a)) {
+        mismatch = UINT32_MAX;
+        goto done;
+      }
+      ts_tree_cursor_goto_parent(&b);
+    }
+    if (!ts_tree_cursor_goto_next_sibling(&b)) goto done;
+  }
+done:
+  ts_tree_cursor_delete(&a);
+  ts_tree_cursor_delete(&b);
+  return mismatch;
+}
+
+/// Times `iterations` parses of `input` transcoded to UTF-16LE and checks the tree against `utf8_root`
+static void bench_utf16(const Buffer *input, TSNode utf8_root, int iterations, Utf16Result *result) {
+  uint64_t *times = malloc(sizeof(uint64_t) * (size_t)iterations);
+  uint32_t *units_at = malloc(sizeof(uint32_t) * (input->len + 1));
+  Buffer utf16 = {0};
+  if (!times || !units_at) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  utf8_to_utf16le(input, &utf16, units_at);
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_autohotkey());
+  TSTree *tree = NULL;
+  for (int i = 0; i < iterations; i++) {
+    if (tree) ts_tree_delete(tree);
+    uint64_t start = now_ns();
+    tree = ts_parser_parse_string_encoding(parser, NULL, utf16.data, (uint32_t)utf16.len, TSInputEncodingUTF16LE);
+    times[i] = now_ns() - start;
+  }
+  result->bytes = utf16.len;
+  result->mismatch = compare_utf16_tree(utf8_root, ts_tree_root_node(tree), units_at);
+
+  qsort(times, (size_t)iterations, sizeof(uint64_t), compare_u64);
+  result->min_ns = times[0];
+  result->median_ns = times[iterations / 2];
+
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+  free(utf16.data);
+  free(units_at);
+  free(times);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Benchmark
+
+typedef struct {
+  const char *name;
+  size_t bytes;
+  uint32_t nodes;
+  bool has_error;
+  uint64_t min_ns;
+  uint64_t median_ns;
+  size_t peak_bytes;
+  uint64_t allocations;
+  bool has_glr;
+  GlrStats glr;
+  bool has_query;
+  QueryResult query;
+  bool has_utf16;
+  Utf16Result utf16;
+#ifdef TREE_SITTER_AHK_STATS
+  TSAutohotkeyTokenStats scanner[TREE_SITTER_AUTOHOTKEY_EXTERNAL_TOKEN_COUNT];  ///< per parse
+#endif
+} ParseResult;
+
+/// Times `iterations` parses of `input`, then `query` (if any) over the resulting tree, then (if `utf16`) the same
+/// parses in UTF-16
+static void bench_parse(const Buffer *input, int iterations, const TSQuery *query, bool utf16, ParseResult *result) {
+  uint64_t *times = malloc(sizeof(uint64_t) * (size_t)iterations);
+
+  size_t baseline = alloc_stats.current;
+  uint64_t count_before = alloc_stats.count;
+  alloc_stats.peak = baseline;
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_autohotkey());
+#ifdef TREE_SITTER_AHK_STATS
+  tree_sitter_autohotkey_scanner_stats_reset();
+#endif
+
+  TSTree *tree = NULL;
+  for (int i = 0; i < iterations; i++) {
+    if (tree) ts_tree_delete(tree);
+    uint64_t start = now_ns();
+    tree = ts_parser_parse_string(parser, NULL, input->data, (uint32_t)input->len);
+    times[i] = now_ns() - start;
+  }
+
+  TSNode root = ts_tree_root_node(tree);
+  result->bytes = input->len;
+  result->nodes = ts_node_descendant_count(root);
+  result->has_error = ts_node_has_error(root);
+  result->peak_bytes = alloc_stats.peak - baseline;
+  result->allocations = (alloc_stats.count - count_before) / (uint64_t)iterations;
+
+#ifdef TREE_SITTER_AHK_STATS
+  tree_sitter_autohotkey_scanner_stats(result->scanner, TREE_SITTER_AUTOHOTKEY_EXTERNAL_TOKEN_COUNT);
+  for (int t = 0; t < TREE_SITTER_AUTOHOTKEY_EXTERNAL_TOKEN_COUNT; t++) {
+    result->scanner[t].probes /= (uint64_t)iterations;
+    result->scanner[t].hits /= (uint64_t)iterations;
+    result->scanner[t].advanced /= (uint64_t)iterations;
+    result->scanner[t].discarded /= (uint64_t)iterations;
+  }
+#endif
+
+  qsort(times, (size_t)iterations, sizeof(uint64_t), compare_u64);
+  result->min_ns = times[0];
+  result->median_ns = times[iterations / 2];
+
+  if (query) {
+    bench_query(query, root, iterations, &result->query);
+    result->has_query = true;
+  }
+  if (utf16) {
+    bench_utf16(input, root, iterations, &result->utf16);
+    result->has_utf16 = true;
+  }
+
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+  free(times);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Output
+
+static void write_json_string(FILE *out, const char *s) {
+  fputc('"', out);
+  for (; *s; s++) {
+    unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\') fprintf(out, "\\%c", c);
+    else if (c < 0x20) fprintf(out, "\\u%04x", c);
+    else fputc(c, out);
+  }
+  fputc('"', out);
+}
+
+static const char *basename_of(const char *path) {
+  const char *base = path;
+  for (const char *p = path; *p; p++) {
+    if (*p == '/' || *p == '\\') base = p + 1;
+  }
+  return base;
+}
+
+static void write_results(FILE *out, const ParseResult *results, int count, int iterations, size_t min_bytes) {
+  fprintf(out, "{\n  \"schema\": 1,\n  \"iterations\": %d,\n  \"min_bytes\": %zu,\n  \"files\": [\n", iterations,
+          min_bytes);
+  for (int i = 0; i < count; i++) {
+    const ParseResult *r = &results[i];
+    double seconds = (double)r->min_ns / 1e9;
+    fprintf(out, "    {\"name\": ");
+    write_json_string(out, r->name);
+    fprintf(out,
+            ", \"bytes\": %zu, \"nodes\": %u, \"has_error\": %s, \"min_ns\": %llu, \"median_ns\": %llu, "
+            "\"mb_per_s\": %.3f, \"ns_per_byte\": %.3f, \"peak_bytes\": %zu, \"allocations\": %llu",
+            r->bytes, r->nodes, r->has_error ? "true" : "false", (unsigned long long)r->min_ns,
+            (unsigned long long)r->median_ns, seconds > 0 ? (double)r->bytes / 1e6 / seconds : 0.0,
+            r->bytes ? (double)r->min_ns / (double)r->bytes : 0.0, r->peak_bytes,
+            (unsigned long long)r->allocations);
+    if (r->has_glr) {
+      const GlrStats *g = &r->glr;
+      double processed = g->processed ? (double)g->processed : 1.0;
+      fprintf(out,
+              ",\n     \"glr\": {\"processed\": %llu, \"single_stack\": %.4f, \"mean_versions\": %.3f, "
+              "\"max_versions\": %u, \"forks\": %llu, \"forks_per_kb\": %.3f}",
+              (unsigned long long)g->processed, (double)g->single / processed, (double)g->version_sum / processed,
+              g->max_versions, (unsigned long long)g->forks,
+              r->bytes ? (double)g->forks * 1024.0 / (double)r->bytes : 0.0);
+    }
+    if (r->has_query) {
+      const QueryResult *q = &r->query;
+      fprintf(out,
+              ",\n     \"query\": {\"matches\": %llu, \"guarded\": %llu, \"captures\": %llu, \"min_ns\": %llu, "
+              "\"median_ns\": %llu, \"ns_per_match\": %.3f, \"ns_per_node\": %.3f}",
+              (unsigned long long)q->matches, (unsigned long long)q->guarded, (unsigned long long)q->captures,
+              (unsigned long long)q->min_ns, (unsigned long long)q->median_ns,
+              q->matches ? (double)q->min_ns / (double)q->matches : 0.0,
+              r->nodes ? (double)q->min_ns / (double)r->nodes : 0.0);
+    }
+    if (r->has_utf16) {
+      const Utf16Result *u = &r->utf16;
+      fprintf(out,
+              ",\n     \"utf16\": {\"bytes\": %zu, \"min_ns\": %llu, \"median_ns\": %llu, \"slowdown\": %.3f, "
+              "\"matches_utf8\": %s",
+              u->bytes, (unsigned long long)u->min_ns, (unsigned long long)u->median_ns,
+              r->min_ns ? (double)u->min_ns / (double)r->min_ns : 0.0, u->mismatch == UINT32_MAX ? "true" : "false");
+      if (u->mismatch != UINT32_MAX) fprintf(out, ", \"first_mismatch\": %u", u->mismatch);
+      fprintf(out, "}");
+    }
+#ifdef TREE_SITTER_AHK_STATS
+    fprintf(out, ",\n     \"scanner\": {");
+    for (int t = 0; t < TREE_SITTER_AUTOHOTKEY_EXTERNAL_TOKEN_COUNT; t++) {
+      const TSAutohotkeyTokenStats *ts = &r->scanner[t];
+      fprintf(out, "%s\n       ", t ? "," : "");
+      write_json_string(out, tree_sitter_autohotkey_scanner_token_name((uint32_t)t));
+      fprintf(out, ": {\"probes\": %llu, \"hits\": %llu, \"advanced\": %llu, \"discarded\": %llu}",
+              (unsigned long long)ts->probes, (unsigned long long)ts->hits, (unsigned long long)ts->advanced,
+              (unsigned long long)ts->discarded);
+    }
+    fprintf(out, "}");
+#endif
+    fprintf(out, "}%s\n", i + 1 < count ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [--min-bytes N] [--iterations N] [--glr] [--query FILE] [--utf16] [--output PATH] FILE...\n",
+          argv0);
+}
+
+int main(int argc, char **argv) {
+  size_t min_bytes = DEFAULT_MIN_BYTES;
+  int iterations = DEFAULT_ITERATIONS;
+  const char *output = NULL;
+  const char *query_path = NULL;
+  bool glr = false;
+  bool utf16 = false;
+  int first_input = argc;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--min-bytes") == 0 && i + 1 < argc) {
+      min_bytes = (size_t)strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      iterations = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--glr") == 0) {
+      glr = true;
+    } else if (strcmp(argv[i], "--query") == 0 && i + 1 < argc) {
+      query_path = argv[++i];
+    } else if (strcmp(argv[i], "--utf16") == 0) {
+      utf16 = true;
+    } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+      usage(argv[0]);
+      return 2;
+    } else {
+      first_input = i;
+      break;
+    }
+  }
+
+  if (first_input >= argc || iterations < 1) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  ts_set_allocator(counting_malloc, counting_calloc, counting_realloc, counting_free);
+
+  TSQuery *query = NULL;
+  if (query_path && !(query = load_query(query_path))) return 1;
+
+  int count = argc - first_input;
+  ParseResult *results = calloc((size_t)count, sizeof(ParseResult));
+  bool mismatched = false;
+  for (int i = 0; i < count; i++) {
+    const char *path = argv[first_input + i];
+    Buffer input = {0};
+    if (!load_input(path, min_bytes, &input)) return 1;
+
+    results[i].name = basename_of(path);
+    bench_parse(&input, iterations, query, utf16, &results[i]);
+    if (glr) {
+      measure_glr(&input, &results[i].glr);
+      results[i].has_glr = true;
+    }
+    fprintf(stderr, "%-40s %8.2f MB/s\n", results[i].name,
+            (double)results[i].bytes / 1e6 / ((double)results[i].min_ns / 1e9));
+    if (results[i].has_utf16 && results[i].utf16.mismatch != UINT32_MAX) {
+      fprintf(stderr, "%s: UTF-16 tree differs from UTF-8 at byte %u\n", results[i].name, results[i].utf16.mismatch);
+      mismatched = true;
+    }
+    free(input.data);
+  }
+
+  FILE *out = output ? fopen(output, "w") : stdout;
+  if (!out) {
+    fprintf(stderr, "%s: %s\n", output, strerror(errno));
+    return 1;
+  }
+  write_results(out, results, count, iterations, min_bytes);
+  if (output) fclose(out);
+
+  if (query) ts_query_delete(query);
+  free(results);
+  return mismatched ? 1 : 0;
+}
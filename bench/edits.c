@@ -0,0 +1,350 @@
+// Incremental-reparse benchmark for the AutoHotkey grammar.
+//
+// Replays editor-like sessions against each input: a random line is picked and text is typed into it one keystroke at
+// a time (and, for most scenarios, backspaced out again), with the tree edited and reparsed incrementally after every
+// keystroke, as an editor integration would. Inputs are loaded as for the parse benchmark and repeated up to
+// --min-bytes. For every scenario the report has the reparse time per keystroke (median, 95th percentile and
+// maximum, next to a full parse of the same input), how many bytes the reparse lexed again rather than reused, and how
+// many bytes ts_tree_get_changed_ranges reported as changed.
+//
+// The re-lexed bytes are what the scanner's lookahead decides: tree-sitter only reuses a token, and the subtrees that
+// end in it, if the edit lies outside every character the lexer looked at to produce it. They are counted from the
+// runtime's "lexed_lookahead" log lines, on a second parse of the same edit that is not timed.
+//
+// Usage: tree-sitter-autohotkey-edits [--min-bytes N] [--edits N] [--seed N] [--output PATH] FILE...
+//
+// Built and run by the `bench-edits` CMake target when the tree-sitter runtime library is available.
+
+#include <tree_sitter/api.h>
+#include <tree_sitter/tree-sitter-autohotkey.h>
+
+#include "support.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_MIN_BYTES (1u << 20)
+#define DEFAULT_EDITS 1000
+#define DEFAULT_SEED 1
+#define FULL_PARSES 3
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Scenarios. Each session types `text` at the start or the end of a random non-blank line, then deletes it again
+// keystroke by keystroke if `undo` is set. Every scenario gets an equal share of the --edits keystrokes, in as many
+// sessions as that takes.
+
+typedef struct {
+  const char *name;
+  const char *text;
+  bool at_line_end;
+  bool undo;
+} Scenario;
+
+static const Scenario SCENARIOS[] = {
+  {"new-statement", "x := Foo(a, b)\n", false, false},
+  {"append-argument", ", extra", true, true},
+  {"line-comment", "; ", false, true},
+  {"open-paren", "Foo(", false, true},
+  {"open-string", " \"abc", true, true},
+  {"hotkey", "^!k::", false, true},
+  {"block-comment", "/*", false, true},
+};
+
+#define SCENARIO_COUNT (sizeof(SCENARIOS) / sizeof(SCENARIOS[0]))
+
+/// xorshift64*, so runs with the same --seed replay the same edits on every platform
+static uint64_t next_random(uint64_t *state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 0x2545F4914F6CDD1DULL;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Re-lexed bytes. The runtime logs "lexed_lookahead sym:NAME, size:N" for every token it lexes rather than reuses.
+
+static void relex_log(void *payload, TSLogType type, const char *message) {
+  (void)type;
+  if (strncmp(message, "lexed_lookahead sym:", 20) != 0) return;
+  const char *size = NULL;
+  for (const char *p = strstr(message, ", size:"); p; p = strstr(p + 1, ", size:")) size = p;
+  if (size) *(uint64_t *)payload += strtoull(size + 7, NULL, 10);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Sessions
+
+typedef struct {
+  uint64_t *reparse_ns;  ///< one per keystroke
+  uint64_t keystrokes;
+  uint64_t relexed_bytes;
+  uint64_t changed_bytes;
+  uint64_t file_bytes;   ///< sum of the file's size at every keystroke, for the reuse ratio
+} ScenarioStats;
+
+typedef struct {
+  TSParser *parser;
+  Buffer text;
+  TSTree *tree;
+  uint64_t random;
+} Session;
+
+/// Byte offset of the start of every line in the text, and how many there are
+static size_t *line_starts(const Buffer *text, size_t *count) {
+  size_t cap = 1024, n = 0;
+  size_t *starts = malloc(cap * sizeof(size_t));
+  for (size_t i = 0; i <= text->len && starts; i++) {
+    if (i > 0 && text->data[i - 1] != '\n') continue;
+    if (n == cap) {
+      size_t *grown = realloc(starts, (cap *= 2) * sizeof(size_t));
+      if (!grown) free(starts);
+      starts = grown;
+      if (!starts) break;
+    }
+    starts[n++] = i;
+  }
+  if (!starts) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  *count = n;
+  return starts;
+}
+
+/// Applies `edit` to the tree, reparses, and charges the keystroke to `stats`
+static void reparse(Session *s, const TSInputEdit *edit, ScenarioStats *stats) {
+  ts_tree_edit(s->tree, edit);
+
+  uint64_t start = now_ns();
+  TSTree *tree = ts_parser_parse_string(s->parser, s->tree, s->text.data, (uint32_t)s->text.len);
+  uint64_t elapsed = now_ns() - start;
+
+  uint64_t relexed = 0;
+  ts_parser_set_logger(s->parser, (TSLogger){.payload = &relexed, .log = relex_log});
+  ts_tree_delete(ts_parser_parse_string(s->parser, s->tree, s->text.data, (uint32_t)s->text.len));
+  ts_parser_set_logger(s->parser, (TSLogger){0});
+
+  uint32_t range_count;
+  TSRange *ranges = ts_tree_get_changed_ranges(s->tree, tree, &range_count);
+  for (uint32_t i = 0; i < range_count; i++) stats->changed_bytes += ranges[i].end_byte - ranges[i].start_byte;
+  free(ranges);
+
+  ts_tree_delete(s->tree);
+  s->tree = tree;
+  stats->reparse_ns[stats->keystrokes++] = elapsed;
+  stats->relexed_bytes += relexed;
+  stats->file_bytes += s->text.len;
+}
+
+static TSPoint advance_point(TSPoint point, char c) {
+  if (c == '\n') return (TSPoint){point.row + 1, 0};
+  return (TSPoint){point.row, point.column + 1};
+}
+
+/// Runs one session of `scenario`, stopping early once `stats` has `limit` keystrokes
+static void run_session(Session *s, const Scenario *scenario, ScenarioStats *stats, uint64_t limit) {
+  size_t line_count;
+  size_t *starts = line_starts(&s->text, &line_count);
+  size_t line, offset;
+  for (int attempt = 0;; attempt++) {
+    line = (size_t)(next_random(&s->random) % (line_count > 1 ? line_count - 1 : 1));
+    offset = starts[line];
+    // Blank lines are skipped (a few times at most, for inputs that are mostly blank)
+    if (attempt == 8 || s->text.data[offset] != '\n') break;
+  }
+  if (scenario->at_line_end) {
+    while (offset < s->text.len && s->text.data[offset] != '\n') offset++;
+    if (offset > starts[line] && s->text.data[offset - 1] == '\r') offset--;
+  }
+  TSPoint point = {(uint32_t)line, (uint32_t)(offset - starts[line])};
+  free(starts);
+
+  size_t len = strlen(scenario->text);
+  TSPoint *points = malloc((len + 1) * sizeof(TSPoint));  // points[i] is where the i-th character was typed
+  size_t typed = 0;
+  for (; typed < len && stats->keystrokes < limit; typed++) {
+    char c = scenario->text[typed];
+    points[typed] = point;
+    buffer_insert(&s->text, offset + typed, &c, 1);
+    TSPoint end = advance_point(point, c);
+    TSInputEdit edit = {(uint32_t)(offset + typed), (uint32_t)(offset + typed), (uint32_t)(offset + typed + 1),
+                        point, point, end};
+    reparse(s, &edit, stats);
+    point = end;
+  }
+  points[typed] = point;
+
+  for (size_t i = typed; scenario->undo && i > 0 && stats->keystrokes < limit; i--) {
+    buffer_erase(&s->text, offset + i - 1, 1);
+    TSInputEdit edit = {(uint32_t)(offset + i - 1), (uint32_t)(offset + i), (uint32_t)(offset + i - 1),
+                        points[i - 1], points[i], points[i - 1]};
+    reparse(s, &edit, stats);
+  }
+  free(points);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Results
+
+typedef struct {
+  const char *name;
+  size_t bytes;
+  uint64_t full_parse_ns;
+  ScenarioStats scenarios[SCENARIO_COUNT];
+} FileResult;
+
+/// Fastest of FULL_PARSES parses of the input from scratch
+static uint64_t time_full_parse(TSParser *parser, const Buffer *input) {
+  uint64_t best = UINT64_MAX;
+  for (int i = 0; i < FULL_PARSES; i++) {
+    uint64_t start = now_ns();
+    TSTree *tree = ts_parser_parse_string(parser, NULL, input->data, (uint32_t)input->len);
+    uint64_t elapsed = now_ns() - start;
+    ts_tree_delete(tree);
+    if (elapsed < best) best = elapsed;
+  }
+  return best;
+}
+
+static bool bench_edits(const Buffer *input, uint64_t edits, uint64_t seed, FileResult *result) {
+  Session s = {.parser = ts_parser_new(), .random = seed ? seed : DEFAULT_SEED};
+  ts_parser_set_language(s.parser, tree_sitter_autohotkey());
+  result->bytes = input->len;
+  result->full_parse_ns = time_full_parse(s.parser, input);
+
+  buffer_append(&s.text, input->data, input->len);
+  s.tree = ts_parser_parse_string(s.parser, NULL, s.text.data, (uint32_t)s.text.len);
+  if (!s.tree) {
+    ts_parser_delete(s.parser);
+    free(s.text.data);
+    return false;
+  }
+
+  uint64_t share = edits / SCENARIO_COUNT + 1;
+  for (size_t i = 0; i < SCENARIO_COUNT; i++) {
+    ScenarioStats *stats = &result->scenarios[i];
+    stats->reparse_ns = calloc(share, sizeof(uint64_t));
+    while (stats->keystrokes < share) run_session(&s, &SCENARIOS[i], stats, share);
+  }
+
+  ts_tree_delete(s.tree);
+  ts_parser_delete(s.parser);
+  free(s.text.data);
+  return true;
+}
+
+/// Value at `fraction` through the sorted samples
+static uint64_t percentile(const uint64_t *sorted, uint64_t count, double fraction) {
+  uint64_t i = (uint64_t)(fraction * (double)(count - 1) + 0.5);
+  return sorted[i < count ? i : count - 1];
+}
+
+static void write_results(FILE *out, FileResult *results, int count) {
+  fprintf(out, "{\n  \"schema\": 1,\n  \"files\": [\n");
+  for (int i = 0; i < count; i++) {
+    FileResult *r = &results[i];
+    fprintf(out, "    {\"name\": \"%s\", \"bytes\": %zu, \"full_parse_ns\": %llu,\n     \"scenarios\": [\n", r->name,
+            r->bytes, (unsigned long long)r->full_parse_ns);
+    for (size_t j = 0; j < SCENARIO_COUNT; j++) {
+      ScenarioStats *s = &r->scenarios[j];
+      qsort(s->reparse_ns, s->keystrokes, sizeof(uint64_t), compare_u64);
+      fprintf(out,
+              "       {\"name\": \"%s\", \"keystrokes\": %llu, \"median_ns\": %llu, \"p95_ns\": %llu, "
+              "\"max_ns\": %llu, \"relexed_bytes_mean\": %.1f, \"reused_fraction\": %.6f, "
+              "\"changed_bytes_mean\": %.1f}%s\n",
+              SCENARIOS[j].name, (unsigned long long)s->keystrokes,
+              (unsigned long long)percentile(s->reparse_ns, s->keystrokes, 0.5),
+              (unsigned long long)percentile(s->reparse_ns, s->keystrokes, 0.95),
+              (unsigned long long)s->reparse_ns[s->keystrokes - 1],
+              (double)s->relexed_bytes / (double)s->keystrokes,
+              1.0 - (double)s->relexed_bytes / (double)(s->file_bytes ? s->file_bytes : 1),
+              (double)s->changed_bytes / (double)s->keystrokes, j + 1 < SCENARIO_COUNT ? "," : "");
+    }
+    fprintf(out, "     ]}%s\n", i + 1 < count ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+static void print_summary(const FileResult *results, int count) {
+  for (int i = 0; i < count; i++) {
+    const FileResult *r = &results[i];
+    fprintf(stderr, "%s: %zu bytes, full parse %.2f ms\n", r->name, r->bytes, (double)r->full_parse_ns / 1e6);
+    for (size_t j = 0; j < SCENARIO_COUNT; j++) {
+      const ScenarioStats *s = &r->scenarios[j];
+      fprintf(stderr, "  %-16s median %9.1f us  p95 %9.1f us  relexed %10.1f bytes/keystroke\n", SCENARIOS[j].name,
+              (double)percentile(s->reparse_ns, s->keystrokes, 0.5) / 1e3,
+              (double)percentile(s->reparse_ns, s->keystrokes, 0.95) / 1e3,
+              (double)s->relexed_bytes / (double)s->keystrokes);
+    }
+  }
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr, "usage: %s [--min-bytes N] [--edits N] [--seed N] [--output PATH] FILE...\n", argv0);
+}
+
+int main(int argc, char **argv) {
+  size_t min_bytes = DEFAULT_MIN_BYTES;
+  uint64_t edits = DEFAULT_EDITS;
+  uint64_t seed = DEFAULT_SEED;
+  const char *output = NULL;
+  int first_file = argc;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--min-bytes") == 0 && i + 1 < argc) {
+      min_bytes = strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--edits") == 0 && i + 1 < argc) {
+      edits = strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+      usage(argv[0]);
+      return 2;
+    } else {
+      first_file = i;
+      break;
+    }
+  }
+  if (first_file >= argc) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  int count = argc - first_file;
+  FileResult *results = calloc((size_t)count, sizeof(FileResult));
+  for (int i = 0; i < count; i++) {
+    results[i].name = argv[first_file + i];
+    Buffer input = {0};
+    if (!load_input(results[i].name, min_bytes, &input)) return 1;
+    if (input.len > UINT32_MAX / 2) {
+      fprintf(stderr, "%s: input too large\n", results[i].name);
+      return 1;
+    }
+    if (!bench_edits(&input, edits, seed, &results[i])) {
+      fprintf(stderr, "%s: parse failed\n", results[i].name);
+      return 1;
+    }
+    free(input.data);
+  }
+
+  FILE *out = output ? fopen(output, "w") : stdout;
+  if (!out) {
+    fprintf(stderr, "%s: %s\n", output, strerror(errno));
+    return 1;
+  }
+  write_results(out, results, count);
+  if (output) fclose(out);
+  print_summary(results, count);
+
+  for (int i = 0; i < count; i++) {
+    for (size_t j = 0; j < SCENARIO_COUNT; j++) free(results[i].scenarios[j].reparse_ns);
+  }
+  free(results);
+  return 0;
+}
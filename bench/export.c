@@ -0,0 +1,286 @@
+// Export benchmark: tree_sitter_autohotkey_export (tree-sitter-autohotkey-export.h) against ts_node_string, the
+// S-expression the bindings hand out otherwise, on the same trees.
+//
+// Each input is loaded as in bench.c (a corpus file from test/corpus contributes the source of every test in it),
+// repeated until it's at least --min-bytes long and parsed once. Then the tree is exported --iterations times into a
+// buffer allocated once, and turned into an S-expression --iterations times; both sizes are reported with the times.
+//
+// The last export is checked against a separate cursor walk of the tree: every record's type, field, flags and byte
+// range, and the parent, first child, next sibling and subtree end links between them. A mismatch fails the run.
+//
+// Usage: tree-sitter-autohotkey-export-bench [--min-bytes N] [--iterations N] [--output PATH] [--dump PATH] FILE...
+//
+// --dump writes the last input's export to PATH, for trying out readers that map it. Built and run by the
+// `bench-export` CMake target when the tree-sitter runtime library is available.
+
+#include <tree_sitter/api.h>
+#include <tree_sitter/tree-sitter-autohotkey-export.h>
+#include <tree_sitter/tree-sitter-autohotkey.h>
+
+#include "support.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_ITERATIONS 10
+#define NONE TREE_SITTER_AUTOHOTKEY_EXPORT_NONE
+
+typedef struct {
+  const char *path;
+  size_t bytes;
+  uint32_t nodes;
+  uint64_t parse_ns;
+  size_t export_size;
+  uint64_t export_min_ns;
+  uint64_t export_median_ns;
+  size_t sexp_size;
+  uint64_t sexp_min_ns;
+  uint64_t sexp_median_ns;
+} Result;
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Checking
+
+/// Walks the tree again, comparing each node with its record and the links between records. Reports the first
+/// mismatch on stderr.
+static bool check_export(TSNode root, const void *buffer, size_t size) {
+  const TSAutohotkeyExportHeader *header = buffer;
+  if (size < sizeof(*header) || memcmp(header->magic, TREE_SITTER_AUTOHOTKEY_EXPORT_MAGIC, 8) != 0 ||
+      header->version != TREE_SITTER_AUTOHOTKEY_EXPORT_VERSION || header->total_size != size ||
+      header->node_count != ts_node_descendant_count(root)) {
+    fprintf(stderr, "export header doesn't match the tree\n");
+    return false;
+  }
+  const TSAutohotkeyExportNode *nodes =
+      (const TSAutohotkeyExportNode *)((const uint8_t *)buffer + header->nodes_offset);
+  const uint32_t *offsets = (const uint32_t *)((const uint8_t *)buffer + header->strings_offset);
+  const char *names = (const char *)(offsets + header->symbol_count + header->field_count + 2);
+
+  // Indices of the nodes on the path from the root, and each one's last child seen so far
+  uint32_t path[1024], last[1024];
+  uint32_t depth = 0, n = 0;
+  bool ok = true;
+  TSTreeCursor cursor = ts_tree_cursor_new(root);
+  for (;;) {
+    if (n == header->node_count) {
+      fprintf(stderr, "export has fewer records than the tree has nodes\n");
+      ok = false;
+      break;
+    }
+    TSNode node = ts_tree_cursor_current_node(&cursor);
+    const TSAutohotkeyExportNode *record = &nodes[n];
+    uint32_t parent = depth ? path[depth - 1] : NONE;
+    uint16_t flags = (ts_node_is_named(node) ? TSAutohotkeyExportNamed : 0) |
+                     (ts_node_is_error(node) ? TSAutohotkeyExportError : 0) |
+                     (ts_node_is_missing(node) ? TSAutohotkeyExportMissing : 0) |
+                     (ts_node_is_extra(node) ? TSAutohotkeyExportExtra : 0) |
+                     (ts_node_has_error(node) ? TSAutohotkeyExportHasError : 0);
+    if (strcmp(names + offsets[record->symbol], ts_node_type(node)) != 0 ||
+        record->field != ts_tree_cursor_current_field_id(&cursor) || record->flags != flags ||
+        record->start_byte != ts_node_start_byte(node) || record->end_byte != ts_node_end_byte(node) ||
+        record->parent != parent || (depth && last[depth - 1] == NONE && nodes[parent].first_child != n) ||
+        (depth && last[depth - 1] != NONE && nodes[last[depth - 1]].next_sibling != n)) {
+      fprintf(stderr, "export record %u (%s at byte %u) doesn't match the tree\n", n, ts_node_type(node),
+              ts_node_start_byte(node));
+      ok = false;
+      break;
+    }
+    if (depth) last[depth - 1] = n;
+    if (depth == sizeof(path) / sizeof(path[0])) {
+      fprintf(stderr, "tree is too deep to check\n");
+      ok = false;
+      break;
+    }
+    path[depth] = n++;
+    last[depth] = NONE;
+
+    if (ts_tree_cursor_goto_first_child(&cursor)) {
+      depth++;
+      continue;
+    }
+    bool done = false;
+    for (;;) {
+      const TSAutohotkeyExportNode *closed = &nodes[path[depth]];
+      if (closed->subtree_end != n || (last[depth] == NONE && closed->first_child != NONE) ||
+          (last[depth] != NONE && nodes[last[depth]].next_sibling != NONE)) {
+        fprintf(stderr, "export record %u has the wrong children\n", path[depth]);
+        ok = false;
+        done = true;
+        break;
+      }
+      if (ts_tree_cursor_goto_next_sibling(&cursor)) break;
+      if (depth == 0 || !ts_tree_cursor_goto_parent(&cursor)) {
+        done = true;
+        break;
+      }
+      depth--;
+    }
+    if (done) break;
+  }
+  ts_tree_cursor_delete(&cursor);
+  if (ok && n != header->node_count) {
+    fprintf(stderr, "export has %u records for %u nodes\n", header->node_count, n);
+    ok = false;
+  }
+  return ok;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Timing
+
+static void finish(uint64_t *times, int iterations, uint64_t *min_ns, uint64_t *median_ns) {
+  qsort(times, (size_t)iterations, sizeof(uint64_t), compare_u64);
+  *min_ns = times[0];
+  *median_ns = times[iterations / 2];
+}
+
+/// Benchmarks one input; the last export is left in `*export` (malloc'd) for checking and dumping
+static bool bench_input(TSParser *parser, const char *path, size_t min_bytes, int iterations, Result *result,
+                        void **export) {
+  Buffer script = {0};
+  if (!load_input(path, min_bytes, &script)) return false;
+  result->path = path;
+  result->bytes = script.len;
+
+  uint64_t start = now_ns();
+  TSTree *tree = ts_parser_parse_string(parser, NULL, script.data, (uint32_t)script.len);
+  result->parse_ns = now_ns() - start;
+  free(script.data);
+  TSNode root = ts_tree_root_node(tree);
+  result->nodes = ts_node_descendant_count(root);
+
+  uint64_t *times = malloc(sizeof(uint64_t) * (size_t)iterations);
+  result->export_size = tree_sitter_autohotkey_export(root, NULL, 0);
+  *export = result->export_size ? malloc(result->export_size) : NULL;
+  if (!*export || !times) {
+    fprintf(stderr, "%s: can't export the tree\n", path);
+    free(times);
+    ts_tree_delete(tree);
+    return false;
+  }
+  for (int i = 0; i < iterations; i++) {
+    start = now_ns();
+    tree_sitter_autohotkey_export(root, *export, result->export_size);
+    times[i] = now_ns() - start;
+  }
+  finish(times, iterations, &result->export_min_ns, &result->export_median_ns);
+
+  for (int i = 0; i < iterations; i++) {
+    start = now_ns();
+    char *sexp = ts_node_string(root);
+    times[i] = now_ns() - start;
+    result->sexp_size = strlen(sexp);
+    free(sexp);
+  }
+  finish(times, iterations, &result->sexp_min_ns, &result->sexp_median_ns);
+  free(times);
+
+  bool ok = check_export(root, *export, result->export_size);
+  ts_tree_delete(tree);
+  return ok;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Output
+
+static double mb_per_s(size_t bytes, uint64_t ns) { return ns ? (double)bytes / 1e6 / ((double)ns / 1e9) : 0.0; }
+
+static void write_results(FILE *out, const Result *results, int count) {
+  fprintf(out, "{\n  \"schema\": 1,\n  \"inputs\": [\n");
+  for (int i = 0; i < count; i++) {
+    const Result *r = &results[i];
+    fprintf(out, "    {\"path\": \"%s\", \"bytes\": %zu, \"nodes\": %u, \"parse_ns\": %llu,\n", r->path, r->bytes,
+            r->nodes, (unsigned long long)r->parse_ns);
+    fprintf(out, "     \"export\": {\"size\": %zu, \"bytes_per_node\": %.1f, \"min_ns\": %llu, \"median_ns\": %llu, "
+                 "\"mb_per_s\": %.3f},\n",
+            r->export_size, r->nodes ? (double)r->export_size / r->nodes : 0.0, (unsigned long long)r->export_min_ns,
+            (unsigned long long)r->export_median_ns, mb_per_s(r->bytes, r->export_min_ns));
+    fprintf(out, "     \"sexp\": {\"size\": %zu, \"bytes_per_node\": %.1f, \"min_ns\": %llu, \"median_ns\": %llu, "
+                 "\"mb_per_s\": %.3f},\n",
+            r->sexp_size, r->nodes ? (double)r->sexp_size / r->nodes : 0.0, (unsigned long long)r->sexp_min_ns,
+            (unsigned long long)r->sexp_median_ns, mb_per_s(r->bytes, r->sexp_min_ns));
+    fprintf(out, "     \"speedup\": %.3f}%s\n",
+            r->export_min_ns ? (double)r->sexp_min_ns / (double)r->export_min_ns : 0.0, i + 1 < count ? "," : "");
+
+    fprintf(stderr, "%s: %zu bytes, %u nodes: parse %.2f ms, export %.3f ms (%zu bytes), sexp %.3f ms (%zu bytes)\n",
+            r->path, r->bytes, r->nodes, (double)r->parse_ns / 1e6, (double)r->export_min_ns / 1e6, r->export_size,
+            (double)r->sexp_min_ns / 1e6, r->sexp_size);
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr, "usage: %s [--min-bytes N] [--iterations N] [--output PATH] [--dump PATH] FILE...\n", argv0);
+}
+
+int main(int argc, char **argv) {
+  size_t min_bytes = 0;
+  int iterations = DEFAULT_ITERATIONS;
+  const char *output = NULL;
+  const char *dump = NULL;
+  int first_input = argc;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--min-bytes") == 0 && i + 1 < argc) {
+      min_bytes = (size_t)strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      iterations = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    } else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+      dump = argv[++i];
+    } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+      usage(argv[0]);
+      return 2;
+    } else {
+      first_input = i;
+      break;
+    }
+  }
+
+  if (first_input >= argc || iterations < 1) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_autohotkey());
+  int count = argc - first_input;
+  Result *results = calloc((size_t)count, sizeof(Result));
+  void *export = NULL;
+  int status = 0;
+  for (int i = 0; i < count && status == 0; i++) {
+    free(export);
+    export = NULL;
+    if (!bench_input(parser, argv[first_input + i], min_bytes, iterations, &results[i], &export)) status = 1;
+  }
+
+  if (status == 0 && dump) {
+    FILE *f = fopen(dump, "wb");
+    if (!f || fwrite(export, 1, results[count - 1].export_size, f) != results[count - 1].export_size) {
+      fprintf(stderr, "%s: %s\n", dump, strerror(errno));
+      status = 1;
+    }
+    if (f) fclose(f);
+  }
+
+  if (status == 0) {
+    FILE *out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+      fprintf(stderr, "%s: %s\n", output, strerror(errno));
+      status = 1;
+    } else {
+      write_results(out, results, count);
+      if (output) fclose(out);
+    }
+  }
+
+  free(export);
+  free(results);
+  ts_parser_delete(parser);
+  return status;
+}
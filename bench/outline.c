@@ -0,0 +1,287 @@
+// Outline benchmark: tree_sitter_autohotkey_outline (tree-sitter-autohotkey-outline.h) against the same outline
+// found by running queries/outline.scm over the whole tree, on a keymap-like script of hotkeys, hotstrings, remaps,
+// #HotIf sections, functions and classes.
+//
+// The inputs are joined into one script (a corpus file from test/corpus contributes the source of every test in it,
+// as in bench.c), which is repeated until it's at least --min-bytes long. It's parsed --iterations times, and then the
+// outline is taken from the last tree --iterations times each way. The parse is reported too: neither way of reading
+// the outline makes it any cheaper, so it's the floor under a tool's cost per file.
+//
+// Every item the walk reports must also be one of the query's @item captures, or the run fails. The query finds more
+// when functions are declared inside other bodies, where the walk doesn't look.
+//
+// Usage: tree-sitter-autohotkey-outline-bench [--min-bytes N] [--iterations N] [--query FILE] [--output PATH] FILE...
+//
+// Built and run by the `bench-outline` CMake target when the tree-sitter runtime library is available.
+
+#include <tree_sitter/api.h>
+#include <tree_sitter/tree-sitter-autohotkey-outline.h>
+#include <tree_sitter/tree-sitter-autohotkey.h>
+
+#include "support.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_ITERATIONS 10
+
+typedef struct {
+  uint64_t min_ns;
+  uint64_t median_ns;
+  uint64_t items;
+} Timing;
+
+/// Start bytes of outline items, in source order
+typedef struct {
+  uint32_t *starts;
+  size_t len;
+  size_t cap;
+} Starts;
+
+static void push_start(Starts *starts, uint32_t start) {
+  if (starts->len == starts->cap) {
+    starts->cap = starts->cap ? starts->cap * 2 : 256;
+    starts->starts = realloc(starts->starts, starts->cap * sizeof(uint32_t));
+    if (!starts->starts) {
+      fprintf(stderr, "out of memory\n");
+      exit(1);
+    }
+  }
+  starts->starts[starts->len++] = start;
+}
+
+static int compare_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+static void finish(uint64_t *times, int iterations, Timing *timing) {
+  qsort(times, (size_t)iterations, sizeof(uint64_t), compare_u64);
+  timing->min_ns = times[0];
+  timing->median_ns = times[iterations / 2];
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Outline walk
+
+typedef struct {
+  uint64_t items;
+  uint64_t kinds[TREE_SITTER_AUTOHOTKEY_OUTLINE_KIND_COUNT];
+  Starts *starts;  ///< collected on one run only
+} OutlineCounts;
+
+static bool count_item(const TSAutohotkeyOutlineItem *item, void *payload) {
+  OutlineCounts *counts = payload;
+  counts->items++;
+  counts->kinds[item->kind]++;
+  if (counts->starts) push_start(counts->starts, ts_node_start_byte(item->node));
+  return true;
+}
+
+static void bench_outline(TSNode root, int iterations, Timing *timing, OutlineCounts *counts, Starts *starts) {
+  uint64_t *times = malloc(sizeof(uint64_t) * (size_t)iterations);
+  for (int i = 0; i < iterations; i++) {
+    OutlineCounts run = {0};
+    uint64_t start = now_ns();
+    tree_sitter_autohotkey_outline(root, count_item, &run);
+    times[i] = now_ns() - start;
+    *counts = run;
+  }
+  finish(times, iterations, timing);
+  timing->items = counts->items;
+  free(times);
+
+  counts->starts = starts;
+  tree_sitter_autohotkey_outline(root, count_item, counts);
+  counts->starts = NULL;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Query walk
+
+static TSQuery *load_query(const char *path) {
+  Buffer source = {0};
+  if (!read_file(path, &source)) return NULL;
+
+  uint32_t error_offset;
+  TSQueryError error;
+  TSQuery *query = ts_query_new(tree_sitter_autohotkey(), source.data ? source.data : "", (uint32_t)source.len,
+                                &error_offset, &error);
+  if (!query) fprintf(stderr, "%s: query error %d at byte %u\n", path, (int)error, error_offset);
+  free(source.data);
+  return query;
+}
+
+/// Index of the @item capture, or -1 if the query has none
+static int item_capture(const TSQuery *query) {
+  for (uint32_t i = 0; i < ts_query_capture_count(query); i++) {
+    uint32_t length;
+    const char *name = ts_query_capture_name_for_id(query, i, &length);
+    if (length == 4 && memcmp(name, "item", 4) == 0) return (int)i;
+  }
+  return -1;
+}
+
+static void bench_query(const TSQuery *query, TSNode root, int iterations, Timing *timing, Starts *starts) {
+  uint64_t *times = malloc(sizeof(uint64_t) * (size_t)iterations);
+  TSQueryCursor *cursor = ts_query_cursor_new();
+  TSQueryMatch match;
+
+  for (int i = 0; i < iterations; i++) {
+    uint64_t matches = 0;
+    uint64_t start = now_ns();
+    ts_query_cursor_exec(cursor, query, root);
+    while (ts_query_cursor_next_match(cursor, &match)) matches++;
+    times[i] = now_ns() - start;
+    timing->items = matches;
+  }
+  finish(times, iterations, timing);
+  free(times);
+
+  int item = item_capture(query);
+  ts_query_cursor_exec(cursor, query, root);
+  while (ts_query_cursor_next_match(cursor, &match)) {
+    for (uint16_t c = 0; c < match.capture_count; c++) {
+      if ((int)match.captures[c].index == item) push_start(starts, ts_node_start_byte(match.captures[c].node));
+    }
+  }
+  ts_query_cursor_delete(cursor);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Output
+
+static double mb_per_s(size_t bytes, uint64_t ns) { return ns ? (double)bytes / 1e6 / ((double)ns / 1e9) : 0.0; }
+
+static void write_results(FILE *out, size_t bytes, uint64_t lines, const Timing *parse, const Timing *outline,
+                          const OutlineCounts *counts, const Timing *query) {
+  fprintf(out, "{\n  \"schema\": 1,\n  \"bytes\": %zu,\n  \"lines\": %llu,\n", bytes, (unsigned long long)lines);
+  fprintf(out, "  \"parse\": {\"min_ns\": %llu, \"median_ns\": %llu, \"mb_per_s\": %.3f},\n",
+          (unsigned long long)parse->min_ns, (unsigned long long)parse->median_ns, mb_per_s(bytes, parse->min_ns));
+  fprintf(out, "  \"outline\": {\"items\": %llu, \"min_ns\": %llu, \"median_ns\": %llu, \"mb_per_s\": %.3f, "
+               "\"kinds\": {",
+          (unsigned long long)outline->items, (unsigned long long)outline->min_ns,
+          (unsigned long long)outline->median_ns, mb_per_s(bytes, outline->min_ns));
+  for (int k = 0; k < TREE_SITTER_AUTOHOTKEY_OUTLINE_KIND_COUNT; k++) {
+    fprintf(out, "%s\"%s\": %llu", k ? ", " : "", tree_sitter_autohotkey_outline_kind_name((TSAutohotkeyOutlineKind)k),
+            (unsigned long long)counts->kinds[k]);
+  }
+  fprintf(out, "}},\n");
+  fprintf(out, "  \"query\": {\"items\": %llu, \"min_ns\": %llu, \"median_ns\": %llu, \"mb_per_s\": %.3f},\n",
+          (unsigned long long)query->items, (unsigned long long)query->min_ns,
+          (unsigned long long)query->median_ns, mb_per_s(bytes, query->min_ns));
+  fprintf(out, "  \"speedup\": %.3f\n}\n", outline->min_ns ? (double)query->min_ns / (double)outline->min_ns : 0.0);
+
+  fprintf(stderr, "%zu bytes, %llu lines: parse %.2f ms, outline %.3f ms (%llu items), query %.3f ms (%llu items)\n",
+          bytes, (unsigned long long)lines, (double)parse->min_ns / 1e6, (double)outline->min_ns / 1e6,
+          (unsigned long long)outline->items, (double)query->min_ns / 1e6, (unsigned long long)query->items);
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr, "usage: %s [--min-bytes N] [--iterations N] [--query FILE] [--output PATH] FILE...\n", argv0);
+}
+
+int main(int argc, char **argv) {
+  size_t min_bytes = 0;
+  int iterations = DEFAULT_ITERATIONS;
+  const char *query_path = "queries/outline.scm";
+  const char *output = NULL;
+  int first_input = argc;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--min-bytes") == 0 && i + 1 < argc) {
+      min_bytes = (size_t)strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      iterations = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--query") == 0 && i + 1 < argc) {
+      query_path = argv[++i];
+    } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+      usage(argv[0]);
+      return 2;
+    } else {
+      first_input = i;
+      break;
+    }
+  }
+
+  if (first_input >= argc || iterations < 1) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  Buffer unit = {0}, script = {0};
+  for (int i = first_input; i < argc; i++) {
+    if (!load_input(argv[i], 0, &unit)) return 1;
+  }
+  do {
+    buffer_append(&script, unit.data, unit.len);
+  } while (script.len < min_bytes);
+  uint64_t lines = 0;
+  for (size_t i = 0; i < script.len; i++) lines += script.data[i] == '\n';
+
+  TSQuery *query = load_query(query_path);
+  if (!query) return 1;
+  if (item_capture(query) < 0) {
+    fprintf(stderr, "%s: no @item capture\n", query_path);
+    return 1;
+  }
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_autohotkey());
+  uint64_t *times = malloc(sizeof(uint64_t) * (size_t)iterations);
+  TSTree *tree = NULL;
+  for (int i = 0; i < iterations; i++) {
+    ts_tree_delete(tree);
+    uint64_t start = now_ns();
+    tree = ts_parser_parse_string(parser, NULL, script.data, (uint32_t)script.len);
+    times[i] = now_ns() - start;
+  }
+  Timing parse = {0};
+  finish(times, iterations, &parse);
+  free(times);
+  TSNode root = ts_tree_root_node(tree);
+
+  Timing outline = {0}, queried = {0};
+  OutlineCounts counts = {0};
+  Starts outline_starts = {0}, query_starts = {0};
+  bench_outline(root, iterations, &outline, &counts, &outline_starts);
+  bench_query(query, root, iterations, &queried, &query_starts);
+
+  // The same node can be captured by more than one pattern, so the query's starts are only used as a set
+  if (query_starts.len) qsort(query_starts.starts, query_starts.len, sizeof(uint32_t), compare_u32);
+  int status = 0;
+  for (size_t i = 0; i < outline_starts.len; i++) {
+    if (!query_starts.len || !bsearch(&outline_starts.starts[i], query_starts.starts, query_starts.len,
+                                      sizeof(uint32_t), compare_u32)) {
+      fprintf(stderr, "outline item at byte %u isn't an @item of %s\n", outline_starts.starts[i], query_path);
+      status = 1;
+      break;
+    }
+  }
+
+  if (status == 0) {
+    FILE *out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+      fprintf(stderr, "%s: %s\n", output, strerror(errno));
+      status = 1;
+    } else {
+      write_results(out, script.len, lines, &parse, &outline, &counts, &queried);
+      if (output) fclose(out);
+    }
+  }
+
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+  ts_query_delete(query);
+  free(outline_starts.starts);
+  free(query_starts.starts);
+  free(unit.data);
+  free(script.data);
+  return status;
+}
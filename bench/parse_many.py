@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""Scaling benchmark for tree_sitter_autohotkey.parse_many.
+
+Parses a set of scripts (the sources of every test/corpus file by default, or the given files and directories) with
+1, 2, 4, ... threads, once on parse_many's native pool and once from as many Python threads each calling parse_many
+with a single worker, and prints throughput and speedup for each. parse_many releases the GIL while parsing, so the
+native pool should scale on any CPython; the Python-thread column also pays for building results under the GIL, which
+only free-threaded builds (python3.13t and later) run in parallel.
+
+Needs a build of the binding with the tree-sitter runtime compiled in (see find_runtime in setup.py):
+
+    TREE_SITTER_RUNTIME_DIR=path/to/tree-sitter/lib pip install -e .
+    python bench/parse_many.py [--repeat N] [--max-threads N] [--sexp] [PATH ...]
+"""
+
+import argparse
+import os
+import sys
+import sysconfig
+import time
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+
+import tree_sitter_autohotkey
+
+ROOT = Path(__file__).resolve().parent.parent
+
+
+def corpus_sources(path):
+    """The source of each test in a corpus file, in the same way bench.c extracts them."""
+    sources, lines, state = [], [], "before"
+    for line in path.read_bytes().splitlines(keepends=True):
+        bare = line.rstrip(b"\r\n")
+        if state in ("before", "expected") and bare.startswith(b"==="):
+            state = "header"
+        elif state == "header" and bare.startswith(b"==="):
+            state, lines = "source", []
+        elif state == "source" and bare.startswith(b"---"):
+            sources.append(b"".join(lines))
+            state = "expected"
+        elif state == "source":
+            lines.append(line)
+    return sources
+
+
+def load(paths):
+    if not paths:
+        return [s for p in sorted((ROOT / "test" / "corpus").glob("*.txt")) for s in corpus_sources(p)]
+    sources = []
+    for p in map(Path, paths):
+        files = sorted(f for f in p.rglob("*") if f.suffix.lower() in (".ahk", ".ah2")) if p.is_dir() else [p]
+        sources += [f.read_bytes() for f in files]
+    return sources
+
+
+def timed(fn):
+    start = time.perf_counter()
+    fn()
+    return time.perf_counter() - start
+
+
+def native(sources, threads, sexp):
+    return timed(lambda: tree_sitter_autohotkey.parse_many(sources, threads, sexp=sexp))
+
+
+def python_threads(sources, threads, sexp):
+    chunks = [sources[i::threads] for i in range(threads)]
+    with ThreadPoolExecutor(threads) as pool:
+        return timed(lambda: list(pool.map(lambda c: tree_sitter_autohotkey.parse_many(c, 1, sexp=sexp), chunks)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("paths", nargs="*", help="scripts or directories of .ahk files (default: the test corpus)")
+    parser.add_argument("--repeat", type=int, default=50, help="how many times to repeat the inputs")
+    parser.add_argument("--max-threads", type=int, default=os.cpu_count() or 1)
+    parser.add_argument("--sexp", action="store_true", help="also build each tree's S-expression")
+    args = parser.parse_args()
+
+    sources = load(args.paths) * args.repeat
+    total = sum(map(len, sources))
+    gil = getattr(sys, "_is_gil_enabled", lambda: True)()
+    print(f"CPython {sys.version.split()[0]}, free-threaded build: {bool(sysconfig.get_config_var('Py_GIL_DISABLED'))}, "
+          f"GIL enabled: {gil}")
+    print(f"{len(sources)} inputs, {total / 1e6:.1f} MB\n")
+
+    tree_sitter_autohotkey.parse_many(sources[:100], 1)  # warm up
+    print(f"{'threads':>7}  {'native MB/s':>11}  {'speedup':>7}  {'py threads MB/s':>15}  {'speedup':>7}")
+    base = None
+    threads = 1
+    while threads <= args.max_threads:
+        n = min(native(sources, threads, args.sexp) for _ in range(3))
+        p = min(python_threads(sources, threads, args.sexp) for _ in range(3))
+        base = base or (n, p)
+        print(f"{threads:>7}  {total / 1e6 / n:>11.1f}  {base[0] / n:>6.2f}x  {total / 1e6 / p:>15.1f}  "
+              f"{base[1] / p:>6.2f}x")
+        threads *= 2
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,508 @@
+// Pathological-input regression suite for the AutoHotkey grammar.
+//
+// Each family below generates an adversarial script (deep nesting, unbalanced brackets, very long lists and lines,
+// unterminated comments and sections) at --steps sizes, doubling from --min-bytes. Every size is parsed --iterations
+// times and the fastest parse counts. The suite fails when, at any family:
+//
+//  - parse time or peak runtime memory grows faster than bytes^--max-exponent between the smallest and largest size
+//    (a linear parse is ~1.0, a quadratic one ~2.0), or
+//  - the largest size costs more than the family's ceiling in nanoseconds or runtime bytes per input byte (scaled by
+//    --budget-scale for slower or faster machines), or
+//  - a parse runs past --timeout seconds. It is cancelled through the parse progress callback; a hang inside the
+//    external scanner, where that callback never runs, is caught by a watchdog on POSIX systems.
+//
+// Usage: tree-sitter-autohotkey-pathological [--min-bytes N] [--steps N] [--iterations N] [--max-exponent X]
+//                                            [--budget-scale X] [--timeout SECONDS] [--input FILE]...
+//                                            [--output PATH] [FAMILY...]
+//
+// Each --input FILE (such as a slow input found by the fuzzer, see test/pathological) adds a family that repeats the
+// file's contents up to each size. With FAMILY arguments only those families run, plus any --input ones. Results are
+// written as one JSON document, like the parse benchmark's.
+// Built and run by the `bench-pathological` CMake target when the tree-sitter runtime library is available.
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L  // alarm
+#endif
+
+#include <tree_sitter/api.h>
+#include <tree_sitter/tree-sitter-autohotkey.h>
+
+#include "support.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+#define DEFAULT_MIN_BYTES (128u << 10)
+#define DEFAULT_STEPS 4
+#define DEFAULT_ITERATIONS 3
+#define DEFAULT_MAX_EXPONENT 1.25
+#define DEFAULT_TIMEOUT 30
+#define MAX_STEPS 12
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Generators. Each appends a script of at least `bytes` bytes to `out`.
+
+static void repeat_until(Buffer *out, size_t bytes, const char *unit) {
+  size_t len = strlen(unit);
+  while (out->len < bytes) buffer_append(out, unit, len);
+}
+
+/// `open` repeated, then `middle`, then as many `close`, for about `bytes` in total
+static void nest(Buffer *out, size_t bytes, const char *prefix, const char *open, const char *middle,
+                 const char *close, const char *suffix) {
+  size_t depth = bytes / (strlen(open) + strlen(close)) + 1;
+  buffer_append(out, prefix, strlen(prefix));
+  for (size_t i = 0; i < depth; i++) buffer_append(out, open, strlen(open));
+  buffer_append(out, middle, strlen(middle));
+  for (size_t i = 0; i < depth; i++) buffer_append(out, close, strlen(close));
+  buffer_append(out, suffix, strlen(suffix));
+}
+
+static void gen_nested_parens(Buffer *out, size_t bytes) { nest(out, bytes, "x := ", "(", "1", ")", "\n"); }
+
+static void gen_nested_arrays(Buffer *out, size_t bytes) { nest(out, bytes, "x := ", "[", "1", "]", "\n"); }
+
+static void gen_nested_blocks(Buffer *out, size_t bytes) { nest(out, bytes, "", "if x {\n", "y()\n", "}\n", ""); }
+
+static void gen_nested_calls(Buffer *out, size_t bytes) { nest(out, bytes, "MsgBox ", "F(", "", ")", "\n"); }
+
+/// Calls missing their closing paren. Every line start probes for a function declaration, which is what
+/// DECL_LOOKAHEAD_MAX_CHARS in the scanner bounds.
+static void gen_unbalanced_parens(Buffer *out, size_t bytes) { repeat_until(out, bytes, "Foo(a, b\n"); }
+
+/// Function heads whose bodies never close
+static void gen_unbalanced_braces(Buffer *out, size_t bytes) { repeat_until(out, bytes, "Foo(a, b) {\n"); }
+
+static void gen_closing_brackets(Buffer *out, size_t bytes) { repeat_until(out, bytes, ")]}\n"); }
+
+static void gen_hotkey_list(Buffer *out, size_t bytes) {
+  static const char keys[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+  char line[64];
+  for (unsigned i = 0; out->len < bytes; i++) {
+    int len = snprintf(line, sizeof(line), "^!%c::Send \"text %u\"\n", keys[i % (sizeof(keys) - 1)], i);
+    buffer_append(out, line, (size_t)len);
+  }
+}
+
+static void gen_hotstring_list(Buffer *out, size_t bytes) {
+  char line[64];
+  for (unsigned i = 0; out->len < bytes; i++) {
+    int len = snprintf(line, sizeof(line), "::abbr%u::expansion number %u\n", i, i);
+    buffer_append(out, line, (size_t)len);
+  }
+}
+
+/// One statement on one line: `x := 1 + a0 + a1 + ...`
+static void gen_long_expression(Buffer *out, size_t bytes) {
+  char term[32];
+  buffer_append(out, "x := 1", 6);
+  for (unsigned i = 0; out->len < bytes; i++) {
+    int len = snprintf(term, sizeof(term), " + a%u", i);
+    buffer_append(out, term, (size_t)len);
+  }
+  buffer_append(out, "\n", 1);
+}
+
+/// Implicit concatenation on one line, so every gap is an IMPLICIT_CONCAT_MARKER probe
+static void gen_long_concat(Buffer *out, size_t bytes) {
+  buffer_append(out, "x := a", 6);
+  repeat_until(out, bytes, " b \"c\"");
+  buffer_append(out, "\n", 1);
+}
+
+/// A call with a very long argument list, on one line
+static void gen_long_arguments(Buffer *out, size_t bytes) {
+  buffer_append(out, "Foo(a", 5);
+  repeat_until(out, bytes, ", a");
+  buffer_append(out, ")\n", 2);
+}
+
+/// A block comment that is never closed, so every probe of it scans to the end of the file
+static void gen_unclosed_comment(Buffer *out, size_t bytes) {
+  buffer_append(out, "/*\n", 3);
+  repeat_until(out, bytes, " * x := Foo(a, b) ; not code\n");
+}
+
+/// A continuation section that is never closed
+static void gen_unclosed_section(Buffer *out, size_t bytes) {
+  buffer_append(out, "x := \"\n(\n", 9);
+  repeat_until(out, bytes, "  <Element attr=\"value\">text</Element>\n");
+}
+
+static void gen_unclosed_strings(Buffer *out, size_t bytes) { repeat_until(out, bytes, "MsgBox(\"abc\n"); }
+
+/// Blank and whitespace-only lines between two statements
+static void gen_blank_lines(Buffer *out, size_t bytes) {
+  buffer_append(out, "x := 1\n", 7);
+  repeat_until(out, bytes, "  \t\n\n");
+  buffer_append(out, "y := 2\n", 7);
+}
+
+typedef struct {
+  const char *name;
+  void (*generate)(Buffer *out, size_t bytes);
+  double ns_per_byte;     ///< time ceiling at the largest size, before --budget-scale
+  double bytes_per_byte;  ///< peak runtime memory ceiling at the largest size, before --budget-scale
+  Buffer unit;            ///< for --input families, the file repeated in place of `generate`
+} Family;
+
+// The ceilings are loose on purpose: they catch a family that became an order of magnitude more expensive, while
+// the exponent check catches one that stopped scaling linearly. Inputs that parse cleanly get tighter ones than those
+// the parser has to recover from.
+static const Family FAMILIES[] = {
+  {"nested-parens", gen_nested_parens, 2000, 1000},
+  {"nested-arrays", gen_nested_arrays, 2000, 1000},
+  {"nested-blocks", gen_nested_blocks, 1000, 500},
+  {"nested-calls", gen_nested_calls, 2000, 1000},
+  {"unbalanced-parens", gen_unbalanced_parens, 10000, 2000},
+  {"unbalanced-braces", gen_unbalanced_braces, 10000, 2000},
+  {"closing-brackets", gen_closing_brackets, 10000, 2000},
+  {"hotkey-list", gen_hotkey_list, 1000, 500},
+  {"hotstring-list", gen_hotstring_list, 1000, 500},
+  {"long-expression", gen_long_expression, 1000, 500},
+  {"long-concat", gen_long_concat, 1000, 500},
+  {"long-arguments", gen_long_arguments, 1000, 500},
+  {"unclosed-comment", gen_unclosed_comment, 10000, 2000},
+  {"unclosed-section", gen_unclosed_section, 10000, 2000},
+  {"unclosed-strings", gen_unclosed_strings, 10000, 2000},
+  {"blank-lines", gen_blank_lines, 1000, 500},
+};
+
+#define FAMILY_COUNT (sizeof(FAMILIES) / sizeof(FAMILIES[0]))
+
+/// Ceilings for --input families, which are usually malformed
+#define INPUT_NS_PER_BYTE 10000
+#define INPUT_BYTES_PER_BYTE 2000
+
+static void generate(const Family *family, Buffer *out, size_t bytes) {
+  if (!family->generate) {
+    repeat_until(out, bytes, family->unit.data);
+  } else {
+    family->generate(out, bytes);
+  }
+}
+
+static const char *basename_of(const char *path) {
+  const char *base = path;
+  for (const char *p = path; *p; p++) {
+    if (*p == '/' || *p == '\\') base = p + 1;
+  }
+  return base;
+}
+
+/// Sets up a family that repeats the file at `path`. A final newline is added if it's missing, so repetitions start
+/// on their own lines; otherwise the file is used as is, NUL bytes aside (they would end the repetition unit).
+static bool load_input_family(const char *path, Family *family) {
+  memset(family, 0, sizeof(*family));
+  if (!read_file(path, &family->unit)) return false;
+  if (family->unit.len == 0 || strlen(family->unit.data) != family->unit.len) {
+    fprintf(stderr, "%s: empty or contains NUL bytes\n", path);
+    return false;
+  }
+  if (family->unit.data[family->unit.len - 1] != '\n') buffer_append(&family->unit, "\n", 1);
+  family->name = basename_of(path);
+  family->ns_per_byte = INPUT_NS_PER_BYTE;
+  family->bytes_per_byte = INPUT_BYTES_PER_BYTE;
+  return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Parsing under a deadline
+
+typedef struct {
+  const Buffer *input;
+  uint64_t deadline_ns;
+  uint32_t calls;
+  bool timed_out;
+} ParseContext;
+
+static const char *read_input(void *payload, uint32_t byte_index, TSPoint position, uint32_t *bytes_read) {
+  (void)position;
+  const Buffer *input = ((const ParseContext *)payload)->input;
+  if (byte_index >= input->len) {
+    *bytes_read = 0;
+    return "";
+  }
+  *bytes_read = (uint32_t)(input->len - byte_index);
+  return input->data + byte_index;
+}
+
+static bool past_deadline(TSParseState *state) {
+  ParseContext *context = state->payload;
+  // The callback runs very often; only look at the clock now and then
+  if (++context->calls % 256 != 0) return false;
+  if (now_ns() < context->deadline_ns) return false;
+  context->timed_out = true;
+  return true;
+}
+
+#ifndef _WIN32
+static const char *watchdog_family;
+
+static void watchdog_fired(int signal) {
+  (void)signal;
+  static const char message[] = "timed out inside the scanner (the parse stopped reaching its progress callback): ";
+  ssize_t ignored = write(STDERR_FILENO, message, sizeof(message) - 1);
+  ignored = write(STDERR_FILENO, watchdog_family, strlen(watchdog_family));
+  ignored = write(STDERR_FILENO, "\n", 1);
+  (void)ignored;
+  _exit(1);
+}
+#endif
+
+typedef struct {
+  size_t bytes;
+  uint64_t min_ns;
+  size_t peak_bytes;
+  uint32_t nodes;
+  bool has_error;
+  bool timed_out;
+} Step;
+
+static void parse_step(TSParser *parser, const Buffer *input, int iterations, unsigned timeout, Step *step) {
+  step->bytes = input->len;
+  step->min_ns = UINT64_MAX;
+  for (int i = 0; i < iterations && !step->timed_out; i++) {
+    ParseContext context = {.input = input};
+    TSInput source = {.payload = &context, .read = read_input, .encoding = TSInputEncodingUTF8};
+    TSParseOptions options = {.payload = &context, .progress_callback = past_deadline};
+
+    size_t baseline = alloc_stats.current;
+    alloc_stats.peak = baseline;
+    uint64_t start = now_ns();
+    context.deadline_ns = start + (uint64_t)timeout * 1000000000u;
+    TSTree *tree = ts_parser_parse_with_options(parser, NULL, source, options);
+    uint64_t elapsed = now_ns() - start;
+
+    if (!tree) {
+      step->timed_out = context.timed_out;
+      if (!context.timed_out) {
+        fprintf(stderr, "parse failed\n");
+        exit(1);
+      }
+      ts_parser_reset(parser);
+      break;
+    }
+    if (elapsed < step->min_ns) step->min_ns = elapsed;
+    if (alloc_stats.peak - baseline > step->peak_bytes) step->peak_bytes = alloc_stats.peak - baseline;
+    TSNode root = ts_tree_root_node(tree);
+    step->nodes = ts_node_descendant_count(root);
+    step->has_error = ts_node_has_error(root);
+    ts_tree_delete(tree);
+  }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Checks
+
+typedef struct {
+  const Family *family;
+  Step steps[MAX_STEPS];
+  int step_count;
+  double time_exponent;
+  double memory_exponent;
+  double ns_per_byte;
+  double bytes_per_byte;
+  char failure[160];  ///< empty if the family passed
+} FamilyResult;
+
+static double growth_exponent(double small, double large, double small_bytes, double large_bytes) {
+  if (small <= 0 || large <= 0 || large_bytes <= small_bytes) return 0;
+  return log(large / small) / log(large_bytes / small_bytes);
+}
+
+static void check_family(FamilyResult *r, double max_exponent, double budget_scale) {
+  const Step *first = &r->steps[0], *last = &r->steps[r->step_count - 1];
+  for (int i = 0; i < r->step_count; i++) {
+    if (r->steps[i].timed_out) {
+      snprintf(r->failure, sizeof(r->failure), "timed out at %zu bytes", r->steps[i].bytes);
+      return;
+    }
+  }
+
+  r->time_exponent = growth_exponent((double)first->min_ns, (double)last->min_ns, (double)first->bytes,
+                                     (double)last->bytes);
+  r->memory_exponent = growth_exponent((double)first->peak_bytes, (double)last->peak_bytes, (double)first->bytes,
+                                       (double)last->bytes);
+  r->ns_per_byte = (double)last->min_ns / (double)last->bytes;
+  r->bytes_per_byte = (double)last->peak_bytes / (double)last->bytes;
+
+  if (r->time_exponent > max_exponent) {
+    snprintf(r->failure, sizeof(r->failure), "time grows as bytes^%.2f (limit %.2f)", r->time_exponent, max_exponent);
+  } else if (r->memory_exponent > max_exponent) {
+    snprintf(r->failure, sizeof(r->failure), "memory grows as bytes^%.2f (limit %.2f)", r->memory_exponent,
+             max_exponent);
+  } else if (r->ns_per_byte > r->family->ns_per_byte * budget_scale) {
+    snprintf(r->failure, sizeof(r->failure), "%.0f ns per byte (limit %.0f)", r->ns_per_byte,
+             r->family->ns_per_byte * budget_scale);
+  } else if (r->bytes_per_byte > r->family->bytes_per_byte * budget_scale) {
+    snprintf(r->failure, sizeof(r->failure), "%.0f runtime bytes per input byte (limit %.0f)", r->bytes_per_byte,
+             r->family->bytes_per_byte * budget_scale);
+  }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Output
+
+static void write_results(FILE *out, const FamilyResult *results, int count, double max_exponent,
+                          double budget_scale) {
+  fprintf(out, "{\n  \"schema\": 1,\n  \"max_exponent\": %.3f,\n  \"budget_scale\": %.3f,\n  \"families\": [\n",
+          max_exponent, budget_scale);
+  for (int i = 0; i < count; i++) {
+    const FamilyResult *r = &results[i];
+    fprintf(out, "    {\"name\": \"%s\", \"ok\": %s", r->family->name, r->failure[0] ? "false" : "true");
+    if (r->failure[0]) fprintf(out, ", \"failure\": \"%s\"", r->failure);
+    fprintf(out,
+            ", \"time_exponent\": %.3f, \"memory_exponent\": %.3f, \"ns_per_byte\": %.3f, \"bytes_per_byte\": %.3f,"
+            "\n     \"steps\": [",
+            r->time_exponent, r->memory_exponent, r->ns_per_byte, r->bytes_per_byte);
+    for (int s = 0; s < r->step_count; s++) {
+      const Step *step = &r->steps[s];
+      fprintf(out,
+              "%s\n       {\"bytes\": %zu, \"min_ns\": %llu, \"peak_bytes\": %zu, \"nodes\": %u, \"has_error\": %s, "
+              "\"timed_out\": %s}",
+              s ? "," : "", step->bytes, step->timed_out ? 0ull : (unsigned long long)step->min_ns,
+              step->peak_bytes, step->nodes, step->has_error ? "true" : "false", step->timed_out ? "true" : "false");
+    }
+    fprintf(out, "]}%s\n", i + 1 < count ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [--min-bytes N] [--steps N] [--iterations N] [--max-exponent X] [--budget-scale X]\n"
+          "          [--timeout SECONDS] [--input FILE]... [--output PATH] [FAMILY...]\nfamilies:",
+          argv0);
+  for (size_t f = 0; f < FAMILY_COUNT; f++) fprintf(stderr, " %s", FAMILIES[f].name);
+  fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv) {
+  size_t min_bytes = DEFAULT_MIN_BYTES;
+  int steps = DEFAULT_STEPS;
+  int iterations = DEFAULT_ITERATIONS;
+  double max_exponent = DEFAULT_MAX_EXPONENT;
+  double budget_scale = 1.0;
+  unsigned timeout = DEFAULT_TIMEOUT;
+  const char *output = NULL;
+  int first_family = argc;
+  Family *inputs = calloc((size_t)argc, sizeof(Family));
+  int input_count = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--min-bytes") == 0 && i + 1 < argc) {
+      min_bytes = (size_t)strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+      steps = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      iterations = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--max-exponent") == 0 && i + 1 < argc) {
+      max_exponent = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--budget-scale") == 0 && i + 1 < argc) {
+      budget_scale = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+      timeout = (unsigned)strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+      if (!load_input_family(argv[++i], &inputs[input_count++])) return 1;
+    } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+      usage(argv[0]);
+      return 2;
+    } else {
+      first_family = i;
+      break;
+    }
+  }
+  if (steps < 2 || steps > MAX_STEPS || iterations < 1 || min_bytes == 0 || timeout == 0 || budget_scale <= 0) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  const Family **selected = calloc(FAMILY_COUNT + (size_t)argc, sizeof(Family *));
+  int count = 0;
+  if (first_family >= argc) {
+    for (size_t f = 0; f < FAMILY_COUNT; f++) selected[count++] = &FAMILIES[f];
+  } else {
+    for (int i = first_family; i < argc; i++) {
+      size_t f = 0;
+      while (f < FAMILY_COUNT && strcmp(FAMILIES[f].name, argv[i]) != 0) f++;
+      if (f == FAMILY_COUNT) {
+        fprintf(stderr, "unknown family: %s\n", argv[i]);
+        usage(argv[0]);
+        return 2;
+      }
+      selected[count++] = &FAMILIES[f];
+    }
+  }
+  for (int i = 0; i < input_count; i++) selected[count++] = &inputs[i];
+
+  ts_set_allocator(counting_malloc, counting_calloc, counting_realloc, counting_free);
+#ifndef _WIN32
+  signal(SIGALRM, watchdog_fired);
+#endif
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_autohotkey());
+  FamilyResult *results = calloc((size_t)count, sizeof(FamilyResult));
+  int failures = 0;
+
+  for (int i = 0; i < count; i++) {
+    FamilyResult *r = &results[i];
+    r->family = selected[i];
+    r->step_count = steps;
+    for (int s = 0; s < steps; s++) {
+      Buffer input = {0};
+      generate(r->family, &input, min_bytes << s);
+#ifndef _WIN32
+      // Every iteration may legitimately take up to the timeout; the watchdog only has to catch a parse that stopped
+      // calling back at all.
+      watchdog_family = r->family->name;
+      alarm(timeout * (unsigned)iterations * 2);
+#endif
+      parse_step(parser, &input, iterations, timeout, &r->steps[s]);
+#ifndef _WIN32
+      alarm(0);
+#endif
+      free(input.data);
+      if (r->steps[s].timed_out) {
+        r->step_count = s + 1;
+        break;
+      }
+    }
+
+    check_family(r, max_exponent, budget_scale);
+    if (r->failure[0]) failures++;
+    fprintf(stderr, "%-20s %s  time ^%.2f  memory ^%.2f  %8.1f ns/byte  %7.1f bytes/byte%s%s\n", r->family->name,
+            r->failure[0] ? "FAIL" : "ok  ", r->time_exponent, r->memory_exponent, r->ns_per_byte,
+            r->bytes_per_byte, r->failure[0] ? "  " : "", r->failure);
+  }
+
+  ts_parser_delete(parser);
+
+  FILE *out = output ? fopen(output, "w") : stdout;
+  if (!out) {
+    fprintf(stderr, "%s: %s\n", output, strerror(errno));
+    return 1;
+  }
+  write_results(out, results, count, max_exponent, budget_scale);
+  if (output) fclose(out);
+  free(results);
+  free(selected);
+  for (int i = 0; i < input_count; i++) free(inputs[i].unit.data);
+  free(inputs);
+
+  if (failures) fprintf(stderr, "%d of %d families over budget\n", failures, count);
+  return failures ? 1 : 0;
+}
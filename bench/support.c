@@ -0,0 +1,216 @@
+// Helpers shared by the benchmark programs; see support.h.
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+#endif
+
+#include "support.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Timing
+
+uint64_t now_ns(void) {
+#ifdef _WIN32
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER t;
+  if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&t);
+  return (uint64_t)((double)t.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+int compare_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Allocation accounting. Installed with ts_set_allocator so every runtime allocation (parse stack, subtrees, the
+// tree itself) is counted. Each block carries its size in a header.
+
+AllocStats alloc_stats;
+
+// Keeps the payload aligned for any type
+#define ALLOC_HEADER 16
+
+static void note_alloc(size_t size) {
+  alloc_stats.current += size;
+  alloc_stats.count++;
+  if (alloc_stats.current > alloc_stats.peak) alloc_stats.peak = alloc_stats.current;
+}
+
+void *counting_malloc(size_t size) {
+  unsigned char *block = malloc(size + ALLOC_HEADER);
+  if (!block) return NULL;
+  memcpy(block, &size, sizeof(size));
+  note_alloc(size);
+  return block + ALLOC_HEADER;
+}
+
+void *counting_calloc(size_t count, size_t size) {
+  if (size != 0 && count > SIZE_MAX / size) return NULL;
+  void *ptr = counting_malloc(count * size);
+  if (ptr) memset(ptr, 0, count * size);
+  return ptr;
+}
+
+void counting_free(void *ptr) {
+  if (!ptr) return;
+  unsigned char *block = (unsigned char *)ptr - ALLOC_HEADER;
+  size_t size;
+  memcpy(&size, block, sizeof(size));
+  alloc_stats.current -= size;
+  free(block);
+}
+
+void *counting_realloc(void *ptr, size_t size) {
+  if (!ptr) return counting_malloc(size);
+  unsigned char *block = (unsigned char *)ptr - ALLOC_HEADER;
+  size_t old_size;
+  memcpy(&old_size, block, sizeof(old_size));
+  unsigned char *grown = realloc(block, size + ALLOC_HEADER);
+  if (!grown) return NULL;
+  memcpy(grown, &size, sizeof(size));
+  alloc_stats.current -= old_size;
+  note_alloc(size);
+  return grown + ALLOC_HEADER;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Buffers
+
+void buffer_append(Buffer *buf, const char *data, size_t len) {
+  if (buf->len + len + 1 > buf->cap) {
+    size_t cap = buf->cap ? buf->cap : 4096;
+    while (cap < buf->len + len + 1) cap *= 2;
+    buf->data = realloc(buf->data, cap);
+    if (!buf->data) {
+      fprintf(stderr, "out of memory\n");
+      exit(1);
+    }
+    buf->cap = cap;
+  }
+  memcpy(buf->data + buf->len, data, len);
+  buf->len += len;
+  buf->data[buf->len] = '\0';
+}
+
+void buffer_insert(Buffer *buf, size_t offset, const char *data, size_t len) {
+  size_t tail = buf->len - offset;
+  buffer_append(buf, data, len);  // grows the buffer; the bytes are moved into place below
+  memmove(buf->data + offset + len, buf->data + offset, tail);
+  memcpy(buf->data + offset, data, len);
+}
+
+void buffer_erase(Buffer *buf, size_t offset, size_t len) {
+  memmove(buf->data + offset, buf->data + offset + len, buf->len - offset - len + 1);
+  buf->len -= len;
+}
+
+bool read_file(const char *path, Buffer *out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return false;
+  }
+  char chunk[65536];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+    buffer_append(out, chunk, n);
+  }
+  bool ok = !ferror(f);
+  fclose(f);
+  return ok;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Inputs
+
+/// True if `line` (of length `len`, no newline) is a corpus delimiter: three or more `c` characters, optionally
+/// followed by a suffix as tree-sitter allows
+static bool is_delimiter(const char *line, size_t len, char c) {
+  size_t run = 0;
+  while (run < len && line[run] == c) run++;
+  return run >= 3;
+}
+
+/// Extracts the source of every test in a corpus file and joins them with newlines. Returns false if `text` doesn't
+/// look like a corpus file.
+static bool extract_corpus_sources(const char *text, size_t len, Buffer *out) {
+  enum { BEFORE_HEADER, IN_HEADER, IN_SOURCE, IN_EXPECTED } state = BEFORE_HEADER;
+  bool found = false;
+  const char *source_start = NULL;
+  const char *p = text, *end = text + len;
+
+  while (p < end) {
+    const char *eol = memchr(p, '\n', (size_t)(end - p));
+    const char *next = eol ? eol + 1 : end;
+    size_t line_len = (size_t)((eol ? eol : end) - p);
+    if (line_len > 0 && p[line_len - 1] == '\r') line_len--;
+
+    switch (state) {
+      case BEFORE_HEADER:
+      case IN_EXPECTED:
+        if (is_delimiter(p, line_len, '=')) state = IN_HEADER;
+        break;
+      case IN_HEADER:
+        if (is_delimiter(p, line_len, '=')) {
+          state = IN_SOURCE;
+          source_start = next;
+        }
+        break;
+      case IN_SOURCE:
+        if (is_delimiter(p, line_len, '-')) {
+          buffer_append(out, source_start, (size_t)(p - source_start));
+          buffer_append(out, "\n", 1);
+          found = true;
+          state = IN_EXPECTED;
+        }
+        break;
+    }
+    p = next;
+  }
+
+  return found;
+}
+
+bool load_input(const char *path, size_t min_bytes, Buffer *out) {
+  Buffer raw = {0};
+  if (!read_file(path, &raw)) return false;
+
+  Buffer unit = {0};
+  if (!extract_corpus_sources(raw.data ? raw.data : "", raw.len, &unit)) {
+    // A byte order mark is only meaningful at the start of the file, not at every repetition of it
+    size_t skip = raw.len >= 3 && memcmp(raw.data, "\xEF\xBB\xBF", 3) == 0 ? 3 : 0;
+    buffer_append(&unit, raw.data ? raw.data + skip : "", raw.len - skip);
+    if (unit.len > 0 && unit.data[unit.len - 1] != '\n') buffer_append(&unit, "\n", 1);
+  }
+  free(raw.data);
+
+  if (unit.len == 0) {
+    fprintf(stderr, "%s: empty input\n", path);
+    free(unit.data);
+    return false;
+  }
+
+  do {
+    buffer_append(out, unit.data, unit.len);
+  } while (out->len < min_bytes);
+  free(unit.data);
+  return true;
+}
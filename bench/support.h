@@ -0,0 +1,57 @@
+// Helpers shared by the benchmark programs: a monotonic clock, allocation accounting for the tree-sitter runtime, a
+// growable byte buffer and input loading.
+
+#ifndef TREE_SITTER_AUTOHOTKEY_BENCH_SUPPORT_H_
+#define TREE_SITTER_AUTOHOTKEY_BENCH_SUPPORT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Nanoseconds on a monotonic clock
+uint64_t now_ns(void);
+
+/// qsort comparator for uint64_t
+int compare_u64(const void *a, const void *b);
+
+// Allocation accounting. Install the counting_* functions with ts_set_allocator so every runtime allocation (parse
+// stack, subtrees, the tree itself) is counted in alloc_stats. Each block carries its size in a header.
+
+typedef struct {
+  size_t current;
+  size_t peak;
+  uint64_t count;
+} AllocStats;
+
+extern AllocStats alloc_stats;
+
+void *counting_malloc(size_t size);
+void *counting_calloc(size_t count, size_t size);
+void counting_free(void *ptr);
+void *counting_realloc(void *ptr, size_t size);
+
+/// Bytes that are always NUL-terminated (not counted in `len`), so they can be handed to string functions too
+typedef struct {
+  char *data;
+  size_t len;
+  size_t cap;
+} Buffer;
+
+/// Appends `len` bytes, exiting the program if it runs out of memory
+void buffer_append(Buffer *buf, const char *data, size_t len);
+
+/// Inserts `len` bytes at `offset`, exiting the program if it runs out of memory. `data` must not point into `buf`.
+void buffer_insert(Buffer *buf, size_t offset, const char *data, size_t len);
+
+/// Removes `len` bytes at `offset`
+void buffer_erase(Buffer *buf, size_t offset, size_t len);
+
+/// Appends the contents of the file at `path`; reports the error on stderr and returns false if it can't be read
+bool read_file(const char *path, Buffer *out);
+
+/// Loads a benchmark input and repeats it until it is at least `min_bytes` long. A corpus file from test/corpus
+/// contributes the source of every test in it, joined with newlines; anything else is taken as a plain script, minus
+/// any UTF-8 byte order mark.
+bool load_input(const char *path, size_t min_bytes, Buffer *out);
+
+#endif  // TREE_SITTER_AUTOHOTKEY_BENCH_SUPPORT_H_
@@ -13,12 +13,20 @@
         "src/parser.c",
       ],
       "variables": {
-        "has_scanner": "<!(node -p \"fs.existsSync('src/scanner.c')\")"
+        "has_scanner": "<!(node -p \"fs.existsSync('src/scanner.c')\")",
+        # The tree-sitter runtime for parseAsync: TREE_SITTER_RUNTIME_DIR (a tree-sitter checkout's lib/), or the copy
+        # vendored in the `tree-sitter` package when it's installed. Empty to build without it.
+        "runtime_dir": "<!(node -p \"(() => { try { const p = require('path'); const d = process.env.TREE_SITTER_RUNTIME_DIR || p.join(p.dirname(require.resolve('tree-sitter/package.json')), 'vendor', 'tree-sitter', 'lib'); return fs.existsSync(p.join(d, 'src', 'lib.c')) ? d : ''; } catch { return ''; } })()\")"
       },
       "conditions": [
         ["has_scanner=='true'", {
           "sources+": ["src/scanner.c"],
         }],
+        ["runtime_dir!=''", {
+          "sources+": ["<(runtime_dir)/src/lib.c", "bindings/c/export.c"],
+          "include_dirs+": ["<(runtime_dir)/include", "<(runtime_dir)/src", "bindings/c"],
+          "defines": ["TREE_SITTER_AHK_PARSE_ASYNC", "_DEFAULT_SOURCE"],
+        }],
         ["OS!='win'", {
           "cflags_c": [
             "-std=c11",
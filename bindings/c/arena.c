@@ -0,0 +1,201 @@
+// Per-thread arena allocator for batch parsing; see the "Arena allocation" section of tree-sitter-autohotkey.h.
+//
+// Between _begin and _end, a thread's allocations are bumped out of large chunks and its frees do nothing (except
+// for the most recent block, which is given back so short-lived temporaries don't pile up). _end drops the whole arena
+// at once. Outside of a begin/end pair, and for blocks that weren't allocated from the arena, every call goes straight
+// to the C library's allocator, so the functions can be installed with ts_set_allocator while heap blocks are live.
+
+#include <tree_sitter/tree-sitter-autohotkey.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+/// Alignment of every block: what malloc guarantees on the common 32- and 64-bit platforms
+#define ARENA_ALIGN (2 * sizeof(void *))
+
+/// Size of the first chunk a thread allocates
+#define ARENA_FIRST_CHUNK ((size_t)256 * 1024)
+
+#define round_up(n) (((n) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+typedef struct Chunk {
+  struct Chunk *prev;
+  size_t cap;  ///< bytes of blocks it holds, after the (padded) header
+} Chunk;
+
+#define CHUNK_HEADER round_up(sizeof(Chunk))
+#define chunk_data(chunk) ((unsigned char *)(chunk) + CHUNK_HEADER)
+
+// Each block is ARENA_ALIGN bytes of header holding the requested size (for realloc), then the payload.
+#define block_size(ptr) (*(size_t *)((unsigned char *)(ptr) - ARENA_ALIGN))
+
+typedef struct {
+  bool active;
+  Chunk *head;           ///< chunk being bumped; older ones follow `prev`
+  unsigned char *top;    ///< next free byte in `head`
+  unsigned char *limit;  ///< end of `head`
+  unsigned char *last;   ///< payload of the most recent block, which can still grow or be given back in place
+  size_t next_chunk;     ///< size of the next chunk to allocate
+  TSAutohotkeyArenaStats stats;
+} Arena;
+
+static THREAD_LOCAL Arena arena;
+
+/// The runtime doesn't check for allocation failures, so fail the way its own default allocator does
+static void out_of_memory(size_t size) {
+  fprintf(stderr, "tree-sitter failed to allocate %zu bytes", size);
+  abort();
+}
+
+static bool owns(const void *ptr) {
+  const unsigned char *p = ptr;
+  for (Chunk *chunk = arena.head; chunk; chunk = chunk->prev) {
+    if (p >= chunk_data(chunk) && p < chunk_data(chunk) + chunk->cap) return true;
+  }
+  return false;
+}
+
+static void *arena_alloc(size_t size) {
+  if (size > SIZE_MAX / 2) out_of_memory(size);
+  size_t needed = ARENA_ALIGN + round_up(size);
+  if (!arena.head || (size_t)(arena.limit - arena.top) < needed) {
+    size_t cap = arena.next_chunk ? arena.next_chunk : ARENA_FIRST_CHUNK;
+    while (cap < needed) cap *= 2;
+    Chunk *chunk = malloc(CHUNK_HEADER + cap);
+    if (!chunk) out_of_memory(CHUNK_HEADER + cap);
+    chunk->prev = arena.head;
+    chunk->cap = cap;
+    arena.head = chunk;
+    arena.top = chunk_data(chunk);
+    arena.limit = arena.top + cap;
+    arena.next_chunk = cap * 2;
+    arena.stats.reserved += cap;
+  }
+
+  unsigned char *ptr = arena.top + ARENA_ALIGN;
+  block_size(ptr) = size;
+  arena.top += needed;
+  arena.last = ptr;
+  arena.stats.used += needed;
+  arena.stats.allocations++;
+  if (arena.stats.used > arena.stats.peak) arena.stats.peak = arena.stats.used;
+  return ptr;
+}
+
+static void free_chunks(void) {
+  for (Chunk *chunk = arena.head, *prev; chunk; chunk = prev) {
+    prev = chunk->prev;
+    free(chunk);
+  }
+  arena.head = NULL;
+  arena.top = arena.limit = NULL;
+  arena.stats.reserved = 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Allocation functions, for ts_set_allocator
+
+void *tree_sitter_autohotkey_arena_malloc(size_t size) {
+  if (arena.active) return arena_alloc(size);
+  void *ptr = malloc(size);
+  if (!ptr && size) out_of_memory(size);
+  return ptr;
+}
+
+void *tree_sitter_autohotkey_arena_calloc(size_t count, size_t size) {
+  if (size != 0 && count > SIZE_MAX / size) out_of_memory(SIZE_MAX);
+  if (!arena.active) {
+    void *ptr = calloc(count, size);
+    if (!ptr && count && size) out_of_memory(count * size);
+    return ptr;
+  }
+  void *ptr = arena_alloc(count * size);
+  memset(ptr, 0, count * size);
+  return ptr;
+}
+
+void *tree_sitter_autohotkey_arena_realloc(void *ptr, size_t size) {
+  if (!ptr) return tree_sitter_autohotkey_arena_malloc(size);
+  if (!arena.active || !owns(ptr)) {
+    void *grown = realloc(ptr, size);
+    if (!grown && size) out_of_memory(size);
+    return grown;
+  }
+
+  // The stack and node arrays the runtime grows are usually the last thing allocated, so they can grow in place
+  unsigned char *p = ptr;
+  size_t old_size = block_size(ptr);
+  if (p == arena.last && size <= SIZE_MAX / 2 && (size_t)(arena.limit - p) >= round_up(size)) {
+    arena.stats.used = arena.stats.used - round_up(old_size) + round_up(size);
+    if (arena.stats.used > arena.stats.peak) arena.stats.peak = arena.stats.used;
+    arena.top = p + round_up(size);
+    block_size(ptr) = size;
+    return ptr;
+  }
+  if (size <= old_size) {
+    block_size(ptr) = size;
+    return ptr;
+  }
+  void *grown = arena_alloc(size);
+  memcpy(grown, ptr, old_size);
+  return grown;
+}
+
+void tree_sitter_autohotkey_arena_free(void *ptr) {
+  if (!ptr) return;
+  if (!arena.active || !owns(ptr)) {
+    free(ptr);
+    return;
+  }
+  if (ptr == arena.last) {
+    size_t size = ARENA_ALIGN + round_up(block_size(ptr));
+    arena.top -= size;
+    arena.stats.used -= size;
+    arena.last = NULL;
+  }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Scopes
+
+void tree_sitter_autohotkey_arena_begin(void) {
+  if (arena.active) return;
+  arena.active = true;
+  arena.stats.used = 0;
+  arena.stats.peak = 0;
+  arena.stats.allocations = 0;
+}
+
+void tree_sitter_autohotkey_arena_end(void) {
+  if (!arena.active) return;
+  arena.active = false;
+  arena.last = NULL;
+  if (!arena.head) return;
+
+  // Keep a lone chunk for the next file. A scope that needed several gets them back as one chunk as large as all of
+  // them together, so a run of similar files settles on a single chunk and stops calling malloc at all.
+  if (!arena.head->prev) {
+    arena.top = chunk_data(arena.head);
+    return;
+  }
+  arena.next_chunk = arena.stats.reserved;
+  free_chunks();
+}
+
+void tree_sitter_autohotkey_arena_release(void) {
+  tree_sitter_autohotkey_arena_end();
+  free_chunks();
+  arena.next_chunk = 0;
+}
+
+void tree_sitter_autohotkey_arena_stats(TSAutohotkeyArenaStats *stats) {
+  *stats = arena.stats;
+}
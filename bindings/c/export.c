@@ -0,0 +1,142 @@
+// Binary tree export; see tree-sitter-autohotkey-export.h.
+//
+// The size is known before the walk: the string table comes from the language, and ts_node_descendant_count gives the
+// number of nodes a cursor will visit. The nodes are then written in one TSTreeCursor pass in pre-order, keeping the
+// indices of the nodes on the path from `root` to the cursor so each node can be linked to its parent and previous
+// sibling, and closed (its subtree_end set) when the walk leaves it.
+
+#include <tree_sitter/tree-sitter-autohotkey-export.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALIGN8(n) (((n) + 7) & ~(uint64_t)7)
+
+/// Name of string table entry `i`: the symbols, then the fields from 0 (none) up
+static const char *entry_name(const TSLanguage *language, uint32_t symbols, uint32_t i) {
+  const char *name = i < symbols ? ts_language_symbol_name(language, (TSSymbol)i)
+                                 : ts_language_field_name_for_id(language, (TSFieldId)(i - symbols));
+  return name ? name : "";
+}
+
+/// Size of the offsets array and the names after it
+static uint64_t strings_size(const TSLanguage *language, uint32_t symbols, uint32_t fields) {
+  uint32_t entries = symbols + fields + 1;
+  uint64_t size = (uint64_t)(entries + 1) * sizeof(uint32_t);
+  for (uint32_t i = 0; i < entries; i++) size += strlen(entry_name(language, symbols, i)) + 1;
+  return size;
+}
+
+static void write_strings(const TSLanguage *language, uint32_t symbols, uint32_t fields, uint8_t *out) {
+  uint32_t entries = symbols + fields + 1;
+  uint8_t *names = out + (size_t)(entries + 1) * sizeof(uint32_t);
+  uint32_t offset = 0;
+  for (uint32_t i = 0; i < entries; i++) {
+    const char *name = entry_name(language, symbols, i);
+    size_t length = strlen(name) + 1;
+    memcpy(out + i * sizeof(uint32_t), &offset, sizeof(uint32_t));
+    memcpy(names + offset, name, length);
+    offset += (uint32_t)length;
+  }
+  memcpy(out + entries * sizeof(uint32_t), &offset, sizeof(uint32_t));
+}
+
+/// Writes the `count` records of the nodes under `root`; false if the path stack can't be allocated, or there turn out
+/// to be more nodes than that
+static bool write_nodes(TSNode root, TSAutohotkeyExportNode *nodes, uint32_t count) {
+  uint32_t path_cap = 64, depth = 0, n = 0;
+  uint32_t *path = malloc(path_cap * sizeof(uint32_t));
+  if (!path) return false;
+
+  TSTreeCursor cursor = ts_tree_cursor_new(root);
+  for (;;) {
+    if (n == count) break;  // more nodes than ts_node_descendant_count said, so the buffer would overflow
+    TSNode node = ts_tree_cursor_current_node(&cursor);
+    uint32_t parent = depth ? path[depth - 1] : TREE_SITTER_AUTOHOTKEY_EXPORT_NONE;
+    uint16_t flags = (ts_node_is_named(node) ? TSAutohotkeyExportNamed : 0) |
+                     (ts_node_is_error(node) ? TSAutohotkeyExportError : 0) |
+                     (ts_node_is_missing(node) ? TSAutohotkeyExportMissing : 0) |
+                     (ts_node_is_extra(node) ? TSAutohotkeyExportExtra : 0) |
+                     (ts_node_has_error(node) ? TSAutohotkeyExportHasError : 0);
+    nodes[n] = (TSAutohotkeyExportNode){
+      .symbol = ts_node_symbol(node),
+      .field = ts_tree_cursor_current_field_id(&cursor),
+      .flags = flags,
+      .start_byte = ts_node_start_byte(node),
+      .end_byte = ts_node_end_byte(node),
+      .parent = parent,
+      .first_child = TREE_SITTER_AUTOHOTKEY_EXPORT_NONE,
+      .next_sibling = TREE_SITTER_AUTOHOTKEY_EXPORT_NONE,
+    };
+    if (depth && nodes[parent].first_child == TREE_SITTER_AUTOHOTKEY_EXPORT_NONE) nodes[parent].first_child = n;
+    if (depth == path_cap) {
+      uint32_t *grown = realloc(path, (size_t)path_cap * 2 * sizeof(uint32_t));
+      if (!grown) break;
+      path = grown;
+      path_cap *= 2;
+    }
+    path[depth] = n++;
+
+    if (ts_tree_cursor_goto_first_child(&cursor)) {
+      depth++;
+      continue;
+    }
+    // Close the node just written, then every ancestor the cursor climbs out of, up to one with a next sibling
+    for (;;) {
+      nodes[path[depth]].subtree_end = n;
+      if (ts_tree_cursor_goto_next_sibling(&cursor)) {
+        nodes[path[depth]].next_sibling = n;
+        break;
+      }
+      if (depth == 0 || !ts_tree_cursor_goto_parent(&cursor)) {
+        ts_tree_cursor_delete(&cursor);
+        free(path);
+        return true;
+      }
+      depth--;
+    }
+  }
+  ts_tree_cursor_delete(&cursor);
+  free(path);
+  return false;
+}
+
+size_t tree_sitter_autohotkey_export(TSNode root, void *buffer, size_t capacity) {
+  if (ts_node_is_null(root)) return 0;
+  const TSLanguage *language = ts_node_language(root);
+  uint32_t symbols = ts_language_symbol_count(language);
+  uint32_t fields = ts_language_field_count(language);
+  uint32_t node_count = ts_node_descendant_count(root);
+
+  uint64_t strings = strings_size(language, symbols, fields);
+  uint64_t strings_offset = ALIGN8(sizeof(TSAutohotkeyExportHeader));
+  uint64_t nodes_offset = ALIGN8(strings_offset + strings);
+  uint64_t total = nodes_offset + (uint64_t)node_count * sizeof(TSAutohotkeyExportNode);
+  if (total > UINT32_MAX) return 0;
+  if (!buffer || capacity < total) return (size_t)total;
+  if ((uintptr_t)buffer % 8) return 0;
+
+  uint8_t *out = buffer;
+  TSAutohotkeyExportHeader header = {
+    .magic = TREE_SITTER_AUTOHOTKEY_EXPORT_MAGIC,
+    .version = TREE_SITTER_AUTOHOTKEY_EXPORT_VERSION,
+    .byte_order = TREE_SITTER_AUTOHOTKEY_EXPORT_BYTE_ORDER,
+    .header_size = sizeof(TSAutohotkeyExportHeader),
+    .node_size = sizeof(TSAutohotkeyExportNode),
+    .abi_version = ts_language_abi_version(language),
+    .symbol_count = symbols,
+    .field_count = fields,
+    .strings_offset = (uint32_t)strings_offset,
+    .strings_size = (uint32_t)strings,
+    .node_count = node_count,
+    .nodes_offset = (uint32_t)nodes_offset,
+    .total_size = (uint32_t)total,
+  };
+  memcpy(out, &header, sizeof(header));
+  write_strings(language, symbols, fields, out + strings_offset);
+  // Padding is zeroed, so the same tree always exports to the same bytes
+  memset(out + strings_offset + strings, 0, (size_t)(nodes_offset - strings_offset - strings));
+  if (!write_nodes(root, (TSAutohotkeyExportNode *)(out + nodes_offset), node_count)) return 0;
+  return (size_t)total;
+}
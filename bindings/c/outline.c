@@ -0,0 +1,139 @@
+// Outline extraction; see tree-sitter-autohotkey-outline.h.
+//
+// A TSTreeCursor walks the children of the root, and of class and struct bodies, comparing symbols (looked up once
+// per call) rather than type names. Everything else is stepped over as a sibling, so the cursor never goes below the
+// definitions themselves.
+
+#include <tree_sitter/tree-sitter-autohotkey-outline.h>
+
+#include <stddef.h>
+
+/// Symbols and fields the walk looks at, resolved from the tree's language
+typedef struct {
+  TSSymbol hotkey, hotstring, remap, hotif, function, klass, structure, method, property, typed_property, exported;
+  TSFieldId body, name, trigger, origin, expression;
+} Grammar;
+
+typedef struct {
+  Grammar grammar;
+  TSAutohotkeyOutlineCallback callback;
+  void *payload;
+  TSNode context;
+  uint32_t count;
+  bool stopped;
+} Walk;
+
+static void resolve(const TSLanguage *language, Grammar *g) {
+#define SYMBOL(name) ts_language_symbol_for_name(language, name, (uint32_t)sizeof(name) - 1, true)
+#define FIELD(name) ts_language_field_id_for_name(language, name, (uint32_t)sizeof(name) - 1)
+  g->hotkey = SYMBOL("hotkey");
+  g->hotstring = SYMBOL("hotstring");
+  g->remap = SYMBOL("remap");
+  g->hotif = SYMBOL("hotif_directive");
+  g->function = SYMBOL("function_declaration");
+  g->klass = SYMBOL("class_declaration");
+  g->structure = SYMBOL("struct_declaration");
+  g->method = SYMBOL("method_declaration");
+  g->property = SYMBOL("property_declaration");
+  g->typed_property = SYMBOL("typed_property_declaration");
+  g->exported = SYMBOL("export_declaration");
+  g->body = FIELD("body");
+  g->name = FIELD("name");
+  g->trigger = FIELD("trigger");
+  g->origin = FIELD("origin");
+  g->expression = FIELD("expression");
+#undef SYMBOL
+#undef FIELD
+}
+
+/// First named child of `node` in `field`. The #HotIf expression field also holds the parentheses around it, so the
+/// runtime's ts_node_child_by_field_id could return one of those.
+static TSNode named_field_child(TSNode node, TSFieldId field) {
+  TSNode found = {{0}, NULL, NULL};
+  TSTreeCursor cursor = ts_tree_cursor_new(node);
+  if (ts_tree_cursor_goto_first_child(&cursor)) {
+    do {
+      TSNode child = ts_tree_cursor_current_node(&cursor);
+      if (ts_tree_cursor_current_field_id(&cursor) == field && ts_node_is_named(child)) {
+        found = child;
+        break;
+      }
+    } while (ts_tree_cursor_goto_next_sibling(&cursor));
+  }
+  ts_tree_cursor_delete(&cursor);
+  return found;
+}
+
+static void emit(Walk *walk, TSAutohotkeyOutlineKind kind, TSNode node, TSNode name, uint32_t depth) {
+  TSAutohotkeyOutlineItem item = {
+    .kind = kind,
+    .node = node,
+    .name = name,
+    .context = kind <= TSAutohotkeyOutlineRemap ? walk->context : (TSNode){{0}, NULL, NULL},
+    .depth = depth,
+  };
+  walk->count++;
+  if (!walk->callback(&item, walk->payload)) walk->stopped = true;
+}
+
+/// Reports the definitions among the children of the cursor's node, then returns the cursor to it
+static void walk_children(Walk *walk, TSTreeCursor *cursor, uint32_t depth) {
+  const Grammar *g = &walk->grammar;
+#define CHILD(field) ts_node_child_by_field_id(node, g->field)
+  if (!ts_tree_cursor_goto_first_child(cursor)) return;
+  do {
+    TSNode node = ts_tree_cursor_current_node(cursor);
+    TSSymbol symbol = ts_node_symbol(node);
+    if (symbol == g->hotkey) {
+      emit(walk, TSAutohotkeyOutlineHotkey, node, CHILD(trigger), depth);
+    } else if (symbol == g->hotstring) {
+      emit(walk, TSAutohotkeyOutlineHotstring, node, CHILD(trigger), depth);
+    } else if (symbol == g->remap) {
+      emit(walk, TSAutohotkeyOutlineRemap, node, CHILD(origin), depth);
+    } else if (symbol == g->hotif) {
+      // A bare #HotIf has no expression, and ends the previous context
+      walk->context = named_field_child(node, g->expression);
+      emit(walk, TSAutohotkeyOutlineHotIf, node, walk->context, depth);
+    } else if (symbol == g->function) {
+      emit(walk, TSAutohotkeyOutlineFunction, node, CHILD(name), depth);
+    } else if (symbol == g->method) {
+      emit(walk, TSAutohotkeyOutlineMethod, node, CHILD(name), depth);
+    } else if (symbol == g->property || symbol == g->typed_property) {
+      emit(walk, TSAutohotkeyOutlineProperty, node, CHILD(name), depth);
+    } else if (symbol == g->klass || symbol == g->structure) {
+      TSAutohotkeyOutlineKind kind = symbol == g->klass ? TSAutohotkeyOutlineClass : TSAutohotkeyOutlineStruct;
+      emit(walk, kind, node, CHILD(name), depth);
+      if (!walk->stopped && ts_tree_cursor_goto_first_child(cursor)) {
+        do {
+          if (ts_tree_cursor_current_field_id(cursor) == g->body) {
+            walk_children(walk, cursor, depth + 1);
+            break;
+          }
+        } while (ts_tree_cursor_goto_next_sibling(cursor));
+        ts_tree_cursor_goto_parent(cursor);
+      }
+    } else if (symbol == g->exported) {
+      // The declaration it wraps is the definition
+      walk_children(walk, cursor, depth);
+    }
+  } while (!walk->stopped && ts_tree_cursor_goto_next_sibling(cursor));
+  ts_tree_cursor_goto_parent(cursor);
+#undef CHILD
+}
+
+uint32_t tree_sitter_autohotkey_outline(TSNode root, TSAutohotkeyOutlineCallback callback, void *payload) {
+  if (ts_node_is_null(root)) return 0;
+  Walk walk = {.callback = callback, .payload = payload};
+  resolve(ts_node_language(root), &walk.grammar);
+  TSTreeCursor cursor = ts_tree_cursor_new(root);
+  walk_children(&walk, &cursor, 0);
+  ts_tree_cursor_delete(&cursor);
+  return walk.count;
+}
+
+const char *tree_sitter_autohotkey_outline_kind_name(TSAutohotkeyOutlineKind kind) {
+  static const char *const NAMES[TREE_SITTER_AUTOHOTKEY_OUTLINE_KIND_COUNT] = {
+    "hotkey", "hotstring", "remap", "hotif", "function", "class", "struct", "method", "property",
+  };
+  return (unsigned)kind < TREE_SITTER_AUTOHOTKEY_OUTLINE_KIND_COUNT ? NAMES[kind] : NULL;
+}
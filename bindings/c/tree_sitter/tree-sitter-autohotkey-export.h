@@ -0,0 +1,92 @@
+#ifndef TREE_SITTER_AUTOHOTKEY_EXPORT_H_
+#define TREE_SITTER_AUTOHOTKEY_EXPORT_H_
+
+#include <tree_sitter/api.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Binary tree export, from the tree-sitter-autohotkey-export library (built, like the outline library, only when CMake
+// finds the tree-sitter runtime), and behind the Python binding's parse_many(binary=True) and the Node binding's
+// parseAsync({ binary: true }).
+//
+// A tree is written as one flat buffer that another process can read in place, or map from a file, without parsing
+// anything: a header, a string table of the language's type and field names, and an array of fixed-size node records
+// in pre-order, linked to each other by index. Everything is 4-byte words (and 2-byte halves in the node records) in
+// the byte order of the machine that wrote it, which `byte_order` records; sections start on 8-byte boundaries.
+//
+//   offset 0               TSAutohotkeyExportHeader
+//   strings_offset         uint32_t offsets[symbol_count + field_count + 2], then the names, each NUL-terminated.
+//                          Name i runs from byte offsets[i] to offsets[i + 1] - 1 of the bytes after the array. Names
+//                          0 to symbol_count - 1 are node types by TSSymbol (so they're the names node-types.json uses,
+//                          with ERROR and the hidden rules too); name symbol_count + f is field f, with field 0 (none)
+//                          the empty string.
+//   nodes_offset           TSAutohotkeyExportNode[node_count]; node 0 is the root
+//
+// Symbols and field ids are this grammar version's, so a reader can cache the string table per `abi_version` and
+// `symbol_count`, but should check them. Byte offsets count bytes of the input as it was parsed, so in UTF-16 trees
+// they're UTF-16 bytes, and don't include a byte order mark the bindings skipped.
+
+#define TREE_SITTER_AUTOHOTKEY_EXPORT_MAGIC "AHKTREE"
+#define TREE_SITTER_AUTOHOTKEY_EXPORT_VERSION 1
+
+/// Written as 0x01020304; reads back differently on a machine of the other byte order
+#define TREE_SITTER_AUTOHOTKEY_EXPORT_BYTE_ORDER 0x01020304u
+
+/// Node index meaning "no node", for the root's parent and leaves' children
+#define TREE_SITTER_AUTOHOTKEY_EXPORT_NONE UINT32_MAX
+
+typedef struct {
+  char magic[8];            ///< TREE_SITTER_AUTOHOTKEY_EXPORT_MAGIC, NUL-padded
+  uint32_t version;         ///< TREE_SITTER_AUTOHOTKEY_EXPORT_VERSION
+  uint32_t byte_order;      ///< TREE_SITTER_AUTOHOTKEY_EXPORT_BYTE_ORDER in the writer's byte order
+  uint32_t header_size;     ///< sizeof(TSAutohotkeyExportHeader); later versions only add to the end
+  uint32_t node_size;       ///< sizeof(TSAutohotkeyExportNode)
+  uint32_t abi_version;     ///< the language's ABI version
+  uint32_t symbol_count;
+  uint32_t field_count;     ///< not counting field 0
+  uint32_t strings_offset;  ///< from the start of the buffer
+  uint32_t strings_size;    ///< offsets array and names, without padding
+  uint32_t node_count;
+  uint32_t nodes_offset;    ///< from the start of the buffer
+  uint32_t total_size;      ///< of the whole buffer
+  uint32_t reserved[2];
+} TSAutohotkeyExportHeader;
+
+enum {
+  TSAutohotkeyExportNamed = 1,
+  TSAutohotkeyExportError = 2,     ///< an ERROR node
+  TSAutohotkeyExportMissing = 4,   ///< inserted by error recovery, zero-width
+  TSAutohotkeyExportExtra = 8,     ///< a comment or other extra
+  TSAutohotkeyExportHasError = 16, ///< it or a descendant is an error or missing
+};
+
+typedef struct {
+  uint16_t symbol;        ///< node type, an index into the string table
+  uint16_t field;         ///< field it fills in its parent, 0 for none
+  uint16_t flags;         ///< TSAutohotkeyExport* flags
+  uint16_t reserved;
+  uint32_t start_byte;
+  uint32_t end_byte;
+  uint32_t parent;        ///< node indices, or TREE_SITTER_AUTOHOTKEY_EXPORT_NONE
+  uint32_t first_child;
+  uint32_t next_sibling;
+  uint32_t subtree_end;   ///< one past the index of its last descendant, so its subtree is [index, subtree_end)
+} TSAutohotkeyExportNode;
+
+/// Writes the tree under `root` into `buffer` if `capacity` is enough, and returns the size it needs either way; call
+/// with a NULL buffer to find out how much to allocate or map, then again to fill it. `buffer` must be 8-byte aligned
+/// (as malloc's and mmap's are) so the records can be read in place. The nodes are written in a single cursor pass.
+/// Returns 0 if `root` is null, `buffer` isn't aligned, the export would be too large for 32-bit offsets, or memory for
+/// the walk runs out.
+size_t tree_sitter_autohotkey_export(TSNode root, void *buffer, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TREE_SITTER_AUTOHOTKEY_EXPORT_H_
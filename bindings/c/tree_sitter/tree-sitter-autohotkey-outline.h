@@ -0,0 +1,62 @@
+#ifndef TREE_SITTER_AUTOHOTKEY_OUTLINE_H_
+#define TREE_SITTER_AUTOHOTKEY_OUTLINE_H_
+
+#include <tree_sitter/api.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Outline extraction, from the tree-sitter-autohotkey-outline library. Unlike the grammar library it links against the
+// tree-sitter runtime, so CMake only builds it when the runtime is found (and TREE_SITTER_AHK_OUTLINE is on).
+//
+// The outline is what a script defines at the top level: hotkeys, hotstrings and remaps, the #HotIf context each one
+// is under, functions, and classes and structs with their members. It's the same set of items queries/outline.scm
+// captures, found by walking the tree's top levels directly instead of running a query over every node: the walk never
+// enters a function, method or hotkey body, so its cost follows the number of definitions rather than the size of the
+// script. Definitions nested inside a body (a function declared in a function, say) are therefore left out, where the
+// query finds them.
+//
+// Items are streamed to a callback in source order as they're found, and the walk can be stopped from it.
+
+typedef enum {
+  TSAutohotkeyOutlineHotkey,
+  TSAutohotkeyOutlineHotstring,
+  TSAutohotkeyOutlineRemap,
+  TSAutohotkeyOutlineHotIf,
+  TSAutohotkeyOutlineFunction,
+  TSAutohotkeyOutlineClass,
+  TSAutohotkeyOutlineStruct,
+  TSAutohotkeyOutlineMethod,
+  TSAutohotkeyOutlineProperty,
+} TSAutohotkeyOutlineKind;
+
+/// Number of TSAutohotkeyOutlineKind values
+#define TREE_SITTER_AUTOHOTKEY_OUTLINE_KIND_COUNT 9
+
+typedef struct {
+  TSAutohotkeyOutlineKind kind;
+  TSNode node;     ///< the whole definition (hotkey, function_declaration, hotif_directive, ...)
+  TSNode name;     ///< its trigger, origin key or name; for #HotIf the expression. Null (ts_node_is_null) if absent.
+  TSNode context;  ///< for hotkeys, hotstrings and remaps, the expression of the #HotIf in effect, or null if none
+  uint32_t depth;  ///< 0 at the top level, 1 for members of a top-level class, and so on
+} TSAutohotkeyOutlineItem;
+
+/// Called for each item. The nodes are only valid while the tree is. Return false to stop the walk.
+typedef bool (*TSAutohotkeyOutlineCallback)(const TSAutohotkeyOutlineItem *item, void *payload);
+
+/// Walks the outline of the tree under `root` (a source_file node), calling `callback` with each item. Returns the
+/// number of items reported, including the one the callback stopped at, if any.
+uint32_t tree_sitter_autohotkey_outline(TSNode root, TSAutohotkeyOutlineCallback callback, void *payload);
+
+/// Lowercase name of `kind` ("hotkey", "hotif", "property", ...), or NULL if it isn't one
+const char *tree_sitter_autohotkey_outline_kind_name(TSAutohotkeyOutlineKind kind);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TREE_SITTER_AUTOHOTKEY_OUTLINE_H_
@@ -1,6 +1,10 @@
 #ifndef TREE_SITTER_AUTOHOTKEY_H_
 #define TREE_SITTER_AUTOHOTKEY_H_
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 typedef struct TSLanguage TSLanguage;
 
 #ifdef __cplusplus
@@ -9,6 +13,86 @@ extern "C" {
 
 const TSLanguage *tree_sitter_autohotkey(void);
 
+// Scanner instrumentation. These are only defined when the library is built with TREE_SITTER_AHK_STATS (the CMake
+// option of the same name); counting costs nothing otherwise because it isn't compiled in.
+
+/// Number of external token types, in the order of `externals` in grammar.js
+#define TREE_SITTER_AUTOHOTKEY_EXTERNAL_TOKEN_COUNT 14
+
+/// Counters for one external token type. Advances count lexer advances (code points), not bytes of UTF-8.
+typedef struct {
+  uint64_t probes;     ///< times the scanner tried to lex this token
+  uint64_t hits;       ///< times it succeeded
+  uint64_t advanced;   ///< characters advanced while probing for it
+  uint64_t discarded;  ///< of those, characters past the end of the token that scan() returned (all, when none)
+} TSAutohotkeyTokenStats;
+
+/// Copies up to `count` per-token counters, indexed like `externals` in grammar.js, into `stats` and returns how
+/// many were copied. The counters are process-wide and unsynchronized; read them from a single thread.
+uint32_t tree_sitter_autohotkey_scanner_stats(TSAutohotkeyTokenStats *stats, uint32_t count);
+
+/// Name of the external token at `index` as spelled in grammar.js (e.g. "_function_def_marker"), or NULL
+const char *tree_sitter_autohotkey_scanner_token_name(uint32_t index);
+
+/// Zeroes all scanner counters
+void tree_sitter_autohotkey_scanner_stats_reset(void);
+
+// Arena allocation for batch parsing. These are defined in a separate library, tree-sitter-autohotkey-arena, which only
+// the CMake build makes (unless TREE_SITTER_AHK_ARENA is turned off); link it along with the grammar to use them.
+//
+// Parsing a file makes many small allocations (subtrees, stack nodes) that are all freed together when its tree is
+// deleted. Between tree_sitter_autohotkey_arena_begin and _end, a thread allocates them from an arena instead: a bump
+// pointer into large chunks, with frees that do nothing, and _end releasing everything at once. Install the four
+// allocation functions once, before creating any parser:
+//
+//   ts_set_allocator(tree_sitter_autohotkey_arena_malloc, tree_sitter_autohotkey_arena_calloc,
+//                    tree_sitter_autohotkey_arena_realloc, tree_sitter_autohotkey_arena_free);
+//
+// and bracket each file:
+//
+//   tree_sitter_autohotkey_arena_begin();
+//   TSParser *parser = ts_parser_new();
+//   ts_parser_set_language(parser, tree_sitter_autohotkey());
+//   TSTree *tree = ts_parser_parse_string(parser, NULL, source, length);
+//   // ... walk the tree, run queries, copy out whatever should outlive it ...
+//   ts_parser_delete(parser);  // no need to delete the tree
+//   tree_sitter_autohotkey_arena_end();
+//
+// Everything the runtime allocates inside the pair must be done with by _end: parsers, trees, cursors, and strings
+// from ts_node_string (drop those, or free them with tree_sitter_autohotkey_arena_free rather than free). A parser in
+// particular keeps memory from one parse to the next, so it has to be created inside the pair too, not reused across
+// files. Objects allocated outside a pair live on the C library's heap as usual and may be used and freed anywhere.
+// Arenas are per thread, so each worker of a pool brackets its own files, and an arena's objects must not be handed
+// to other threads. Each thread keeps one chunk between pairs to start the next file with;
+// tree_sitter_autohotkey_arena_release gives it back, and should be called before the thread exits.
+
+/// Allocation functions for ts_set_allocator. Outside of a begin/end pair, and for memory that didn't come from the
+/// arena, they call malloc, calloc, realloc and free. Like the runtime's defaults, they abort when memory runs out.
+void *tree_sitter_autohotkey_arena_malloc(size_t size);
+void *tree_sitter_autohotkey_arena_calloc(size_t count, size_t size);
+void *tree_sitter_autohotkey_arena_realloc(void *ptr, size_t size);
+void tree_sitter_autohotkey_arena_free(void *ptr);
+
+/// Starts allocating from this thread's arena. Pairs don't nest: a second call before _end does nothing.
+void tree_sitter_autohotkey_arena_begin(void);
+
+/// Releases everything allocated from this thread's arena since _begin, and goes back to the heap
+void tree_sitter_autohotkey_arena_end(void);
+
+/// Ends the current pair, if any, and frees the memory this thread's arena keeps between pairs
+void tree_sitter_autohotkey_arena_release(void);
+
+/// This thread's arena usage, in bytes including block headers. `used`, `peak` and `allocations` cover the current
+/// begin/end pair, or the last one after _end.
+typedef struct {
+  size_t used;
+  size_t peak;
+  size_t reserved;       ///< chunk memory held, including what's kept between pairs
+  uint64_t allocations;  ///< blocks handed out (reallocs that grew in place don't count)
+} TSAutohotkeyArenaStats;
+
+void tree_sitter_autohotkey_arena_stats(TSAutohotkeyArenaStats *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,7 +1,17 @@
 package tree_sitter_autohotkey_test
 
 import (
+	"bytes"
+	"context"
+	"errors"
+	"io/fs"
+	"os"
+	"path/filepath"
+	"runtime"
+	"strings"
+	"sync"
 	"testing"
+	"time"
 
 	tree_sitter "github.com/tree-sitter/go-tree-sitter"
 	tree_sitter_autohotkey "github.com/holy-tao/tree-sitter-autohotkey/bindings/go"
@@ -13,3 +23,253 @@ func TestCanLoadGrammar(t *testing.T) {
 		t.Errorf("Error loading AutoHotkey grammar")
 	}
 }
+
+func newParser(t *testing.T) *tree_sitter.Parser {
+	parser := tree_sitter.NewParser()
+	t.Cleanup(parser.Close)
+	if err := parser.SetLanguage(tree_sitter.NewLanguage(tree_sitter_autohotkey.Language())); err != nil {
+		t.Fatal(err)
+	}
+	return parser
+}
+
+func TestParseContext(t *testing.T) {
+	parser := newParser(t)
+	large := bytes.Repeat([]byte("x := [1, 2, (3 + 4) * 5]\n"), 200_000)
+
+	ctx, cancel := context.WithTimeout(context.Background(), time.Millisecond)
+	defer cancel()
+	result := parseOrFail(t, ctx, parser, large, tree_sitter_autohotkey.ParseTimedOut)
+	if result.BytesParsed >= uint32(len(large)) {
+		t.Errorf("timed out parse got through %d of %d bytes", result.BytesParsed, len(large))
+	}
+
+	ctx, cancel = context.WithCancel(context.Background())
+	cancel()
+	parseOrFail(t, ctx, parser, large, tree_sitter_autohotkey.ParseCancelled)
+
+	// The stopped parses were reset, so this one starts afresh
+	result = parseOrFail(t, context.Background(), parser, []byte("x := 1\n"), tree_sitter_autohotkey.ParseComplete)
+	defer result.Tree.Close()
+	if root := result.Tree.RootNode(); root.HasError() || result.BytesParsed != 7 {
+		t.Errorf("got %s after %d bytes", root.ToSexp(), result.BytesParsed)
+	}
+}
+
+func parseOrFail(t *testing.T, ctx context.Context, parser *tree_sitter.Parser, source []byte, want tree_sitter_autohotkey.ParseStatus) tree_sitter_autohotkey.ParseResult {
+	t.Helper()
+	result := tree_sitter_autohotkey.ParseContext(ctx, parser, source, nil)
+	if result.Status != want || (result.Tree == nil) != (want != tree_sitter_autohotkey.ParseComplete) {
+		t.Fatalf("status %s (tree %v), want %s", result.Status, result.Tree != nil, want)
+	}
+	return result
+}
+
+// corpusFiles writes the sources of each test/corpus file, joined, to a file of its own under a
+// temporary directory (as bench/bench.c loads them), and returns their paths and contents.
+func corpusFiles(tb testing.TB) ([]string, [][]byte) {
+	tb.Helper()
+	corpora, err := filepath.Glob(filepath.Join("..", "..", "test", "corpus", "*.txt"))
+	if err != nil || len(corpora) == 0 {
+		tb.Fatalf("no corpus files found: %v", err)
+	}
+	dir := tb.TempDir()
+	var paths []string
+	var sources [][]byte
+	for _, corpus := range corpora {
+		text, err := os.ReadFile(corpus)
+		if err != nil {
+			tb.Fatal(err)
+		}
+		source := corpusSources(text)
+		path := filepath.Join(dir, strings.TrimSuffix(filepath.Base(corpus), ".txt")+".ahk")
+		if err := os.WriteFile(path, source, 0o644); err != nil {
+			tb.Fatal(err)
+		}
+		paths = append(paths, path)
+		sources = append(sources, source)
+	}
+	return paths, sources
+}
+
+// corpusSources extracts the source of every test in a corpus file, each followed by a newline.
+func corpusSources(text []byte) []byte {
+	delimiter := func(line string, c byte) bool {
+		return len(line) >= 3 && strings.Trim(line[:3], string(c)) == ""
+	}
+	const (
+		beforeHeader = iota
+		inHeader
+		inSource
+		inExpected
+	)
+	var out bytes.Buffer
+	state := beforeHeader
+	for _, line := range strings.SplitAfter(string(text), "\n") {
+		trimmed := strings.TrimRight(line, "\r\n")
+		switch state {
+		case beforeHeader, inExpected:
+			if delimiter(trimmed, '=') {
+				state = inHeader
+			}
+		case inHeader:
+			if delimiter(trimmed, '=') {
+				state = inSource
+			}
+		case inSource:
+			if delimiter(trimmed, '-') {
+				out.WriteByte('\n')
+				state = inExpected
+			} else {
+				out.WriteString(line)
+			}
+		}
+	}
+	return out.Bytes()
+}
+
+func TestParserPool(t *testing.T) {
+	_, sources := corpusFiles(t)
+	parser := newParser(t)
+	want := make([]string, len(sources))
+	for i, source := range sources {
+		tree := parser.Parse(source, nil)
+		want[i] = tree.RootNode().ToSexp()
+		tree.Close()
+	}
+
+	pool := tree_sitter_autohotkey.NewParserPool()
+	var wg sync.WaitGroup
+	for g := 0; g < 8; g++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for i, source := range sources {
+				tree := pool.Parse(source, nil)
+				if got := tree.RootNode().ToSexp(); got != want[i] {
+					t.Errorf("pooled parse of source %d differs:\n%s\nwant\n%s", i, got, want[i])
+				}
+				tree.Close()
+			}
+		}()
+	}
+	wg.Wait()
+}
+
+// Parsers dropped from a pool are closed by a finalizer. Dropping whole pools and collecting while
+// other goroutines parse runs those finalizers next to live parses; run it with -race.
+func TestParserPoolFinalizers(t *testing.T) {
+	_, sources := corpusFiles(t)
+	var wg sync.WaitGroup
+	for g := 0; g < 4; g++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for i := 0; i < 50; i++ {
+				pool := tree_sitter_autohotkey.NewParserPool()
+				pool.Parse(sources[i%len(sources)], nil).Close()
+				runtime.GC()
+			}
+		}()
+	}
+	wg.Wait()
+	// sync.Pool keeps dropped items through one more collection before they become unreachable
+	runtime.GC()
+	runtime.GC()
+
+	pool := tree_sitter_autohotkey.NewParserPool()
+	tree := pool.Parse([]byte("x := 1\n"), nil)
+	defer tree.Close()
+	if root := tree.RootNode(); root.HasError() {
+		t.Errorf("parse after finalizers ran: %s", root.ToSexp())
+	}
+}
+
+func TestParseFiles(t *testing.T) {
+	paths, sources := corpusFiles(t)
+	pool := tree_sitter_autohotkey.NewParserPool()
+
+	missing := filepath.Join(t.TempDir(), "missing.ahk")
+	results := pool.ParseFiles(context.Background(), append(paths, missing))
+	for i, result := range results[:len(paths)] {
+		if result.Err != nil || result.Status != tree_sitter_autohotkey.ParseComplete {
+			t.Fatalf("%s: status %s, error %v", result.Path, result.Status, result.Err)
+		}
+		if !bytes.Equal(result.Source, sources[i]) || result.Path != paths[i] {
+			t.Errorf("result %d is for %s, want %s", i, result.Path, paths[i])
+		}
+		result.Tree.Close()
+	}
+	if err := results[len(paths)].Err; !errors.Is(err, fs.ErrNotExist) {
+		t.Errorf("missing file: got error %v", err)
+	}
+
+	ctx, cancel := context.WithCancel(context.Background())
+	cancel()
+	for _, result := range pool.ParseFiles(ctx, paths) {
+		if result.Status != tree_sitter_autohotkey.ParseCancelled || result.Tree != nil || result.Source != nil {
+			t.Errorf("%s: status %s after cancel", result.Path, result.Status)
+		}
+	}
+}
+
+// The benchmarks report MB/s over the corpus sources and allocs/op. Allocations only count the Go
+// side (the bindings' wrappers); the parse itself allocates in C, where the Go runtime can't see it.
+
+// BenchmarkParseNewParser creates a parser for every parse, as a service without a pool does.
+func BenchmarkParseNewParser(b *testing.B) {
+	_, sources := corpusFiles(b)
+	language := tree_sitter.NewLanguage(tree_sitter_autohotkey.Language())
+	b.SetBytes(totalBytes(sources))
+	b.ReportAllocs()
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		for _, source := range sources {
+			parser := tree_sitter.NewParser()
+			parser.SetLanguage(language)
+			parser.Parse(source, nil).Close()
+			parser.Close()
+		}
+	}
+}
+
+// BenchmarkParserPool parses from GOMAXPROCS goroutines sharing one pool.
+func BenchmarkParserPool(b *testing.B) {
+	_, sources := corpusFiles(b)
+	pool := tree_sitter_autohotkey.NewParserPool()
+	b.SetBytes(totalBytes(sources))
+	b.ReportAllocs()
+	b.ResetTimer()
+	b.RunParallel(func(pb *testing.PB) {
+		for pb.Next() {
+			for _, source := range sources {
+				pool.Parse(source, nil).Close()
+			}
+		}
+	})
+}
+
+// BenchmarkParseFiles reads and parses the corpus sources from disk with ParseFiles.
+func BenchmarkParseFiles(b *testing.B) {
+	paths, sources := corpusFiles(b)
+	pool := tree_sitter_autohotkey.NewParserPool()
+	b.SetBytes(totalBytes(sources))
+	b.ReportAllocs()
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		for _, result := range pool.ParseFiles(context.Background(), paths) {
+			if result.Err != nil {
+				b.Fatal(result.Err)
+			}
+			result.Tree.Close()
+		}
+	}
+}
+
+func totalBytes(sources [][]byte) int64 {
+	var total int64
+	for _, source := range sources {
+		total += int64(len(source))
+	}
+	return total
+}
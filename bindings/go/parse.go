@@ -0,0 +1,82 @@
+package tree_sitter_autohotkey
+
+import (
+	"context"
+	"errors"
+
+	tree_sitter "github.com/tree-sitter/go-tree-sitter"
+)
+
+// ParseStatus says how a parse started by ParseContext ended.
+type ParseStatus int
+
+const (
+	// ParseComplete means the parser reached the end of the input and returned a tree.
+	ParseComplete ParseStatus = iota
+	// ParseTimedOut means the context's deadline passed first.
+	ParseTimedOut
+	// ParseCancelled means the context was cancelled first.
+	ParseCancelled
+)
+
+func (s ParseStatus) String() string {
+	switch s {
+	case ParseTimedOut:
+		return "timeout"
+	case ParseCancelled:
+		return "cancelled"
+	default:
+		return "complete"
+	}
+}
+
+// ParseResult is what ParseContext returns.
+type ParseResult struct {
+	// Tree is the syntax tree, or nil if the parse was stopped. The caller must Close it.
+	Tree *tree_sitter.Tree
+	// Status says whether the parse completed, or why it didn't.
+	Status ParseStatus
+	// BytesParsed is how far into the source the parser got: all of it, when complete.
+	BytesParsed uint32
+}
+
+// ParseContext parses source with parser, which must have this grammar's language set, and stops
+// early if ctx is done. The runtime polls ctx every few hundred parse steps, so a deadline or
+// cancellation takes effect mid-parse, not just between parses.
+//
+// A stopped parse leaves no tree. The parser is reset afterwards, so its next parse starts from
+// scratch rather than trying to resume this one.
+func ParseContext(ctx context.Context, parser *tree_sitter.Parser, source []byte, oldTree *tree_sitter.Tree) ParseResult {
+	var stop error
+	var offset uint32
+	read := func(i int, _ tree_sitter.Point) []byte {
+		if i >= len(source) {
+			return nil
+		}
+		return source[i:]
+	}
+	options := &tree_sitter.ParseOptions{
+		ProgressCallback: func(state tree_sitter.ParseState) bool {
+			offset = state.CurrentByteOffset
+			stop = ctx.Err()
+			return stop != nil
+		},
+	}
+
+	if stop = ctx.Err(); stop == nil {
+		if tree := parser.ParseWithOptions(read, oldTree, options); tree != nil {
+			return ParseResult{Tree: tree, Status: ParseComplete, BytesParsed: uint32(len(source))}
+		}
+	}
+	parser.Reset()
+	return stopped(stop, offset)
+}
+
+// stopped is the result of a parse that ctx.Err() returned stop for, after offset bytes.
+func stopped(stop error, offset uint32) ParseResult {
+	status := ParseCancelled
+	if errors.Is(stop, context.DeadlineExceeded) {
+		status = ParseTimedOut
+	}
+	return ParseResult{Status: status, BytesParsed: offset}
+}
@@ -0,0 +1,99 @@
+package tree_sitter_autohotkey
+
+import (
+	"context"
+	"os"
+	"runtime"
+	"sync"
+	"sync/atomic"
+
+	tree_sitter "github.com/tree-sitter/go-tree-sitter"
+)
+
+// ParserPool hands out parsers with this grammar's language already set, so a service can parse
+// each request without paying for a new parser. It's safe to use from many goroutines at once; each
+// parser is only ever used by the goroutine that took it.
+//
+// The pool is backed by sync.Pool, so idle parsers are dropped under memory pressure. A parser is
+// C memory the garbage collector can't see, so dropped ones are closed by a finalizer.
+type ParserPool struct {
+	pool sync.Pool
+}
+
+type pooledParser struct {
+	parser *tree_sitter.Parser
+}
+
+// NewParserPool returns an empty pool; parsers are created as they're first needed.
+func NewParserPool() *ParserPool {
+	language := tree_sitter.NewLanguage(Language())
+	p := &ParserPool{}
+	p.pool.New = func() any {
+		parser := tree_sitter.NewParser()
+		if err := parser.SetLanguage(language); err != nil {
+			// Only a runtime too old for the grammar's ABI gets here, and then no parser works
+			panic(err)
+		}
+		pooled := &pooledParser{parser}
+		runtime.SetFinalizer(pooled, func(pooled *pooledParser) { pooled.parser.Close() })
+		return pooled
+	}
+	return p
+}
+
+// Parse parses source with a parser from the pool. The caller must Close the tree.
+func (p *ParserPool) Parse(source []byte, oldTree *tree_sitter.Tree) *tree_sitter.Tree {
+	pooled := p.pool.Get().(*pooledParser)
+	defer p.pool.Put(pooled)
+	return pooled.parser.Parse(source, oldTree)
+}
+
+// ParseContext is the package-level ParseContext, with a parser from the pool.
+func (p *ParserPool) ParseContext(ctx context.Context, source []byte, oldTree *tree_sitter.Tree) ParseResult {
+	pooled := p.pool.Get().(*pooledParser)
+	defer p.pool.Put(pooled)
+	return ParseContext(ctx, pooled.parser, source, oldTree)
+}
+
+// FileResult is one file's result from ParseFiles.
+type FileResult struct {
+	Path string
+	// Source is the file's contents, which the tree's nodes point into.
+	Source []byte
+	ParseResult
+	// Err is set if the file couldn't be read, and the rest is then empty.
+	Err error
+}
+
+// ParseFiles reads and parses the files at paths, spread over GOMAXPROCS goroutines, and returns
+// their results in the same order. Once ctx is done, the parses in progress stop and the files not
+// yet started are reported as stopped without being read. The caller must Close every tree.
+func (p *ParserPool) ParseFiles(ctx context.Context, paths []string) []FileResult {
+	results := make([]FileResult, len(paths))
+	workers := min(runtime.GOMAXPROCS(0), len(paths))
+	var next atomic.Int64
+	var wg sync.WaitGroup
+	wg.Add(workers)
+	for w := 0; w < workers; w++ {
+		go func() {
+			defer wg.Done()
+			for i := int(next.Add(1) - 1); i < len(paths); i = int(next.Add(1) - 1) {
+				results[i] = p.parseFile(ctx, paths[i])
+			}
+		}()
+	}
+	wg.Wait()
+	return results
+}
+
+func (p *ParserPool) parseFile(ctx context.Context, path string) FileResult {
+	result := FileResult{Path: path}
+	if err := ctx.Err(); err != nil {
+		result.ParseResult = stopped(err, 0)
+		return result
+	}
+	if result.Source, result.Err = os.ReadFile(path); result.Err == nil {
+		result.ParseResult = p.ParseContext(ctx, result.Source, nil)
+	}
+	return result
+}
@@ -9,10 +9,368 @@ const napi_type_tag LANGUAGE_TYPE_TAG = {
     0x8AF2E5212AD58ABF, 0xD5006CAD83ABBA16
 };
 
+#ifdef TREE_SITTER_AHK_PARSE_ASYNC
+// Off-thread parsing, compiled in when binding.gyp finds the tree-sitter runtime (see its runtime_dir). Each call is an
+// AsyncWorker on the libuv thread pool, so up to UV_THREADPOOL_SIZE parses run at once and the event loop only sees
+// the copy of the input going in and the result object coming out. With `binary`, the pool thread also writes the tree
+// out with tree_sitter_autohotkey_export (bindings/c/export.c), and the event loop just copies it into an ArrayBuffer.
+
+#include <tree_sitter/api.h>
+#include <tree_sitter/tree-sitter-autohotkey-export.h>
+#include <uv.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// One parser per pool thread, created by the first parse that thread runs and reused by every later one.
+TSParser *ThreadParser() {
+    thread_local struct Holder {
+        TSParser *parser = nullptr;
+        ~Holder() {
+            if (parser) ts_parser_delete(parser);
+        }
+    } holder;
+    if (!holder.parser) {
+        holder.parser = ts_parser_new();
+        ts_parser_set_language(holder.parser, tree_sitter_autohotkey());
+    }
+    return holder.parser;
+}
+
+// Reads a whole file with libuv's synchronous calls (we're on a pool thread already). Returns 0 or a libuv error.
+int ReadFile(const std::string &path, std::string &out) {
+    uv_fs_t req;
+    int fd = uv_fs_open(nullptr, &req, path.c_str(), UV_FS_O_RDONLY, 0, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (fd < 0) return fd;
+
+    int result = uv_fs_fstat(nullptr, &req, fd, nullptr);
+    size_t size = result == 0 ? static_cast<size_t>(req.statbuf.st_size) : 0;
+    uv_fs_req_cleanup(&req);
+
+    out.resize(size);
+    size_t length = 0;
+    while (result >= 0) {
+        if (length == out.size()) out.resize(out.size() ? out.size() * 2 : 65536);  // grown since fstat, or no size
+        uv_buf_t buf = uv_buf_init(&out[length], static_cast<unsigned int>(out.size() - length));
+        result = uv_fs_read(nullptr, &req, fd, &buf, 1, -1, nullptr);
+        uv_fs_req_cleanup(&req);
+        if (result <= 0) break;
+        length += static_cast<size_t>(result);
+    }
+    out.resize(length);
+
+    uv_fs_close(nullptr, &req, fd, nullptr);
+    uv_fs_req_cleanup(&req);
+    return result < 0 ? result : 0;
+}
+
+// Length of the byte order mark `source` starts with, if any, and the encoding it names. Without one the text is taken
+// to be UTF-8, as AutoHotkey itself does by default.
+uint32_t DetectBom(const std::string &source, TSInputEncoding &encoding) {
+    encoding = TSInputEncodingUTF8;
+    if (source.compare(0, 3, "\xEF\xBB\xBF") == 0) return 3;
+    if (source.compare(0, 2, "\xFF\xFE") == 0) encoding = TSInputEncodingUTF16LE;
+    else if (source.compare(0, 2, "\xFE\xFF") == 0) encoding = TSInputEncodingUTF16BE;
+    else return 0;
+    return 2;
+}
+
+/// The source after its BOM, as a TSInput payload
+struct Text {
+    const char *data;
+    uint32_t length;
+
+    static const char *Read(void *payload, uint32_t byte, TSPoint, uint32_t *bytes_read) {
+        auto *text = static_cast<Text *>(payload);
+        *bytes_read = byte < text->length ? text->length - byte : 0;
+        return *bytes_read ? text->data + byte : "";
+    }
+};
+
+/// How a parse ended, as reported in ParseResult.status
+enum class Status { kComplete, kTimeout, kCancelled };
+
+const char *StatusName(Status status) {
+    switch (status) {
+        case Status::kTimeout: return "timeout";
+        case Status::kCancelled: return "cancelled";
+        default: return "complete";
+    }
+}
+
+/// Polled by the runtime every few hundred parse steps, through TSParseOptions' progress callback
+struct Budget {
+    uint64_t deadline_ns;  // uv_hrtime() value to stop at, or 0 for none
+    const std::atomic<bool> *cancelled;
+    Status status = Status::kComplete;
+    uint32_t offset = 0;  // how far the parse had read when it stopped
+
+    static bool Progress(TSParseState *state) {
+        auto *budget = static_cast<Budget *>(state->payload);
+        budget->offset = state->current_byte_offset;
+        if (budget->cancelled->load(std::memory_order_relaxed)) budget->status = Status::kCancelled;
+        else if (budget->deadline_ns && uv_hrtime() >= budget->deadline_ns) budget->status = Status::kTimeout;
+        return budget->status != Status::kComplete;
+    }
+};
+
+struct Options {
+    bool sexp = true;
+    bool binary = false;
+    uint64_t timeout_ns = 0;
+    Napi::Object signal;  // an AbortSignal, or empty
+};
+
+class ParseWorker : public Napi::AsyncWorker {
+  public:
+    /// Parses `source`, or the file at `path` if it isn't empty
+    ParseWorker(Napi::Env env, std::string source, std::string path, const Options &options)
+        : Napi::AsyncWorker(env, "tree-sitter-autohotkey:parse"),
+          deferred_(Napi::Promise::Deferred::New(env)),
+          source_(std::move(source)),
+          path_(std::move(path)),
+          want_sexp_(options.sexp),
+          want_binary_(options.binary),
+          timeout_ns_(options.timeout_ns) {
+        if (!options.signal.IsEmpty()) Listen(options.signal);
+    }
+
+    Napi::Promise Promise() const { return deferred_.Promise(); }
+
+  protected:
+    void Execute() override {
+        if (cancelled_->load()) {
+            status_ = Status::kCancelled;
+            return;
+        }
+        if (!path_.empty() && (uv_error_ = ReadFile(path_, source_)) != 0) {
+            SetError(std::string(uv_strerror(uv_error_)) + ", open '" + path_ + "'");
+            return;
+        }
+        if (source_.size() > UINT32_MAX) {
+            SetError("input is larger than 4 GiB");
+            return;
+        }
+
+        // The mark isn't part of the text: the grammar has no token for it, so it would start the tree with an ERROR.
+        TSInputEncoding encoding;
+        uint32_t bom = DetectBom(source_, encoding);
+        Text text{source_.data() + bom, static_cast<uint32_t>(source_.size()) - bom};
+        Budget budget{timeout_ns_ ? uv_hrtime() + timeout_ns_ : 0, cancelled_.get()};
+        TSParser *parser = ThreadParser();
+        TSTree *tree = ts_parser_parse_with_options(parser, nullptr, TSInput{&text, Text::Read, encoding, nullptr},
+                                                    TSParseOptions{&budget, Budget::Progress});
+        bytes_parsed_ = bom + text.length;
+        if (!tree && budget.status != Status::kComplete) {
+            // Otherwise the parser would try to resume this parse on whatever input it's given next
+            ts_parser_reset(parser);
+            status_ = budget.status;
+            bytes_parsed_ = bom + budget.offset;
+            return;
+        }
+        if (!tree) {
+            SetError("parse failed");
+            return;
+        }
+        TSNode root = ts_tree_root_node(tree);
+        CollectErrors(root, bom);
+        if (want_sexp_) {
+            char *sexp = ts_node_string(root);
+            sexp_ = sexp;
+            free(sexp);
+        }
+        if (want_binary_) {
+            // operator new's alignment is enough for the export's 8-byte records
+            size_t size = tree_sitter_autohotkey_export(root, nullptr, 0);
+            tree_.resize(size);
+            if (!size || !tree_sitter_autohotkey_export(root, tree_.data(), size)) {
+                ts_tree_delete(tree);
+                SetError("can't export the tree, it may be too large for the format");
+                return;
+            }
+        }
+        ts_tree_delete(tree);
+        source_.clear();
+        source_.shrink_to_fit();
+    }
+
+    void OnOK() override {
+        Unlisten();
+        Napi::Env env = Env();
+        Napi::Object result = Napi::Object::New(env);
+        bool complete = status_ == Status::kComplete;
+        result["sexp"] = want_sexp_ && complete ? Napi::Value(Napi::String::New(env, sexp_)) : env.Null();
+        if (want_binary_ && complete) {
+            Napi::ArrayBuffer tree = Napi::ArrayBuffer::New(env, tree_.size());
+            std::memcpy(tree.Data(), tree_.data(), tree_.size());
+            result["tree"] = tree;
+        } else {
+            result["tree"] = env.Null();
+        }
+        result["errorCount"] = Napi::Number::New(env, static_cast<double>(spans_.size() / 2));
+        Napi::Uint32Array spans = Napi::Uint32Array::New(env, spans_.size());
+        for (size_t i = 0; i < spans_.size(); i++) spans[i] = spans_[i];
+        result["errorSpans"] = spans;
+        result["status"] = Napi::String::New(env, StatusName(status_));
+        result["bytesParsed"] = Napi::Number::New(env, bytes_parsed_);
+        deferred_.Resolve(result);
+    }
+
+    void OnError(const Napi::Error &error) override {
+        Unlisten();
+        Napi::Object value = error.Value();
+        if (uv_error_ != 0) {
+            value["code"] = Napi::String::New(Env(), uv_err_name(uv_error_));
+            value["path"] = Napi::String::New(Env(), path_);
+        }
+        deferred_.Reject(value);
+    }
+
+  private:
+    /// Sets `cancelled_` when `signal` aborts, until the parse is done; already aborted, it's set right away
+    void Listen(Napi::Object signal) {
+        if (signal.Get("aborted").ToBoolean()) {
+            cancelled_->store(true);
+            return;
+        }
+        std::shared_ptr<std::atomic<bool>> cancelled = cancelled_;
+        Napi::Function on_abort =
+            Napi::Function::New(Env(), [cancelled](const Napi::CallbackInfo &) { cancelled->store(true); });
+        signal.Get("addEventListener").As<Napi::Function>().Call(signal, {Napi::String::New(Env(), "abort"), on_abort});
+        signal_ = Napi::Persistent(signal);
+        on_abort_ = Napi::Persistent(on_abort);
+    }
+
+    void Unlisten() {
+        if (signal_.IsEmpty()) return;
+        Napi::Object signal = signal_.Value();
+        signal.Get("removeEventListener")
+            .As<Napi::Function>()
+            .Call(signal, {Napi::String::New(Env(), "abort"), on_abort_.Value()});
+        signal_.Reset();
+        on_abort_.Reset();
+    }
+
+    /// Start and end bytes of ERROR and MISSING nodes, skipping subtrees without errors and those nested in an ERROR.
+    /// Offsets are into the input, so they count the `bom` bytes the parser didn't see.
+    void CollectErrors(TSNode root, uint32_t bom) {
+        if (!ts_node_has_error(root)) return;
+        TSTreeCursor cursor = ts_tree_cursor_new(root);
+        for (;;) {
+            TSNode node = ts_tree_cursor_current_node(&cursor);
+            bool descend = ts_node_has_error(node);
+            if (ts_node_is_error(node) || ts_node_is_missing(node)) {
+                spans_.push_back(bom + ts_node_start_byte(node));
+                spans_.push_back(bom + ts_node_end_byte(node));
+                descend = false;
+            }
+            if (descend && ts_tree_cursor_goto_first_child(&cursor)) continue;
+            while (!ts_tree_cursor_goto_next_sibling(&cursor)) {
+                if (!ts_tree_cursor_goto_parent(&cursor)) {
+                    ts_tree_cursor_delete(&cursor);
+                    return;
+                }
+            }
+        }
+    }
+
+    Napi::Promise::Deferred deferred_;
+    std::string source_;
+    std::string path_;
+    bool want_sexp_;
+    bool want_binary_;
+    uint64_t timeout_ns_;
+    // Shared with the abort listener, which can outlive the worker until it's garbage collected
+    std::shared_ptr<std::atomic<bool>> cancelled_ = std::make_shared<std::atomic<bool>>(false);
+    Napi::ObjectReference signal_;
+    Napi::FunctionReference on_abort_;
+    Status status_ = Status::kComplete;
+    uint32_t bytes_parsed_ = 0;
+    int uv_error_ = 0;
+    std::string sexp_;
+    std::vector<uint8_t> tree_;
+    std::vector<uint32_t> spans_;
+};
+
+/// Reads { sexp, binary, timeoutMs, signal } from the second argument, if it's an object
+Options ParseOptions(const Napi::CallbackInfo &info) {
+    Options options;
+    if (info.Length() < 2 || !info[1].IsObject()) return options;
+    Napi::Env env = info.Env();
+    Napi::Object object = info[1].As<Napi::Object>();
+
+    Napi::Value sexp = object.Get("sexp");
+    options.sexp = sexp.IsUndefined() || sexp.ToBoolean();
+    options.binary = object.Get("binary").ToBoolean();
+
+    Napi::Value timeout = object.Get("timeoutMs");
+    if (!timeout.IsUndefined()) {
+        double ms = timeout.IsNumber() ? timeout.As<Napi::Number>().DoubleValue() : -1;
+        if (!(ms >= 0) || ms > 1e12) throw Napi::TypeError::New(env, "timeoutMs must be a non-negative number");
+        options.timeout_ns = ms > 0 ? static_cast<uint64_t>(ms * 1e6) : 0;
+    }
+
+    Napi::Value signal = object.Get("signal");
+    if (!signal.IsUndefined()) {
+        if (!signal.IsObject() || !signal.As<Napi::Object>().Get("addEventListener").IsFunction()) {
+            throw Napi::TypeError::New(env, "signal must be an AbortSignal");
+        }
+        options.signal = signal.As<Napi::Object>();
+    }
+    return options;
+}
+
+/// parseAsync(source: string | Uint8Array, options?: ParseOptions): Promise<ParseResult>
+Napi::Value ParseAsync(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    std::string source;
+    if (info.Length() > 0 && info[0].IsString()) {
+        source = info[0].As<Napi::String>().Utf8Value();
+    } else if (info.Length() > 0 && info[0].IsTypedArray() &&
+               info[0].As<Napi::TypedArray>().TypedArrayType() == napi_uint8_array) {
+        // Copied, so the caller may reuse the buffer as soon as this returns.
+        Napi::Uint8Array bytes = info[0].As<Napi::Uint8Array>();
+        source.assign(reinterpret_cast<const char *>(bytes.Data()), bytes.ElementLength());
+    } else {
+        throw Napi::TypeError::New(env, "parseAsync expects a string or a Uint8Array (such as a Buffer)");
+    }
+    auto *worker = new ParseWorker(env, std::move(source), std::string(), ParseOptions(info));
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();
+    return promise;
+}
+
+/// parseFileAsync(path: string, options?: ParseOptions): Promise<ParseResult>
+Napi::Value ParseFileAsync(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString() || info[0].As<Napi::String>().Utf8Value().empty()) {
+        throw Napi::TypeError::New(env, "parseFileAsync expects a path");
+    }
+    auto *worker = new ParseWorker(env, std::string(), info[0].As<Napi::String>().Utf8Value(), ParseOptions(info));
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();
+    return promise;
+}
+
+}  // namespace
+#endif
+
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
     auto language = Napi::External<TSLanguage>::New(env, tree_sitter_autohotkey());
     language.TypeTag(&LANGUAGE_TYPE_TAG);
     exports["language"] = language;
+#ifdef TREE_SITTER_AHK_PARSE_ASYNC
+    exports["parseAsync"] = Napi::Function::New(env, ParseAsync, "parseAsync");
+    exports["parseFileAsync"] = Napi::Function::New(env, ParseFileAsync, "parseFileAsync");
+#endif
     return exports;
 }
 
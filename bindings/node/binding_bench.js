@@ -0,0 +1,89 @@
+// Throughput and event-loop latency of the addon's off-thread parsing (parseAsync / parseFiles).
+//
+// Parses the test corpus files (or the given files), repeated, through parseFiles, and reports MB/s and per-file
+// latency. Then parses one large input a few times on the event loop with the `tree-sitter` package, and again through
+// parseAsync, sampling the loop's delay meanwhile: the synchronous parse stalls the loop for the whole parse, the
+// asynchronous one only for copying the input in and the result out.
+//
+//   node bindings/node/binding_bench.js [--repeat N] [FILE...]
+//   UV_THREADPOOL_SIZE=8 node bindings/node/binding_bench.js
+import { readdirSync, readFileSync, statSync } from "node:fs";
+import { monitorEventLoopDelay, performance } from "node:perf_hooks";
+import { fileURLToPath } from "node:url";
+import { parseArgs } from "node:util";
+
+const { default: binding } = await import("./index.js");
+if (typeof binding.parseFiles !== "function") {
+  console.error("The addon was built without the tree-sitter runtime; see runtime_dir in binding.gyp.");
+  process.exit(1);
+}
+
+const { values, positionals } = parseArgs({
+  options: { repeat: { type: "string", default: "20" } },
+  allowPositionals: true,
+});
+const repeat = Number(values.repeat);
+
+const corpus = fileURLToPath(new URL("../../test/corpus/", import.meta.url));
+const files = positionals.length
+  ? positionals
+  : readdirSync(corpus).filter((f) => f.endsWith(".txt")).map((f) => corpus + f);
+const paths = Array.from({ length: repeat }, () => files).flat();
+const bytes = paths.reduce((sum, p) => sum + statSync(p).size, 0);
+
+const ms = (ns) => (ns / 1e6).toFixed(2);
+const percentile = (sorted, p) => sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+
+console.log(`libuv pool: ${process.env.UV_THREADPOOL_SIZE ?? 4} threads`);
+
+// --- Throughput ----------------------------------------------------------------------------------------------------
+await binding.parseFiles(files, { sexp: false }); // warm up every pool thread's parser
+const latencies = [];
+const started = performance.now();
+await Promise.all(
+  paths.map(async (path) => {
+    const t = performance.now();
+    await binding.parseFileAsync(path, { sexp: false });
+    latencies.push((performance.now() - t) * 1e6);
+  }),
+);
+const seconds = (performance.now() - started) / 1000;
+latencies.sort((a, b) => a - b);
+console.log(
+  `parseFiles: ${paths.length} files, ${(bytes / 1e6).toFixed(1)} MB in ${seconds.toFixed(2)} s = ` +
+    `${(bytes / 1e6 / seconds).toFixed(1)} MB/s; per file p50 ${ms(percentile(latencies, 0.5))} ms, ` +
+    `p99 ${ms(percentile(latencies, 0.99))} ms`,
+);
+
+// --- Event-loop delay ----------------------------------------------------------------------------------------------
+const large = Buffer.concat(files.map((f) => readFileSync(f)));
+const big = Buffer.concat(Array.from({ length: Math.max(1, Math.ceil(4e6 / large.length)) }, () => large));
+
+async function loopDelay(label, run) {
+  const histogram = monitorEventLoopDelay({ resolution: 1 });
+  histogram.enable();
+  // Keep the loop busy with timers so stalls show up as delay.
+  const ticker = setInterval(() => {}, 1);
+  for (let i = 0; i < 5; i++) await run();
+  clearInterval(ticker);
+  histogram.disable();
+  console.log(
+    `${label}: loop delay p50 ${ms(histogram.percentile(50))} ms, p99 ${ms(histogram.percentile(99))} ms, ` +
+      `max ${ms(histogram.max)} ms`,
+  );
+}
+
+console.log(`\n${(big.length / 1e6).toFixed(1)} MB input, parsed 5 times:`);
+try {
+  const { default: Parser } = await import("tree-sitter");
+  const parser = new Parser();
+  parser.setLanguage(binding);
+  const text = big.toString("utf8");
+  await loopDelay("tree-sitter Parser.parse (on the loop)", async () => {
+    parser.parse(text);
+    await new Promise((resolve) => setImmediate(resolve));
+  });
+} catch {
+  console.log("tree-sitter package not installed; skipping the synchronous baseline");
+}
+await loopDelay("parseAsync (pool)", () => binding.parseAsync(big, { sexp: false }));
@@ -1,5 +1,7 @@
 import assert from "node:assert";
+import { readFileSync } from "node:fs";
 import { test } from "node:test";
+import { fileURLToPath } from "node:url";
 import Parser from "tree-sitter";
 
 test("can load grammar", () => {
@@ -9,3 +11,181 @@ test("can load grammar", () => {
     parser.setLanguage(language);
   });
 });
+
+const { default: binding } = await import("./index.js");
+const noRuntime = typeof binding.parseAsync !== "function" && "built without the tree-sitter runtime";
+
+test("parseAsync matches a synchronous parse", { skip: noRuntime }, async () => {
+  const parser = new Parser();
+  parser.setLanguage(binding);
+  const sources = ['x := 1\n', 'MsgBox("hi")\n', "class A {\n}\n"];
+  const results = await Promise.all(sources.map((s, i) => binding.parseAsync(i % 2 ? Buffer.from(s) : s)));
+  results.forEach((result, i) => {
+    assert.strictEqual(result.sexp, parser.parse(sources[i]).rootNode.toString());
+    assert.strictEqual(result.errorCount, 0);
+    assert.strictEqual(result.errorSpans.length, 0);
+  });
+});
+
+test("parseAsync reports errors", { skip: noRuntime }, async () => {
+  const result = await binding.parseAsync("x := (\n", { sexp: false });
+  assert.strictEqual(result.sexp, null);
+  assert.ok(result.errorCount > 0);
+  assert.strictEqual(result.errorSpans.length, result.errorCount * 2);
+});
+
+test("parseAsync skips byte order marks and reads UTF-16", { skip: noRuntime }, async () => {
+  const source = 'x := "é"\nMsgBox(x\n';
+  const utf16be = Buffer.from(source, "utf16le").swap16();
+  const [plain, string, utf8, utf16le, be] = await Promise.all([
+    binding.parseAsync(source),
+    binding.parseAsync(`\ufeff${source}`),
+    binding.parseAsync(Buffer.concat([Buffer.from([0xef, 0xbb, 0xbf]), Buffer.from(source)])),
+    binding.parseAsync(Buffer.concat([Buffer.from([0xff, 0xfe]), Buffer.from(source, "utf16le")])),
+    binding.parseAsync(Buffer.concat([Buffer.from([0xfe, 0xff]), utf16be])),
+  ]);
+  assert.ok(plain.errorCount > 0);
+  for (const result of [string, utf8, utf16le, be]) {
+    assert.strictEqual(result.sexp, plain.sexp);
+    assert.strictEqual(result.errorCount, plain.errorCount);
+  }
+  assert.deepStrictEqual([...utf8.errorSpans], [...plain.errorSpans].map((offset) => offset + 3));
+});
+
+test("parseAsync exports the tree", { skip: noRuntime }, async () => {
+  const parser = new Parser();
+  parser.setLanguage(binding);
+  const source = "class A {\n    F(x) => x\n}\n";
+  const root = parser.parse(source).rootNode;
+  const [result, withBom, plain] = await Promise.all([
+    binding.parseAsync(source, { binary: true, sexp: false }),
+    binding.parseAsync(`\ufeff${source}`, { binary: true }),
+    binding.parseAsync(source),
+  ]);
+  assert.strictEqual(plain.tree, null);
+  assert.deepStrictEqual(new Uint8Array(withBom.tree), new Uint8Array(result.tree));
+
+  // See TSAutohotkeyExportHeader and TSAutohotkeyExportNode
+  const header = new Uint32Array(result.tree, 8, 14);
+  const [, , , nodeSize, , symbols, fields, stringsOffset, , count, nodesOffset, total] = header;
+  assert.strictEqual(new TextDecoder().decode(new Uint8Array(result.tree, 0, 7)), "AHKTREE");
+  assert.deepStrictEqual([count, total], [root.descendantCount, result.tree.byteLength]);
+  const offsets = new Uint32Array(result.tree, stringsOffset, symbols + fields + 2);
+  const names = stringsOffset + offsets.byteLength;
+  const name = (i) =>
+    new TextDecoder().decode(new Uint8Array(result.tree, names + offsets[i], offsets[i + 1] - offsets[i] - 1));
+  const node = (i) => ({
+    halves: new Uint16Array(result.tree, nodesOffset + i * nodeSize, 4),
+    words: new Uint32Array(result.tree, nodesOffset + i * nodeSize + 8, 6),
+  });
+
+  const top = node(0);
+  assert.strictEqual(name(top.halves[0]), "source_file");
+  assert.deepStrictEqual([...top.words], [root.startIndex, root.endIndex, 0xffffffff, 1, 0xffffffff, count]);
+  // Follow the class's children to the one in its "name" field
+  let child = node(node(1).words[3]);
+  while (name(symbols + child.halves[1]) !== "name") child = node(child.words[4]);
+  assert.strictEqual(name(child.halves[0]), "identifier");
+  assert.strictEqual(source.slice(child.words[0], child.words[1]), "A");
+});
+
+const NONE = 0xffffffff;
+
+/** Every node record in an exported tree as an array, with its type and field names looked up. */
+function decodeExport(buffer) {
+  const [, , , nodeSize, , symbols, fields, stringsOffset, , count, nodesOffset] = new Uint32Array(buffer, 8, 14);
+  const offsets = new Uint32Array(buffer, stringsOffset, symbols + fields + 2);
+  const names = stringsOffset + offsets.byteLength;
+  const name = (i) =>
+    new TextDecoder().decode(new Uint8Array(buffer, names + offsets[i], offsets[i + 1] - offsets[i] - 1));
+  const nodes = [];
+  for (let i = 0; i < count; i++) {
+    const [symbol, field, flags] = new Uint16Array(buffer, nodesOffset + i * nodeSize, 3);
+    nodes.push([name(symbol), name(symbols + field), flags, ...new Uint32Array(buffer, nodesOffset + i * nodeSize + 8, 6)]);
+  }
+  return nodes;
+}
+
+/** What decodeExport should return for `tree`, built from a cursor walk. */
+function exportOf(tree, source) {
+  // The tree counts UTF-16 code units and the export UTF-8 bytes
+  const utf8At = [0];
+  for (let i = 0; i < source.length; i++) {
+    const code = source.charCodeAt(i);
+    const low = code >= 0xdc00 && code < 0xe000;
+    utf8At.push(utf8At[i] + (code < 0x80 ? 1 : code < 0x800 ? 2 : low ? 1 : 3));
+  }
+  const nodes = [];
+  const stack = [];
+  const cursor = tree.walk();
+  for (;;) {
+    const node = cursor.currentNode;
+    const index = nodes.length;
+    const flags = (node.isNamed ? 1 : 0) | (node.isError ? 2 : 0) | (node.isMissing ? 4 : 0) |
+      (node.isExtra ? 8 : 0) | (node.hasError ? 16 : 0);
+    const parent = stack.length ? stack[stack.length - 1] : NONE;
+    nodes.push([node.type, cursor.currentFieldName ?? "", flags, utf8At[node.startIndex], utf8At[node.endIndex],
+      parent, NONE, NONE, 0]);
+    if (stack.length && nodes[parent][6] === NONE) nodes[parent][6] = index;
+    stack.push(index);
+    if (cursor.gotoFirstChild()) continue;
+    for (;;) {
+      const done = stack.pop();
+      nodes[done][8] = nodes.length;
+      if (stack.length && cursor.gotoNextSibling()) {
+        nodes[done][7] = nodes.length;
+        break;
+      }
+      if (!stack.length) return nodes;
+      cursor.gotoParent();
+    }
+  }
+}
+
+test("parseAsync's export round-trips", { skip: noRuntime }, async () => {
+  // A whole corpus file, headers and expected trees included, so the tree has errors and missing nodes too
+  const source = readFileSync(new URL("../../test/corpus/realworld-gui-example.txt", import.meta.url), "utf8");
+  const parser = new Parser();
+  parser.setLanguage(binding);
+  const tree = parser.parse(source);
+  const { tree: buffer } = await binding.parseAsync(source, { binary: true, sexp: false });
+  assert.deepStrictEqual(decodeExport(buffer), exportOf(tree, source));
+});
+
+test("parseFiles reads files", { skip: noRuntime }, async () => {
+  const corpus = fileURLToPath(new URL("../../test/corpus/functions.txt", import.meta.url));
+  const [result] = await binding.parseFiles([corpus], { sexp: false });
+  assert.strictEqual(typeof result.errorCount, "number");
+  await assert.rejects(binding.parseFiles([`${corpus}.missing`]), { code: "ENOENT" });
+});
+
+test("parseAsync stops at timeoutMs", { skip: noRuntime }, async () => {
+  const source = "x := [1, 2, (3 + 4) * 5]\n".repeat(200_000);
+  const result = await binding.parseAsync(source, { timeoutMs: 1 });
+  assert.strictEqual(result.status, "timeout");
+  assert.strictEqual(result.sexp, null);
+  assert.ok(result.bytesParsed < source.length);
+
+  const small = await binding.parseAsync("x := 1\n", { timeoutMs: 10_000 });
+  assert.strictEqual(small.status, "complete");
+  assert.strictEqual(small.bytesParsed, 7);
+  assert.throws(() => binding.parseAsync(source, { timeoutMs: -1 }), TypeError);
+});
+
+test("parseAsync stops when its signal aborts", { skip: noRuntime }, async () => {
+  const source = "x := [1, 2, (3 + 4) * 5]\n".repeat(200_000);
+  const controller = new AbortController();
+  const pending = binding.parseAsync(source, { signal: controller.signal });
+  setImmediate(() => controller.abort());
+  const result = await pending;
+  assert.strictEqual(result.status, "cancelled");
+  assert.strictEqual(result.sexp, null);
+
+  const aborted = await binding.parseFiles(["missing.ahk"], { signal: AbortSignal.abort() });
+  assert.deepStrictEqual([aborted[0].status, aborted[0].bytesParsed], ["cancelled", 0]);
+
+  // The parser a stopped parse left behind is reset, so the next one on that thread starts afresh
+  const after = await binding.parseAsync("x := 1\n");
+  assert.strictEqual(after.status, "complete");
+  assert.strictEqual(after.errorCount, 0);
+});
@@ -18,6 +18,47 @@ type NodeInfo =
       children: ChildNode[];
     });
 
+/** The result of parsing one input with `parseAsync`, `parseFileAsync` or `parseFiles`. */
+type ParseResult = {
+  /**
+   * Whether the parse ran to the end of the input, or was stopped by `timeoutMs` or `signal`. A
+   * stopped parse has no tree, so `sexp` is null and there are no errors to report.
+   */
+  status: "complete" | "timeout" | "cancelled";
+  /**
+   * How far into the input (in bytes, byte order mark included) the parser got: the whole input
+   * when complete, 0 when cancelled before it started.
+   */
+  bytesParsed: number;
+  /** The root node's S-expression, or null if `sexp: false` was passed or the parse was stopped. */
+  sexp: string | null;
+  /** ERROR and MISSING nodes in the tree, not counting those nested in an ERROR. */
+  errorCount: number;
+  /** Start and end byte of each of them, in pairs, as offsets into the input (byte order mark included). */
+  errorSpans: Uint32Array;
+  /**
+   * The tree in the binary export format described in
+   * `bindings/c/tree_sitter/tree-sitter-autohotkey-export.h`, or null if `binary: true` wasn't
+   * passed or the parse was stopped. Its byte offsets don't count a byte order mark. It can be
+   * posted to a worker or written to a file as is, and read with typed array views.
+   */
+  tree: ArrayBuffer | null;
+};
+
+type ParseOptions = {
+  /** Build the root node's S-expression (default true). */
+  sexp?: boolean;
+  /** Export the tree as `tree`, in one pass on the pool thread (default false). */
+  binary?: boolean;
+  /**
+   * Stop parsing after this many milliseconds, resolving with status `"timeout"`. The time is
+   * measured from when a pool thread picks the input up, and doesn't include reading a file.
+   */
+  timeoutMs?: number;
+  /** Stop parsing, resolving with status `"cancelled"`, when this signal aborts. */
+  signal?: AbortSignal;
+};
+
 /**
  * The tree-sitter language object for this grammar.
  *
@@ -55,6 +96,27 @@ declare const binding: {
 
   /** The symbol tagging query for this grammar. */
   TAGS_QUERY?: string;
+
+  /**
+   * Parse a script on the libuv thread pool, so the event loop isn't blocked. Strings are parsed as
+   * UTF-8; a Uint8Array (or Buffer) is copied before this returns, and is UTF-8 unless it starts with
+   * a UTF-16 byte order mark. A leading mark is skipped either way. Each pool thread reuses one parser.
+   *
+   * Only present when the addon was built with the tree-sitter runtime, see binding.gyp.
+   */
+  parseAsync?: (source: string | Uint8Array, options?: ParseOptions) => Promise<ParseResult>;
+
+  /**
+   * Read and parse a file on the libuv thread pool. Rejects with the usual `code` and `path` if the
+   * file can't be read. Only present when `parseAsync` is.
+   */
+  parseFileAsync?: (path: string, options?: ParseOptions) => Promise<ParseResult>;
+
+  /**
+   * Parse many files, spread over the libuv thread pool (`UV_THREADPOOL_SIZE` threads, 4 by default).
+   * Only present when `parseAsync` is.
+   */
+  parseFiles?: (paths: string[], options?: ParseOptions) => Promise<ParseResult[]>;
 };
 
 export default binding;
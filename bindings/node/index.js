@@ -34,4 +34,10 @@ for (const [prop, path] of queries) {
   });
 }
 
+// parseAsync and parseFileAsync exist when the addon was built with the tree-sitter runtime (see binding.gyp).
+if (typeof binding.parseFileAsync === "function") {
+  binding.parseFiles = (paths, options) =>
+    Promise.all(paths.map((path) => binding.parseFileAsync(path, options)));
+}
+
 export default binding;
@@ -1,4 +1,7 @@
-from unittest import TestCase
+from os import path
+from struct import calcsize, unpack_from
+from threading import Timer
+from unittest import TestCase, skipIf
 
 from tree_sitter import Language, Parser
 import tree_sitter_autohotkey
@@ -10,3 +13,166 @@ class TestLanguage(TestCase):
             Parser(Language(tree_sitter_autohotkey.language()))
         except Exception:
             self.fail("Error loading AutoHotkey grammar")
+
+
+@skipIf(tree_sitter_autohotkey._parse_many is None, "built without the tree-sitter runtime")
+class TestParseMany(TestCase):
+    def test_matches_single_parses(self):
+        sources = [b"x := 1\n", b"MsgBox(\"hi\")\n", b"class A {\n}\n"] * 10
+        parser = Parser(Language(tree_sitter_autohotkey.language()))
+        results = tree_sitter_autohotkey.parse_many(sources, threads=4)
+        self.assertEqual(len(results), len(sources))
+        for source, result in zip(sources, results):
+            self.assertEqual(result.sexp, str(parser.parse(source).root_node))
+            self.assertEqual(result.error_count, 0)
+            self.assertEqual(result.error_spans, ())
+
+    def test_reports_errors(self):
+        [result] = tree_sitter_autohotkey.parse_many([b"x := (\n"], sexp=False)
+        self.assertIsNone(result.sexp)
+        self.assertGreater(result.error_count, 0)
+        self.assertEqual(len(result.error_spans), result.error_count)
+
+    def test_byte_order_marks(self):
+        source = "x := \"é\"\nMsgBox(x\n"
+        [plain, utf8, utf16le, utf16be] = tree_sitter_autohotkey.parse_many([
+            source.encode(),
+            b"\xef\xbb\xbf" + source.encode(),
+            b"\xff\xfe" + source.encode("utf-16-le"),
+            b"\xfe\xff" + source.encode("utf-16-be"),
+        ])
+        self.assertGreater(plain.error_count, 0)
+        self.assertEqual(utf8.sexp, plain.sexp)
+        self.assertEqual(utf8.error_spans, tuple((s + 3, e + 3) for s, e in plain.error_spans))
+        for result in (utf16le, utf16be):
+            self.assertEqual(result.sexp, plain.sexp)
+            self.assertEqual(result.error_count, plain.error_count)
+
+    def test_binary_export(self):
+        source = b"class A {\n    F(x) => x\n}\n"
+        parser = Parser(Language(tree_sitter_autohotkey.language()))
+        root = parser.parse(source).root_node
+        [result, with_bom] = tree_sitter_autohotkey.parse_many([source, b"\xef\xbb\xbf" + source], binary=True)
+        self.assertIsNone(tree_sitter_autohotkey.parse_many([source])[0].tree)
+        # Offsets don't count the mark, so the two exports are the same
+        self.assertEqual(with_bom.tree, result.tree)
+
+        header = "=8s13I"
+        (magic, _version, _order, _header_size, node_size, _abi, symbols, fields, strings_offset, _strings_size,
+         count, nodes_offset, total) = unpack_from(header, result.tree)
+        self.assertEqual(magic, b"AHKTREE\0")
+        self.assertEqual((count, total), (root.descendant_count, len(result.tree)))
+        offsets = unpack_from(f"={symbols + fields + 2}I", result.tree, strings_offset)
+        names = strings_offset + calcsize(f"={symbols + fields + 2}I")
+
+        def name(i):
+            return result.tree[names + offsets[i]:names + offsets[i + 1] - 1].decode()
+
+        def node(i):
+            return unpack_from("=4H6I", result.tree, nodes_offset + i * node_size)
+
+        symbol, _field, _flags, _, start, end, parent, first_child, next_sibling, subtree_end = node(0)
+        self.assertEqual((name(symbol), start, end), ("source_file", root.start_byte, root.end_byte))
+        self.assertEqual((parent, next_sibling, subtree_end), (0xFFFFFFFF, 0xFFFFFFFF, count))
+        klass = node(first_child)
+        self.assertEqual(name(klass[0]), root.children[0].type)
+        self.assertEqual(name(symbols + klass[1]), "")
+        # Follow the class's children to the one in its "name" field
+        child = node(klass[7])
+        while name(symbols + child[1]) != "name":
+            child = node(child[8])
+        self.assertEqual((name(child[0]), source[child[4]:child[5]]), ("identifier", b"A"))
+
+    def test_binary_export_round_trip(self):
+        # A whole corpus file, headers and expected trees included, so the tree has errors and missing nodes too
+        corpus = path.join(path.dirname(__file__), "..", "..", "..", "test", "corpus", "realworld-gui-example.txt")
+        with open(corpus, "rb") as file:
+            source = file.read()
+        tree = Parser(Language(tree_sitter_autohotkey.language())).parse(source)
+        [result] = tree_sitter_autohotkey.parse_many([source], binary=True, sexp=False)
+        self.assertEqual(decode_export(result.tree), export_of(tree))
+
+    def test_reads_paths(self):
+        corpus = path.join(path.dirname(__file__), "..", "..", "..", "test", "corpus", "functions.txt")
+        [result] = tree_sitter_autohotkey.parse_many([corpus], threads=1, sexp=False)
+        self.assertIsInstance(result.error_count, int)
+        self.assertIsNone(result.error)
+
+        # A missing file fails on its own; the rest of the batch is still parsed
+        [missing, parsed] = tree_sitter_autohotkey.parse_many([corpus + ".missing", b"x := 1\n"], threads=1)
+        self.assertEqual((missing.status, missing.sexp, missing.tree), ("error", None, None))
+        self.assertIsInstance(missing.error, FileNotFoundError)
+        self.assertEqual(missing.error.filename, corpus + ".missing")
+        self.assertEqual((parsed.status, parsed.error_count, parsed.error), ("complete", 0, None))
+
+    def test_timeout(self):
+        source = b"x := [1, 2, (3 + 4) * 5]\n" * 200_000
+        [slow, fast] = tree_sitter_autohotkey.parse_many([source, b"x := 1\n"], threads=1, timeout=0.001)
+        self.assertEqual(slow.status, "timeout")
+        self.assertIsNone(slow.sexp)
+        self.assertLess(slow.bytes_parsed, len(source))
+        # The worker's parser was reset, so the next input parses from scratch
+        self.assertEqual((fast.status, fast.bytes_parsed, fast.error_count), ("complete", 7, 0))
+        with self.assertRaises(ValueError):
+            tree_sitter_autohotkey.parse_many([source], timeout=-1)
+
+    def test_cancel(self):
+        source = b"x := [1, 2, (3 + 4) * 5]\n" * 200_000
+        cancel = tree_sitter_autohotkey.CancelFlag()
+        timer = Timer(0.01, cancel.set)
+        timer.start()
+        results = tree_sitter_autohotkey.parse_many([source] * 8, threads=2, cancel=cancel)
+        timer.join()
+        self.assertTrue(cancel.is_set())
+        self.assertIn("cancelled", [result.status for result in results])
+
+        [skipped] = tree_sitter_autohotkey.parse_many(["missing.ahk"], cancel=cancel)
+        self.assertEqual((skipped.status, skipped.bytes_parsed), ("cancelled", 0))
+        cancel.clear()
+        [result] = tree_sitter_autohotkey.parse_many([b"x := 1\n"], cancel=cancel)
+        self.assertEqual(result.status, "complete")
+
+
+NONE = 0xFFFFFFFF
+
+
+def decode_export(buffer):
+    """Every node record in an exported tree as a list, with its type and field names looked up"""
+    (_magic, _version, _order, _header_size, node_size, _abi, symbols, fields, strings_offset, _strings_size, count,
+     nodes_offset, _total) = unpack_from("=8s13I", buffer)
+    offsets = unpack_from(f"={symbols + fields + 2}I", buffer, strings_offset)
+    names = strings_offset + calcsize(f"={symbols + fields + 2}I")
+
+    def name(i):
+        return buffer[names + offsets[i]:names + offsets[i + 1] - 1].decode()
+
+    nodes = []
+    for i in range(count):
+        symbol, field, flags, _, *links = unpack_from("=4H6I", buffer, nodes_offset + i * node_size)
+        nodes.append([name(symbol), name(symbols + field), flags, *links])
+    return nodes
+
+
+def export_of(tree):
+    """What decode_export should return for `tree`, built from a cursor walk"""
+    nodes, stack, cursor = [], [], tree.walk()
+    while True:
+        node, index = cursor.node, len(nodes)
+        flags = ((1 if node.is_named else 0) | (2 if node.is_error else 0) | (4 if node.is_missing else 0)
+                 | (8 if node.is_extra else 0) | (16 if node.has_error else 0))
+        parent = stack[-1] if stack else NONE
+        nodes.append([node.type, cursor.field_name or "", flags, node.start_byte, node.end_byte, parent, NONE, NONE, 0])
+        if stack and nodes[parent][6] == NONE:
+            nodes[parent][6] = index
+        stack.append(index)
+        if cursor.goto_first_child():
+            continue
+        while True:
+            done = stack.pop()
+            nodes[done][8] = len(nodes)
+            if stack and cursor.goto_next_sibling():
+                nodes[done][7] = len(nodes)
+                break
+            if not stack:
+                return nodes
+            cursor.goto_parent()
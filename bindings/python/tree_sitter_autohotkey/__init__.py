@@ -1,9 +1,98 @@
 """Tree-sitter grammar for AHK v2"""
 
+import os as _os
 from importlib.resources import files as _files
+from typing import NamedTuple as _NamedTuple
 
 from ._binding import language
 
+try:
+    from ._binding import _parse_many
+except ImportError:  # built without the tree-sitter runtime
+    _parse_many = None
+
+
+class ParseResult(_NamedTuple):
+    """One input's result from `parse_many`."""
+
+    sexp: str | None
+    """The root node's S-expression, or None if it wasn't requested."""
+    error_count: int
+    """ERROR and MISSING nodes in the tree, not counting those nested in an ERROR."""
+    error_spans: tuple[tuple[int, int], ...]
+    """The (start, end) byte offsets of each of them into the input, byte order mark included."""
+    status: str = "complete"
+    """"complete", or "timeout" or "cancelled" if the parse was stopped, or "error" if the input couldn't be read
+    (see `error`); a stopped or failed parse has no tree, so its sexp is None and it reports no errors."""
+    bytes_parsed: int = 0
+    """How far into the input the parser got, in bytes, byte order mark included."""
+    tree: bytes | None = None
+    """The tree in the binary export format (see bindings/c/tree_sitter/tree-sitter-autohotkey-export.h) if
+    `binary=True` was passed and the parse completed, else None. Its byte offsets don't count a byte order mark."""
+    error: OSError | None = None
+    """Why the input has status "error", e.g. a FileNotFoundError for a missing path, else None."""
+
+
+class CancelFlag:
+    """Cancels a `parse_many` call from another thread.
+
+    The flag is a single byte the native workers poll while they parse, so setting it doesn't need
+    the GIL to reach them. Inputs not yet started are skipped, and the one each worker is on stops
+    within a few hundred parse steps; both are reported with status "cancelled".
+    """
+
+    __slots__ = ("_byte",)
+
+    def __init__(self):
+        self._byte = bytearray(1)
+
+    def set(self):
+        self._byte[0] = 1
+
+    def clear(self):
+        self._byte[0] = 0
+
+    def is_set(self):
+        return self._byte[0] != 0
+
+
+def parse_many(sources, threads=0, *, sexp=True, binary=False, timeout=None, cancel=None):
+    """Parse many scripts on a pool of native threads, without holding the GIL.
+
+    Each source is a path (str or os.PathLike), read by the worker that parses it, or the script
+    itself (bytes-like). Either is UTF-8 unless it starts with a UTF-16 byte order mark; a leading
+    mark of either kind is skipped rather than parsed. Every worker reuses one parser for all the inputs it picks up.
+    `threads` defaults to the number of CPUs. Returns one ParseResult per source, in order. A path that
+    can't be read doesn't stop the batch: its result has status "error" and the OSError in `error`.
+
+    `timeout` limits each parse to that many seconds, not counting reading a path; a parse that runs
+    over is reported with status "timeout". `cancel` is a CancelFlag that stops the batch when set.
+
+    `binary` also exports each tree as one flat buffer (ParseResult.tree) that can be handed to another process, or
+    written to a file and mapped, and read there without parsing it again. The export is written by the same worker,
+    in one pass over the tree.
+    """
+    if _parse_many is None:
+        raise RuntimeError(
+            "tree_sitter_autohotkey was built without the tree-sitter runtime, so parse_many is unavailable; "
+            "set TREE_SITTER_RUNTIME_DIR or install libtree-sitter (pkg-config) and rebuild"
+        )
+    items = []
+    for source in sources:
+        if isinstance(source, (str, _os.PathLike)):
+            items.append((True, _os.fsencode(source)))
+        else:
+            items.append((False, bytes(source)))
+    if threads <= 0:
+        threads = _os.cpu_count() or 1
+    if timeout is not None and not timeout >= 0:
+        raise ValueError("timeout must be a non-negative number of seconds")
+    timeout_us = 0 if timeout is None else max(1, round(timeout * 1_000_000))
+    if cancel is not None and not isinstance(cancel, CancelFlag):
+        raise TypeError("cancel must be a CancelFlag")
+    byte = None if cancel is None else cancel._byte
+    return [ParseResult(*result) for result in _parse_many(items, threads, sexp, timeout_us, byte, binary)]
+
 
 def _get_query(name, file):
     try:
@@ -29,6 +118,9 @@ def __getattr__(name):
 
 __all__ = [
     "language",
+    "parse_many",
+    "CancelFlag",
+    "ParseResult",
     "HIGHLIGHTS_QUERY",
     "INJECTIONS_QUERY",
     "LOCALS_QUERY",
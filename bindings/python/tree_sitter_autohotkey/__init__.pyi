@@ -1,5 +1,7 @@
-from typing import Final
-from typing_extensions import CapsuleType
+from collections.abc import Iterable
+from os import PathLike
+from typing import Final, Literal, NamedTuple
+from typing_extensions import Buffer, CapsuleType
 
 HIGHLIGHTS_QUERY: Final[str] | None
 """The syntax highlighting query for this grammar."""
@@ -15,3 +17,32 @@ TAGS_QUERY: Final[str] | None
 
 def language() -> CapsuleType:
     """The tree-sitter language function for this grammar."""
+
+class ParseResult(NamedTuple):
+    """One input's result from `parse_many`."""
+
+    sexp: str | None
+    error_count: int
+    error_spans: tuple[tuple[int, int], ...]
+    status: Literal["complete", "timeout", "cancelled", "error"] = "complete"
+    bytes_parsed: int = 0
+    tree: bytes | None = None
+    error: OSError | None = None
+
+class CancelFlag:
+    """Cancels a `parse_many` call from another thread."""
+
+    def set(self) -> None: ...
+    def clear(self) -> None: ...
+    def is_set(self) -> bool: ...
+
+def parse_many(
+    sources: Iterable[str | PathLike[str] | bytes | Buffer],
+    threads: int = 0,
+    *,
+    sexp: bool = True,
+    binary: bool = False,
+    timeout: float | None = None,
+    cancel: CancelFlag | None = None,
+) -> list[ParseResult]:
+    """Parse many scripts (paths or source bytes) on a pool of native threads, without the GIL."""
@@ -8,6 +8,395 @@ static PyObject* _binding_language(PyObject *Py_UNUSED(self), PyObject *Py_UNUSE
     return PyCapsule_New(tree_sitter_autohotkey(), "tree_sitter.Language", NULL);
 }
 
+#ifdef TREE_SITTER_AHK_PARSE_MANY
+// Batch parsing, compiled in when setup.py finds the tree-sitter runtime (see its find_runtime). The inputs are
+// unpacked while holding the GIL; after that the workers only touch plain C data, so the GIL is released for the whole
+// batch and each worker reuses one TSParser for every input it picks up.
+//
+// Each parse can be limited to a time budget, and the whole batch can be cancelled from another Python thread through
+// a CancelFlag (a one-byte bytearray, see __init__.py): both are checked by the runtime's progress callback.
+//
+// With `binary`, each tree is also written out with tree_sitter_autohotkey_export (bindings/c/export.c, compiled in
+// alongside the runtime) by the worker that parsed it, so the GIL is only needed to copy the buffer into bytes.
+
+#include <tree_sitter/api.h>
+#include <tree_sitter/tree-sitter-autohotkey-export.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE Thread;
+typedef CRITICAL_SECTION Mutex;
+#define THREAD_RETURN DWORD WINAPI
+#define mutex_init(m) InitializeCriticalSection(m)
+#define mutex_lock(m) EnterCriticalSection(m)
+#define mutex_unlock(m) LeaveCriticalSection(m)
+#define mutex_destroy(m) DeleteCriticalSection(m)
+
+static uint64_t now_us(void) {
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (!frequency.QuadPart) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart * 1000000 +
+                      counter.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+}
+#else
+#include <pthread.h>
+typedef pthread_t Thread;
+typedef pthread_mutex_t Mutex;
+#define THREAD_RETURN void *
+#define mutex_init(m) pthread_mutex_init(m, NULL)
+#define mutex_lock(m) pthread_mutex_lock(m)
+#define mutex_unlock(m) pthread_mutex_unlock(m)
+#define mutex_destroy(m) pthread_mutex_destroy(m)
+
+#include <time.h>
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+#endif
+
+// How a parse ended; the values index STATUS_NAMES
+enum { STATUS_COMPLETE, STATUS_TIMEOUT, STATUS_CANCELLED };
+static const char *const STATUS_NAMES[] = {"complete", "timeout", "cancelled"};
+
+typedef struct {
+    // Input: a file system path (NUL-terminated) or the source itself
+    bool is_path;
+    const char *data;
+    size_t length;
+
+    // Output
+    char *sexp;          // from ts_node_string, NULL unless requested
+    void *tree;          // from tree_sitter_autohotkey_export, NULL unless requested
+    size_t tree_size;
+    uint32_t errors;     // ERROR and MISSING nodes, not counting those nested in an ERROR
+    uint32_t *spans;     // start and end byte of each of them, as offsets into the input including any BOM
+    uint32_t span_cap;
+    int status;          // STATUS_*; a stopped parse leaves no sexp or errors
+    uint32_t parsed;     // bytes of the input the parser got through, BOM included
+    int error;           // errno from reading a path, or 0
+} Job;
+
+typedef struct {
+    Job *jobs;
+    size_t count;
+    size_t next;
+    bool sexp;
+    bool binary;
+    uint64_t timeout_us;    // per input, or 0 for none
+    volatile char *cancel;  // the CancelFlag's byte, or NULL
+    Mutex lock;
+} Pool;
+
+/// Progress callback payload for one parse
+typedef struct {
+    uint64_t deadline_us;
+    volatile char *cancel;
+    int status;
+    uint32_t offset;
+} Budget;
+
+static bool check_budget(TSParseState *state) {
+    Budget *budget = state->payload;
+    budget->offset = state->current_byte_offset;
+    if (budget->cancel && *budget->cancel) budget->status = STATUS_CANCELLED;
+    else if (budget->deadline_us && now_us() >= budget->deadline_us) budget->status = STATUS_TIMEOUT;
+    return budget->status != STATUS_COMPLETE;
+}
+
+typedef struct {
+    const char *data;
+    uint32_t length;
+} Text;
+
+static const char *read_text(void *payload, uint32_t byte, TSPoint position, uint32_t *bytes_read) {
+    (void)position;
+    const Text *text = payload;
+    *bytes_read = byte < text->length ? text->length - byte : 0;
+    return *bytes_read ? text->data + byte : "";
+}
+
+static bool push_span(Job *job, TSNode node, uint32_t bom) {
+    if (job->errors * 2 + 2 > job->span_cap) {
+        uint32_t cap = job->span_cap ? job->span_cap * 2 : 16;
+        uint32_t *spans = realloc(job->spans, cap * sizeof(uint32_t));
+        if (!spans) return false;
+        job->spans = spans;
+        job->span_cap = cap;
+    }
+    job->spans[job->errors * 2] = bom + ts_node_start_byte(node);
+    job->spans[job->errors * 2 + 1] = bom + ts_node_end_byte(node);
+    job->errors++;
+    return true;
+}
+
+/// Collects the error nodes under `root`, only descending into subtrees that contain one
+static bool collect_errors(TSNode root, Job *job, uint32_t bom) {
+    if (!ts_node_has_error(root)) return true;
+    TSTreeCursor cursor = ts_tree_cursor_new(root);
+    bool ok = true;
+    for (;;) {
+        TSNode node = ts_tree_cursor_current_node(&cursor);
+        bool descend = ts_node_has_error(node);
+        if (ts_node_is_error(node) || ts_node_is_missing(node)) {
+            if (!(ok = push_span(job, node, bom))) break;
+            descend = false;
+        }
+        if (descend && ts_tree_cursor_goto_first_child(&cursor)) continue;
+        while (!ts_tree_cursor_goto_next_sibling(&cursor)) {
+            if (!ts_tree_cursor_goto_parent(&cursor)) goto done;
+        }
+    }
+done:
+    ts_tree_cursor_delete(&cursor);
+    return ok;
+}
+
+static char *read_file(const char *path, size_t *length, int *error) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        *error = errno;
+        return NULL;
+    }
+    size_t cap = 65536, len = 0;
+    char *data = malloc(cap);
+    while (data) {
+        len += fread(data + len, 1, cap - len, f);
+        if (len < cap) break;
+        char *grown = realloc(data, cap *= 2);
+        if (!grown) free(data);
+        data = grown;
+    }
+    if (!data) *error = ENOMEM;
+    else if (ferror(f)) *error = EIO;
+    fclose(f);
+    if (*error) {
+        free(data);
+        return NULL;
+    }
+    *length = len;
+    return data;
+}
+
+/// Length of the byte order mark `source` starts with, if any, and the encoding it names. Without one the text is
+/// taken to be UTF-8, as AutoHotkey itself does by default.
+static uint32_t detect_bom(const char *source, size_t length, TSInputEncoding *encoding) {
+    const unsigned char *s = (const unsigned char *)source;
+    *encoding = TSInputEncodingUTF8;
+    if (length >= 3 && s[0] == 0xEF && s[1] == 0xBB && s[2] == 0xBF) return 3;
+    if (length >= 2 && s[0] == 0xFF && s[1] == 0xFE) *encoding = TSInputEncodingUTF16LE;
+    else if (length >= 2 && s[0] == 0xFE && s[1] == 0xFF) *encoding = TSInputEncodingUTF16BE;
+    else return 0;
+    return 2;
+}
+
+static void run_job(TSParser *parser, Job *job, const Pool *pool) {
+    if (pool->cancel && *pool->cancel) {
+        job->status = STATUS_CANCELLED;
+        return;
+    }
+    const char *source = job->data;
+    size_t length = job->length;
+    char *owned = NULL;
+    if (job->is_path) {
+        source = owned = read_file(job->data, &length, &job->error);
+        if (!owned) return;
+    }
+    if (length > UINT32_MAX) {
+        job->error = EFBIG;
+        free(owned);
+        return;
+    }
+
+    // The mark isn't part of the text: the grammar has no token for it, so it would start the tree with an ERROR.
+    TSInputEncoding encoding;
+    uint32_t bom = detect_bom(source, length, &encoding);
+    Text text = {source + bom, (uint32_t)length - bom};
+    Budget budget = {pool->timeout_us ? now_us() + pool->timeout_us : 0, pool->cancel, STATUS_COMPLETE, 0};
+    TSTree *tree = ts_parser_parse_with_options(parser, NULL, (TSInput){&text, read_text, encoding, NULL},
+                                                (TSParseOptions){&budget, check_budget});
+    job->parsed = (uint32_t)length;
+    if (tree) {
+        TSNode root = ts_tree_root_node(tree);
+        if (!collect_errors(root, job, bom)) job->error = ENOMEM;
+        if (pool->sexp) job->sexp = ts_node_string(root);
+        if (pool->binary && !job->error) {
+            // A tree too large for the format's 32-bit offsets sizes to 0
+            job->tree_size = tree_sitter_autohotkey_export(root, NULL, 0);
+            job->tree = job->tree_size ? malloc(job->tree_size) : NULL;
+            if (!job->tree_size) job->error = EFBIG;
+            else if (!job->tree || !tree_sitter_autohotkey_export(root, job->tree, job->tree_size)) job->error = ENOMEM;
+        }
+        ts_tree_delete(tree);
+    } else if (budget.status != STATUS_COMPLETE) {
+        // Otherwise the parser would try to resume this parse on the worker's next input
+        ts_parser_reset(parser);
+        job->status = budget.status;
+        job->parsed = bom + budget.offset;
+    } else {
+        job->error = ENOMEM;
+    }
+    free(owned);
+}
+
+static THREAD_RETURN worker(void *arg) {
+    Pool *pool = arg;
+    TSParser *parser = ts_parser_new();
+    ts_parser_set_language(parser, tree_sitter_autohotkey());
+    for (;;) {
+        mutex_lock(&pool->lock);
+        size_t i = pool->next++;
+        mutex_unlock(&pool->lock);
+        if (i >= pool->count) break;
+        run_job(parser, &pool->jobs[i], pool);
+    }
+    ts_parser_delete(parser);
+    return 0;
+}
+
+/// Runs the pool on `threads` threads, the calling one included. If extra threads can't be started, the ones that
+/// did (or just the caller) still drain the whole pool.
+static void run_pool(Pool *pool, int threads) {
+    Thread *handles = threads > 1 ? malloc(sizeof(Thread) * (size_t)(threads - 1)) : NULL;
+    int started = 0;
+    for (; handles && started < threads - 1; started++) {
+#ifdef _WIN32
+        handles[started] = CreateThread(NULL, 0, worker, pool, 0, NULL);
+        if (!handles[started]) break;
+#else
+        if (pthread_create(&handles[started], NULL, worker, pool) != 0) break;
+#endif
+    }
+    worker(pool);
+    for (int t = 0; t < started; t++) {
+#ifdef _WIN32
+        WaitForSingleObject(handles[t], INFINITE);
+        CloseHandle(handles[t]);
+#else
+        pthread_join(handles[t], NULL);
+#endif
+    }
+    free(handles);
+}
+
+/// The OSError for a job that couldn't be read or whose results couldn't be stored, with the path if it had one
+static PyObject *job_error(const Job *job) {
+    PyObject *path = job->is_path ? PyUnicode_DecodeFSDefault(job->data) : Py_NewRef(Py_None);
+    if (!path) return NULL;
+    // OSError picks the subclass for the errno, e.g. FileNotFoundError
+    return PyObject_CallFunction(PyExc_OSError, "isN", job->error, strerror(job->error), path);
+}
+
+static PyObject *job_result(const Job *job) {
+    if (job->error) {
+        PyObject *error = job_error(job);
+        if (!error) return NULL;
+        return Py_BuildValue("(OI()sION)", Py_None, 0, "error", job->parsed, Py_None, error);
+    }
+    PyObject *spans = PyTuple_New(job->errors);
+    if (!spans) return NULL;
+    for (uint32_t i = 0; i < job->errors; i++) {
+        PyObject *span = Py_BuildValue("(II)", job->spans[i * 2], job->spans[i * 2 + 1]);
+        if (!span) {
+            Py_DECREF(spans);
+            return NULL;
+        }
+        PyTuple_SetItem(spans, i, span);
+    }
+    PyObject *sexp = job->sexp ? PyUnicode_FromString(job->sexp) : Py_NewRef(Py_None);
+    if (!sexp) {
+        Py_DECREF(spans);
+        return NULL;
+    }
+    PyObject *tree = job->tree ? PyBytes_FromStringAndSize(job->tree, (Py_ssize_t)job->tree_size) : Py_NewRef(Py_None);
+    if (!tree) {
+        Py_DECREF(spans);
+        Py_DECREF(sexp);
+        return NULL;
+    }
+    return Py_BuildValue("(NINsINO)", sexp, job->errors, spans, STATUS_NAMES[job->status], job->parsed, tree,
+                         Py_None);
+}
+
+static PyObject* _binding_parse_many(PyObject *Py_UNUSED(self), PyObject *args) {
+    PyObject *items, *cancel;
+    int threads, sexp, binary;
+    unsigned long long timeout_us;
+    if (!PyArg_ParseTuple(args, "O!ipKOp", &PyList_Type, &items, &threads, &sexp, &timeout_us, &cancel, &binary)) {
+        return NULL;
+    }
+    if (cancel != Py_None && (!PyByteArray_Check(cancel) || PyByteArray_Size(cancel) < 1)) {
+        PyErr_SetString(PyExc_TypeError, "cancel must be a CancelFlag");
+        return NULL;
+    }
+
+    Py_ssize_t count = PyList_Size(items);
+    Job *jobs = calloc(count ? (size_t)count : 1, sizeof(Job));
+    if (!jobs) return PyErr_NoMemory();
+
+    // `items` holds (is_path, bytes) pairs from parse_many in __init__.py, and keeps the bytes alive meanwhile.
+    for (Py_ssize_t i = 0; i < count; i++) {
+        PyObject *item = PyList_GetItem(items, i);
+        int is_path;
+        char *data;
+        Py_ssize_t length;
+        PyObject *bytes;
+        if (!PyArg_ParseTuple(item, "pS", &is_path, &bytes) ||
+            PyBytes_AsStringAndSize(bytes, &data, &length) < 0) {
+            free(jobs);
+            return NULL;
+        }
+        jobs[i].is_path = is_path;
+        jobs[i].data = data;
+        jobs[i].length = (size_t)length;
+    }
+
+    // The flag keeps its bytearray the same size, so the pointer stays valid while the GIL is released
+    Pool pool = {
+        .jobs = jobs,
+        .count = (size_t)count,
+        .sexp = sexp,
+        .binary = binary,
+        .timeout_us = timeout_us,
+        .cancel = cancel != Py_None ? PyByteArray_AsString(cancel) : NULL,
+    };
+    mutex_init(&pool.lock);
+    if (threads < 1) threads = 1;
+    if (threads > count) threads = count > 0 ? (int)count : 1;
+
+    Py_BEGIN_ALLOW_THREADS
+    run_pool(&pool, threads);
+    Py_END_ALLOW_THREADS
+
+    mutex_destroy(&pool.lock);
+
+    PyObject *results = PyList_New(count);
+    for (Py_ssize_t i = 0; results && i < count; i++) {
+        PyObject *result = job_result(&jobs[i]);
+        if (!result) Py_CLEAR(results);
+        else PyList_SetItem(results, i, result);
+    }
+
+    for (Py_ssize_t i = 0; i < count; i++) {
+        free(jobs[i].sexp);
+        free(jobs[i].tree);
+        free(jobs[i].spans);
+    }
+    free(jobs);
+    return results;
+}
+#endif
+
 static struct PyModuleDef_Slot slots[] = {
 #ifdef Py_GIL_DISABLED
     {Py_mod_gil, Py_MOD_GIL_NOT_USED},
@@ -18,6 +407,11 @@ static struct PyModuleDef_Slot slots[] = {
 static PyMethodDef methods[] = {
     {"language", _binding_language, METH_NOARGS,
      "Get the tree-sitter language for this grammar."},
+#ifdef TREE_SITTER_AHK_PARSE_MANY
+    {"_parse_many", _binding_parse_many, METH_VARARGS,
+     "Parse a list of (is_path, bytes) inputs on a pool of threads, without the GIL, with an optional per-input "
+     "timeout in microseconds and cancel flag, optionally exporting each tree in the binary format."},
+#endif
     {NULL, NULL, 0, NULL}
 };
 
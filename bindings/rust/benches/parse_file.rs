@@ -0,0 +1,118 @@
+//! Parsing a large script from disk: `fs::read_to_string` and `Parser::parse` (what most callers do) against
+//! `MappedSource`, for a UTF-8 file and for the same script saved as UTF-16LE with a byte order mark, which the
+//! owned-string path has to transcode first.
+//!
+//! cargo bench --features mmap
+
+use std::fs;
+use std::path::PathBuf;
+
+use criterion::{criterion_group, criterion_main, Criterion, Throughput};
+use tree_sitter::Parser;
+use tree_sitter_autohotkey::MappedSource;
+
+/// Roughly the size of a large generated GUI definition
+const TARGET_BYTES: usize = 8 << 20;
+
+/// The sources of the realworld corpus tests, repeated up to TARGET_BYTES. Extracted as bench/bench.c does: each test
+/// is a `===` delimited header, its source, then a `---` line and the expected tree.
+fn script() -> String {
+    let corpus = concat!(env!("CARGO_MANIFEST_DIR"), "/test/corpus");
+    let mut paths: Vec<PathBuf> = fs::read_dir(corpus)
+        .unwrap()
+        .map(|entry| entry.unwrap().path())
+        .filter(|path| {
+            path.file_name()
+                .unwrap()
+                .to_string_lossy()
+                .starts_with("realworld-")
+        })
+        .collect();
+    paths.sort();
+
+    let mut unit = String::new();
+    for path in paths {
+        let text = fs::read_to_string(&path).unwrap();
+        let (mut in_header, mut in_source) = (false, false);
+        for line in text.lines() {
+            if in_source {
+                if line.starts_with("---") {
+                    in_source = false;
+                } else {
+                    unit.push_str(line);
+                    unit.push('\n');
+                }
+            } else if line.starts_with("===") {
+                in_source = in_header;
+                in_header = !in_header;
+            }
+        }
+    }
+    unit.repeat(TARGET_BYTES / unit.len().max(1) + 1)
+}
+
+fn write(name: &str, bytes: &[u8]) -> PathBuf {
+    let path = std::env::temp_dir().join(format!("tree-sitter-autohotkey-bench-{name}"));
+    fs::write(&path, bytes).unwrap();
+    path
+}
+
+fn parse_file(c: &mut Criterion) {
+    let script = script();
+    let utf8 = write("utf8.ahk", script.as_bytes());
+    let utf16: Vec<u8> = [0xFF, 0xFE]
+        .into_iter()
+        .chain(script.encode_utf16().flat_map(u16::to_le_bytes))
+        .collect();
+    let utf16 = write("utf16le.ahk", &utf16);
+
+    let mut parser = Parser::new();
+    parser
+        .set_language(&tree_sitter_autohotkey::LANGUAGE.into())
+        .unwrap();
+
+    let mut group = c.benchmark_group("parse_file");
+    group.sample_size(10);
+    group.throughput(Throughput::Bytes(script.len() as u64));
+
+    group.bench_function("utf8/read_to_string", |b| {
+        b.iter(|| {
+            let text = fs::read_to_string(&utf8).unwrap();
+            parser.parse(&text, None).unwrap()
+        })
+    });
+    group.bench_function("utf8/mmap", |b| {
+        b.iter(|| {
+            unsafe { MappedSource::open(&utf8) }
+                .unwrap()
+                .parse(&mut parser, None)
+                .unwrap()
+        })
+    });
+    group.bench_function("utf16le/read_and_transcode", |b| {
+        b.iter(|| {
+            let bytes = fs::read(&utf16).unwrap();
+            let units: Vec<u16> = bytes[2..]
+                .chunks_exact(2)
+                .map(|p| u16::from_le_bytes([p[0], p[1]]))
+                .collect();
+            let text = String::from_utf16(&units).unwrap();
+            parser.parse(&text, None).unwrap()
+        })
+    });
+    group.bench_function("utf16le/mmap", |b| {
+        b.iter(|| {
+            unsafe { MappedSource::open(&utf16) }
+                .unwrap()
+                .parse(&mut parser, None)
+                .unwrap()
+        })
+    });
+    group.finish();
+
+    fs::remove_file(utf8).unwrap();
+    fs::remove_file(utf16).unwrap();
+}
+
+criterion_group!(benches, parse_file);
+criterion_main!(benches);
@@ -0,0 +1,22 @@
+//! Script encodings, as named by a byte order mark.
+
+/// Text encoding of a script, as given by its byte order mark.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum SourceEncoding {
+    Utf8,
+    Utf16Le,
+    Utf16Be,
+}
+
+impl SourceEncoding {
+    /// Detects the encoding from a leading byte order mark and returns it with the mark's length in bytes. Text
+    /// without a mark is taken to be UTF-8, as AutoHotkey itself does by default.
+    pub fn detect(bytes: &[u8]) -> (Self, usize) {
+        match bytes {
+            [0xEF, 0xBB, 0xBF, ..] => (Self::Utf8, 3),
+            [0xFF, 0xFE, ..] => (Self::Utf16Le, 2),
+            [0xFE, 0xFF, ..] => (Self::Utf16Be, 2),
+            _ => (Self::Utf8, 0),
+        }
+    }
+}
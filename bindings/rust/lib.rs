@@ -15,11 +15,32 @@
 //! assert!(!tree.root_node().has_error());
 //! ```
 //!
+//! With the `mmap` feature, [`MappedSource`] parses script files in place from a memory map, in the encoding their
+//! byte order mark names (UTF-8 or UTF-16). With the `project` feature, [`Project`] parses a script together with
+//! every file it pulls in through `#Include`, in parallel, and keeps the trees for files that haven't changed.
+//!
 //! [`Parser`]: https://docs.rs/tree-sitter/0.26.5/tree_sitter/struct.Parser.html
 //! [tree-sitter]: https://tree-sitter.github.io/
 
 use tree_sitter_language::LanguageFn;
 
+#[cfg(any(feature = "mmap", feature = "project"))]
+mod encoding;
+#[cfg(any(feature = "mmap", feature = "project"))]
+pub use encoding::SourceEncoding;
+
+#[cfg(feature = "mmap")]
+mod source;
+#[cfg(feature = "mmap")]
+pub use source::{parse_file, MappedSource};
+
+#[cfg(feature = "project")]
+mod project;
+#[cfg(feature = "project")]
+pub use project::{
+    Include, IncludeKind, IncludeTarget, Project, ProjectFile, ProjectGraph, ProjectOptions,
+};
+
 extern "C" {
     fn tree_sitter_autohotkey() -> *const ();
 }
@@ -57,4 +78,170 @@ mod tests {
             .set_language(&super::LANGUAGE.into())
             .expect("Error loading AutoHotkey parser");
     }
+
+    /// The source of each test in a corpus file, extracted as bench/bench.c does it.
+    fn corpus_sources(text: &str) -> Vec<String> {
+        let (mut sources, mut lines, mut state) = (Vec::new(), String::new(), "before");
+        for line in text.split_inclusive('\n') {
+            let bare = line.trim_end_matches(['\r', '\n']);
+            match state {
+                "before" | "expected" if bare.starts_with("===") => state = "header",
+                "header" if bare.starts_with("===") => (state, lines) = ("source", String::new()),
+                "source" if bare.starts_with("---") => {
+                    sources.push(std::mem::take(&mut lines));
+                    state = "expected";
+                }
+                "source" => lines.push_str(line),
+                _ => {}
+            }
+        }
+        sources
+    }
+
+    #[test]
+    fn test_corpus_parses_the_same_as_utf16() {
+        let mut parser = tree_sitter::Parser::new();
+        parser.set_language(&super::LANGUAGE.into()).unwrap();
+        let dir = std::path::Path::new(env!("CARGO_MANIFEST_DIR")).join("test/corpus");
+        let mut checked = 0;
+        for entry in std::fs::read_dir(dir).unwrap() {
+            let path = entry.unwrap().path();
+            for source in corpus_sources(&std::fs::read_to_string(&path).unwrap()) {
+                let units: Vec<u16> = source.encode_utf16().collect();
+                // UTF-16 code units before each UTF-8 offset that starts a character, and at the end
+                let mut units_at = vec![0; source.len() + 1];
+                let mut count = 0;
+                for (offset, c) in source.char_indices() {
+                    units_at[offset] = count;
+                    count += c.len_utf16();
+                }
+                units_at[source.len()] = count;
+
+                let utf8 = parser.parse(&source, None).unwrap();
+                let utf16 = parser.parse_utf16_le(&units, None).unwrap();
+                let (mut a, mut b) = (utf8.walk(), utf16.walk());
+                'walk: loop {
+                    let (x, y) = (a.node(), b.node());
+                    let at = format!(
+                        "{}: {:?} at byte {}",
+                        path.display(),
+                        x.kind(),
+                        x.start_byte()
+                    );
+                    assert_eq!(x.kind_id(), y.kind_id(), "{at}");
+                    assert_eq!(x.is_missing(), y.is_missing(), "{at}");
+                    assert_eq!(x.start_position().row, y.start_position().row, "{at}");
+                    // Byte offsets in a UTF-16 tree count bytes, two per code unit
+                    assert_eq!(y.start_byte(), 2 * units_at[x.start_byte()], "{at}");
+                    assert_eq!(y.end_byte(), 2 * units_at[x.end_byte()], "{at}");
+                    if a.goto_first_child() {
+                        assert!(b.goto_first_child(), "{at}");
+                        continue;
+                    }
+                    while !a.goto_next_sibling() {
+                        assert!(!b.goto_next_sibling(), "{at}");
+                        if !a.goto_parent() {
+                            break 'walk;
+                        }
+                        b.goto_parent();
+                    }
+                    assert!(b.goto_next_sibling(), "{at}");
+                }
+                checked += 1;
+            }
+        }
+        assert!(checked > 0, "no corpus tests found");
+    }
+
+    #[cfg(feature = "mmap")]
+    #[test]
+    fn test_mapped_source_matches_string_parse() {
+        use super::{MappedSource, SourceEncoding};
+
+        let code = "class A {\n    F(x) => x * 2\n}\nMsgBox(A().F(21))\n";
+        let mut parser = tree_sitter::Parser::new();
+        parser.set_language(&super::LANGUAGE.into()).unwrap();
+        let expected = parser.parse(code, None).unwrap().root_node().to_sexp();
+
+        let utf16: Vec<u8> = code.encode_utf16().flat_map(u16::to_le_bytes).collect();
+        let cases = [
+            ("plain", SourceEncoding::Utf8, code.as_bytes().to_vec()),
+            (
+                "utf8-bom",
+                SourceEncoding::Utf8,
+                [&[0xEF, 0xBB, 0xBF][..], code.as_bytes()].concat(),
+            ),
+            (
+                "utf16le-bom",
+                SourceEncoding::Utf16Le,
+                [&[0xFF, 0xFE][..], &utf16].concat(),
+            ),
+        ];
+        for (name, encoding, bytes) in cases {
+            let file = format!("tree-sitter-autohotkey-{}-{name}.ahk", std::process::id());
+            let path = std::env::temp_dir().join(file);
+            std::fs::write(&path, bytes).unwrap();
+            let source = unsafe { MappedSource::open(&path) }.unwrap();
+            assert_eq!(source.encoding(), encoding, "{name}");
+            let tree = source.parse(&mut parser, None).unwrap();
+            assert_eq!(tree.root_node().to_sexp(), expected, "{name}");
+            drop(source);
+            std::fs::remove_file(&path).unwrap();
+        }
+    }
+
+    #[cfg(feature = "project")]
+    #[test]
+    fn test_project_resolves_includes_and_caches_trees() {
+        use super::{IncludeKind, IncludeTarget, Project, ProjectOptions};
+        use std::fs;
+
+        let dir = format!("tree-sitter-autohotkey-project-{}", std::process::id());
+        let dir = std::env::temp_dir().join(dir);
+        fs::create_dir_all(dir.join("Lib")).unwrap();
+        let main = dir.join("Main.ahk");
+        fs::write(
+            &main,
+            "#Include Lib\\a.ahk\n\
+             #Include <B>\n\
+             #Include *i missing.ahk\n\
+             #IncludeAgain %A_ScriptDir%\\Lib\\a.ahk\n",
+        )
+        .unwrap();
+        fs::write(dir.join("Lib/a.ahk"), "A() => 1\n").unwrap();
+        fs::write(dir.join("Lib/B.ahk"), "#Include a.ahk\nB() => A()\n").unwrap();
+
+        let project = Project::new(ProjectOptions::default());
+        let graph = project.load(&main).unwrap();
+        let names: Vec<_> = graph
+            .files()
+            .iter()
+            .map(|f| f.path().file_name().unwrap().to_owned())
+            .collect();
+        assert_eq!(names, ["Main.ahk", "a.ahk", "B.ahk"]);
+        assert_eq!(graph.parsed_count(), 3);
+        assert_eq!(graph.missing().count(), 0);
+        assert!(graph.files().iter().all(|f| !f.tree().root_node().has_error()));
+
+        let includes = graph.main().includes();
+        let targets: Vec<_> = includes.iter().map(|i| i.target.clone()).collect();
+        assert_eq!(targets[0], IncludeTarget::File(1));
+        assert_eq!(targets[1], IncludeTarget::File(2));
+        assert!(matches!(targets[2], IncludeTarget::Missing { ignore_failure: true, .. }));
+        assert_eq!(targets[3], IncludeTarget::File(1));
+        assert_eq!(includes[3].kind, IncludeKind::IncludeAgain);
+        assert_eq!(includes[1].text, "<B>");
+        assert_eq!(includes[3].row, 3);
+        assert_eq!(graph.files()[2].includes()[0].target, IncludeTarget::File(1));
+
+        // Nothing changed, so nothing is parsed again; then only the edited file is
+        assert_eq!(project.load(&main).unwrap().parsed_count(), 0);
+        fs::write(dir.join("Lib/B.ahk"), "#Include a.ahk\nB() => A() + 1\n").unwrap();
+        let graph = project.load(&main).unwrap();
+        assert_eq!(graph.parsed_count(), 1);
+        project.evict_unused();
+        assert_eq!(project.cached_count(), 3);
+
+        fs::remove_dir_all(&dir).unwrap();
+    }
 }
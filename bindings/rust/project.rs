@@ -0,0 +1,563 @@
+//! Parsing a whole script project: a main script and every file it pulls in through `#Include` and `#IncludeAgain`.
+//!
+//! Files are parsed in parallel on rayon's work-stealing pool, each one as soon as the file including it has been
+//! parsed and its directives resolved. Trees are cached by content, so loading the project again only parses the
+//! files whose contents changed.
+//!
+//! ```no_run
+//! use tree_sitter_autohotkey::{IncludeTarget, Project, ProjectOptions};
+//!
+//! let project = Project::new(ProjectOptions::default());
+//! let graph = project.load("Main.ahk")?;
+//! for file in graph.files() {
+//!     for include in file.includes() {
+//!         if let IncludeTarget::File(index) = include.target {
+//!             let included = graph.files()[index].path();
+//!             println!("{} includes {}", file.path().display(), included.display());
+//!         }
+//!     }
+//! }
+//!
+//! // Later loads reuse the trees of every file that hasn't changed since.
+//! let graph = project.load("Main.ahk")?;
+//! # Ok::<(), std::io::Error>(())
+//! ```
+
+use std::cell::RefCell;
+use std::collections::hash_map::DefaultHasher;
+use std::collections::HashMap;
+use std::hash::{Hash, Hasher};
+use std::ops::Range;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+use std::{fs, io};
+
+use tree_sitter::{Parser, Tree};
+
+use crate::SourceEncoding;
+
+/// Where `#Include` directives look for files.
+#[derive(Clone, Debug, Default)]
+pub struct ProjectOptions {
+    /// Library folders searched for `#Include <Name>`, in order, after the main script's own `Lib` folder. AutoHotkey
+    /// itself goes on to the user library (`%A_MyDocuments%\AutoHotkey\Lib`) and then the standard library (`Lib`
+    /// next to AutoHotkey.exe); add those here to resolve includes the same way.
+    pub lib_dirs: Vec<PathBuf>,
+
+    /// Values of `%Name%` references in include paths, matched case-insensitively. `A_ScriptDir`,
+    /// `A_ScriptFullPath`, `A_ScriptName` and `A_LineFile` are always known; anything else (say `A_AppData`) has to
+    /// be given here, or the include is reported as missing.
+    pub variables: HashMap<String, String>,
+}
+
+/// Which directive an [`Include`] came from.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum IncludeKind {
+    /// `#Include`, which AutoHotkey skips for a file that's already been included
+    Include,
+    /// `#IncludeAgain`, which includes the file every time
+    IncludeAgain,
+}
+
+/// What an [`Include`] resolved to.
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub enum IncludeTarget {
+    /// The file at this index in [`ProjectGraph::files`]
+    File(usize),
+    /// A directory, which changes where the relative includes after it in the same file are looked up
+    Directory(PathBuf),
+    /// Nothing to include: no file at `path` (for a library include, in the first library folder), a library not
+    /// found in any folder, or a `%Name%` that isn't known. `ignore_failure` is set for `#Include *i`, which
+    /// AutoHotkey doesn't treat as an error.
+    Missing { path: PathBuf, ignore_failure: bool },
+}
+
+/// One `#Include` or `#IncludeAgain` directive.
+#[derive(Clone, Debug)]
+pub struct Include {
+    pub kind: IncludeKind,
+    /// The path as written, quotes and `<>` included
+    pub text: String,
+    /// Byte range of the directive in the including file's tree
+    pub byte_range: Range<usize>,
+    /// Row of the directive, counted from 0
+    pub row: usize,
+    pub target: IncludeTarget,
+}
+
+/// A parsed script. Byte offsets in its tree (and in [`Include::byte_range`]) are relative to the end of the byte
+/// order mark, as for [`crate::MappedSource`].
+#[derive(Clone, Debug)]
+pub struct ProjectFile {
+    path: PathBuf,
+    source: Arc<Source>,
+    includes: Vec<Include>,
+}
+
+impl ProjectFile {
+    /// The file's canonical path.
+    pub fn path(&self) -> &Path {
+        &self.path
+    }
+
+    /// The file's syntax tree. It's shared with the project's cache, so clone it before editing.
+    pub fn tree(&self) -> &Tree {
+        &self.source.tree
+    }
+
+    pub fn encoding(&self) -> SourceEncoding {
+        self.source.encoding
+    }
+
+    /// Length of the byte order mark, or 0 if there is none.
+    pub fn bom_len(&self) -> usize {
+        self.source.bom_len
+    }
+
+    /// The text after the byte order mark, in [`encoding`](Self::encoding), as the tree was parsed from.
+    pub fn text(&self) -> &[u8] {
+        &self.source.bytes[self.source.bom_len..]
+    }
+
+    /// The file's include directives, in document order.
+    pub fn includes(&self) -> &[Include] {
+        &self.includes
+    }
+}
+
+/// The files of a project and the includes between them.
+#[derive(Clone, Debug)]
+pub struct ProjectGraph {
+    files: Vec<ProjectFile>,
+    parsed: usize,
+}
+
+impl ProjectGraph {
+    /// Every file of the project, each once: the main script first, then the others in the order AutoHotkey first
+    /// includes them.
+    pub fn files(&self) -> &[ProjectFile] {
+        &self.files
+    }
+
+    pub fn main(&self) -> &ProjectFile {
+        &self.files[0]
+    }
+
+    /// The file at `path`, if it's part of the project.
+    pub fn file(&self, path: impl AsRef<Path>) -> Option<&ProjectFile> {
+        let path = fs::canonicalize(path.as_ref()).ok()?;
+        self.files.iter().find(|file| file.path == path)
+    }
+
+    /// How many files this load parsed. The others' trees came from the project's cache.
+    pub fn parsed_count(&self) -> usize {
+        self.parsed
+    }
+
+    /// Includes that resolved to nothing and aren't `#Include *i`, with the file each is in.
+    pub fn missing(&self) -> impl Iterator<Item = (&ProjectFile, &Include)> {
+        self.files.iter().flat_map(|file| {
+            let missing = |include: &&Include| {
+                matches!(include.target, IncludeTarget::Missing { ignore_failure: false, .. })
+            };
+            file.includes.iter().filter(missing).map(move |include| (file, include))
+        })
+    }
+
+    /// Renumbers `files` (main script first) in the order AutoHotkey would include them: depth first, following
+    /// each file's includes in document order. The parallel load numbers them in whatever order they were found.
+    fn ordered(files: Vec<ProjectFile>, parsed: usize) -> Self {
+        let mut order = Vec::with_capacity(files.len());
+        let mut renumbered = vec![usize::MAX; files.len()];
+        let mut stack = vec![0];
+        while let Some(index) = stack.pop() {
+            if renumbered[index] != usize::MAX {
+                continue;
+            }
+            renumbered[index] = order.len();
+            order.push(index);
+            for include in files[index].includes.iter().rev() {
+                if let IncludeTarget::File(target) = include.target {
+                    stack.push(target);
+                }
+            }
+        }
+
+        let mut files: Vec<Option<ProjectFile>> = files.into_iter().map(Some).collect();
+        let files = order
+            .into_iter()
+            .map(|index| {
+                let mut file = files[index].take().unwrap();
+                for include in &mut file.includes {
+                    if let IncludeTarget::File(target) = &mut include.target {
+                        *target = renumbered[*target];
+                    }
+                }
+                file
+            })
+            .collect();
+        Self { files, parsed }
+    }
+}
+
+/// Loads script projects, keeping the tree of every file it has parsed for the next load. Share one `Project`
+/// between loads (and threads) to get the most out of the cache; [`evict_unused`](Self::evict_unused) drops trees
+/// the last load didn't need.
+///
+/// Loads run on the current rayon pool; call [`load`](Self::load) inside `ThreadPool::install` to pick another one.
+pub struct Project {
+    options: ProjectOptions,
+    cache: Mutex<HashMap<u64, CacheSlot>>,
+    generation: AtomicU64,
+}
+
+impl Project {
+    pub fn new(options: ProjectOptions) -> Self {
+        Self {
+            options,
+            cache: Mutex::new(HashMap::new()),
+            generation: AtomicU64::new(0),
+        }
+    }
+
+    /// Reads and parses the script at `main` and every file it includes, directly or not. Only failing to read
+    /// `main` is an error; includes that can't be resolved or read are reported as [`IncludeTarget::Missing`].
+    pub fn load(&self, main: impl AsRef<Path>) -> io::Result<ProjectGraph> {
+        let main = fs::canonicalize(main.as_ref())?;
+        let bytes = fs::read(&main)?;
+        let load = Load {
+            project: self,
+            script_dir: main.parent().map(Path::to_path_buf).unwrap_or_default(),
+            main: main.clone(),
+            generation: self.generation.fetch_add(1, Ordering::Relaxed) + 1,
+            state: Mutex::new(LoadState {
+                index: HashMap::from([(main.clone(), 0)]),
+                files: vec![None],
+                parsed: 0,
+            }),
+        };
+        rayon::scope(|scope| load.spawn(scope, 0, main, bytes));
+
+        let state = load.state.into_inner().unwrap();
+        let files = state.files.into_iter().map(Option::unwrap).collect();
+        Ok(ProjectGraph::ordered(files, state.parsed))
+    }
+
+    /// Drops the cached trees of files that the most recent load didn't include. Graphs already returned keep
+    /// theirs.
+    pub fn evict_unused(&self) {
+        let generation = self.generation.load(Ordering::Relaxed);
+        self.cache.lock().unwrap().retain(|_, slot| slot.generation == generation);
+    }
+
+    /// How many distinct file contents have a cached tree.
+    pub fn cached_count(&self) -> usize {
+        self.cache.lock().unwrap().len()
+    }
+
+    /// The parsed form of `bytes`, from the cache if the same contents were parsed before. Returns whether it had to
+    /// be parsed.
+    fn source(&self, bytes: Vec<u8>, generation: u64) -> (Arc<Source>, bool) {
+        let mut hasher = DefaultHasher::new();
+        bytes.hash(&mut hasher);
+        let hash = hasher.finish();
+
+        if let Some(slot) = self.cache.lock().unwrap().get_mut(&hash) {
+            // A 64-bit hash can still collide, so only the same bytes count as a hit
+            if slot.source.bytes == bytes {
+                slot.generation = generation;
+                return (slot.source.clone(), false);
+            }
+        }
+
+        // Parsed without holding the lock, so other files parse meanwhile
+        let source = Arc::new(Source::parse(bytes));
+        let slot = CacheSlot {
+            source: source.clone(),
+            generation,
+        };
+        self.cache.lock().unwrap().insert(hash, slot);
+        (source, true)
+    }
+}
+
+struct CacheSlot {
+    source: Arc<Source>,
+    generation: u64,
+}
+
+/// A file's contents, its tree and its include directives, none of which depend on where the file is.
+#[derive(Debug)]
+struct Source {
+    bytes: Vec<u8>,
+    encoding: SourceEncoding,
+    bom_len: usize,
+    tree: Tree,
+    directives: Vec<Directive>,
+}
+
+#[derive(Debug)]
+struct Directive {
+    kind: IncludeKind,
+    ignore_failure: bool,
+    path: String,
+    byte_range: Range<usize>,
+    row: usize,
+}
+
+thread_local! {
+    /// One parser per pool thread, created by the first file that thread parses.
+    static PARSER: RefCell<Option<Parser>> = const { RefCell::new(None) };
+}
+
+impl Source {
+    fn parse(bytes: Vec<u8>) -> Self {
+        let (encoding, bom_len) = SourceEncoding::detect(&bytes);
+        let text = &bytes[bom_len..];
+        let tree = PARSER.with(|parser| {
+            let mut parser = parser.borrow_mut();
+            let parser = parser.get_or_insert_with(|| {
+                let mut parser = Parser::new();
+                parser
+                    .set_language(&crate::LANGUAGE.into())
+                    .expect("Error loading AutoHotkey parser");
+                parser
+            });
+            match encoding {
+                SourceEncoding::Utf8 => parser.parse(text, None),
+                // The runtime reads code units as bytes in the order they're stored, whatever the byte order
+                SourceEncoding::Utf16Le => parser.parse_utf16_le(utf16_units(text), None),
+                SourceEncoding::Utf16Be => parser.parse_utf16_be(utf16_units(text), None),
+            }
+        });
+        // Parsing only returns no tree when it's cancelled or has no language, and neither happens here
+        let tree = tree.expect("parse failed");
+        let directives = find_directives(&tree, text, encoding);
+        Self {
+            bytes,
+            encoding,
+            bom_len,
+            tree,
+            directives,
+        }
+    }
+}
+
+fn utf16_units(text: &[u8]) -> Vec<u16> {
+    text.chunks_exact(2)
+        .map(|pair| u16::from_ne_bytes([pair[0], pair[1]]))
+        .collect()
+}
+
+fn decode(text: &[u8], range: Range<usize>, encoding: SourceEncoding) -> String {
+    let bytes = &text[range];
+    let from_bytes = match encoding {
+        SourceEncoding::Utf8 => return String::from_utf8_lossy(bytes).into_owned(),
+        SourceEncoding::Utf16Le => u16::from_le_bytes,
+        SourceEncoding::Utf16Be => u16::from_be_bytes,
+    };
+    let units: Vec<u16> = bytes
+        .chunks_exact(2)
+        .map(|pair| from_bytes([pair[0], pair[1]]))
+        .collect();
+    String::from_utf16_lossy(&units)
+}
+
+/// The include directives anywhere in `tree`, in document order.
+fn find_directives(tree: &Tree, text: &[u8], encoding: SourceEncoding) -> Vec<Directive> {
+    let mut directives = Vec::new();
+    let mut cursor = tree.walk();
+    'walk: loop {
+        let node = cursor.node();
+        let kind = match node.kind() {
+            "include_directive" => Some(IncludeKind::Include),
+            "include_again_directive" => Some(IncludeKind::IncludeAgain),
+            _ => None,
+        };
+        match (kind, node.child_by_field_name("path")) {
+            (Some(kind), Some(path)) => directives.push(Directive {
+                kind,
+                ignore_failure: node.child_by_field_name("ignore_failure").is_some(),
+                path: decode(text, path.byte_range(), encoding),
+                byte_range: node.byte_range(),
+                row: node.start_position().row,
+            }),
+            (None, _) if cursor.goto_first_child() => continue,
+            _ => {}
+        }
+        while !cursor.goto_next_sibling() {
+            if !cursor.goto_parent() {
+                break 'walk;
+            }
+        }
+    }
+    directives
+}
+
+/// What a directive's path names, before it's been read
+enum Resolved {
+    File(PathBuf),
+    Directory(PathBuf),
+    Missing(PathBuf),
+}
+
+/// One call to [`Project::load`], shared by every task it spawns.
+struct Load<'a> {
+    project: &'a Project,
+    script_dir: PathBuf,
+    main: PathBuf,
+    generation: u64,
+    state: Mutex<LoadState>,
+}
+
+struct LoadState {
+    /// Canonical path -> index in `files`, for every file found so far
+    index: HashMap<PathBuf, usize>,
+    /// Filled in as files finish
+    files: Vec<Option<ProjectFile>>,
+    parsed: usize,
+}
+
+impl Load<'_> {
+    fn spawn<'s>(&'s self, scope: &rayon::Scope<'s>, index: usize, path: PathBuf, bytes: Vec<u8>) {
+        scope.spawn(move |scope| self.visit(scope, index, path, bytes));
+    }
+
+    /// Parses one file (or takes it from the cache), resolves its includes and spawns a task for every file they
+    /// name that no other task has claimed yet.
+    fn visit<'s>(&'s self, scope: &rayon::Scope<'s>, index: usize, path: PathBuf, bytes: Vec<u8>) {
+        let (source, parsed) = self.project.source(bytes, self.generation);
+
+        let mut base = path.parent().map(Path::to_path_buf).unwrap_or_default();
+        let mut includes = Vec::with_capacity(source.directives.len());
+        for directive in &source.directives {
+            let missing = |path| IncludeTarget::Missing {
+                path,
+                ignore_failure: directive.ignore_failure,
+            };
+            let target = match self.resolve(&path, &base, &directive.path) {
+                Resolved::File(file) => match self.claim(scope, file.clone()) {
+                    Some(index) => IncludeTarget::File(index),
+                    None => missing(file),
+                },
+                Resolved::Directory(dir) => {
+                    base = dir.clone();
+                    IncludeTarget::Directory(dir)
+                }
+                Resolved::Missing(path) => missing(path),
+            };
+            includes.push(Include {
+                kind: directive.kind,
+                text: directive.path.clone(),
+                byte_range: directive.byte_range.clone(),
+                row: directive.row,
+                target,
+            });
+        }
+
+        let mut state = self.state.lock().unwrap();
+        state.parsed += usize::from(parsed);
+        state.files[index] = Some(ProjectFile {
+            path,
+            source,
+            includes,
+        });
+    }
+
+    /// The index of the file at `path`. The first include of a file reads it and spawns the task that parses it.
+    /// Returns `None` if it can't be read.
+    fn claim<'s>(&'s self, scope: &rayon::Scope<'s>, path: PathBuf) -> Option<usize> {
+        if let Some(&index) = self.state.lock().unwrap().index.get(&path) {
+            return Some(index);
+        }
+        // Read outside the lock; if another task claims the file meanwhile, its index wins
+        let bytes = fs::read(&path).ok()?;
+        let mut guard = self.state.lock().unwrap();
+        let state = &mut *guard;
+        if let Some(&index) = state.index.get(&path) {
+            return Some(index);
+        }
+        let index = state.files.len();
+        state.index.insert(path.clone(), index);
+        state.files.push(None);
+        drop(guard);
+        self.spawn(scope, index, path, bytes);
+        Some(index)
+    }
+
+    /// Resolves a directive's path the way AutoHotkey does: `<Name>` is looked up as `Name.ahk` in the library
+    /// folders; anything else has its `%Name%` references expanded and, if relative, is taken relative to `base`.
+    fn resolve(&self, file: &Path, base: &Path, text: &str) -> Resolved {
+        // Quotes around the path are optional
+        let text = text.trim().trim_matches(['"', '\'']);
+
+        if let Some(name) = text.strip_prefix('<').and_then(|t| t.strip_suffix('>')) {
+            let name = format!("{}.ahk", native_separators(name));
+            let lib_dirs = self.project.options.lib_dirs.iter().cloned();
+            let dirs = std::iter::once(self.script_dir.join("Lib")).chain(lib_dirs);
+            let candidates: Vec<PathBuf> = dirs.map(|dir| dir.join(&name)).collect();
+            return match candidates.iter().find(|path| path.is_file()) {
+                Some(path) => Resolved::File(canonical(path)),
+                None => Resolved::Missing(candidates.into_iter().next().unwrap()),
+            };
+        }
+
+        let Some(expanded) = self.expand(file, text) else {
+            return Resolved::Missing(PathBuf::from(text));
+        };
+        let path = base.join(native_separators(&expanded));
+        if path.is_dir() {
+            Resolved::Directory(canonical(&path))
+        } else if path.is_file() {
+            Resolved::File(canonical(&path))
+        } else {
+            Resolved::Missing(path)
+        }
+    }
+
+    /// Expands the `%Name%` references in `text`, or returns `None` if one isn't known.
+    fn expand(&self, file: &Path, text: &str) -> Option<String> {
+        let mut expanded = String::with_capacity(text.len());
+        let mut rest = text;
+        while let Some(start) = rest.find('%') {
+            expanded.push_str(&rest[..start]);
+            let name_and_rest = &rest[start + 1..];
+            let end = name_and_rest.find('%')?;
+            expanded.push_str(&self.variable(file, &name_and_rest[..end])?);
+            rest = &name_and_rest[end + 1..];
+        }
+        expanded.push_str(rest);
+        Some(expanded)
+    }
+
+    fn variable(&self, file: &Path, name: &str) -> Option<String> {
+        let path = |path: &Path| Some(path.to_string_lossy().into_owned());
+        match name.to_ascii_lowercase().as_str() {
+            "a_scriptdir" => path(&self.script_dir),
+            "a_scriptfullpath" => path(&self.main),
+            "a_scriptname" => path(Path::new(self.main.file_name()?)),
+            "a_linefile" => path(file),
+            _ => self
+                .project
+                .options
+                .variables
+                .iter()
+                .find(|(key, _)| key.eq_ignore_ascii_case(name))
+                .map(|(_, value)| value.clone()),
+        }
+    }
+}
+
+/// Scripts are written with Windows separators; elsewhere, turn them into the platform's.
+fn native_separators(path: &str) -> String {
+    if cfg!(windows) {
+        path.to_owned()
+    } else {
+        path.replace('\\', "/")
+    }
+}
+
+fn canonical(path: &Path) -> PathBuf {
+    fs::canonicalize(path).unwrap_or_else(|_| path.to_path_buf())
+}
@@ -0,0 +1,123 @@
+//! Parsing script files straight from a memory map, without reading them into a `String` first.
+//!
+//! ```no_run
+//! let mut parser = tree_sitter::Parser::new();
+//! parser.set_language(&tree_sitter_autohotkey::LANGUAGE.into()).unwrap();
+//! // Safety: nothing else modifies the file while it's mapped
+//! let source = unsafe { tree_sitter_autohotkey::MappedSource::open("Gui.ahk") }?;
+//! let tree = source.parse(&mut parser, None).unwrap();
+//! # Ok::<(), std::io::Error>(())
+//! ```
+
+use std::fs::File;
+use std::io;
+use std::path::Path;
+
+use memmap2::Mmap;
+use tree_sitter::{Parser, Tree};
+
+use crate::SourceEncoding;
+
+/// Most bytes handed to the parser per read. Every read is a slice of the map, so this doesn't copy anything; it only
+/// keeps each slice within the runtime's 32-bit lengths.
+const CHUNK: usize = 1 << 20;
+
+/// A memory-mapped script, parsed in place in the encoding its byte order mark names.
+///
+/// The mark itself is not part of the text the parser sees, so byte offsets in the resulting tree are relative to the
+/// end of the mark: add [`bom_len`](Self::bom_len) to get file offsets. In a UTF-16 tree, byte offsets count UTF-16
+/// bytes and columns count bytes too (two per code unit), as the runtime defines them for UTF-16 input.
+pub struct MappedSource {
+    map: Option<Mmap>,
+    encoding: SourceEncoding,
+    bom_len: usize,
+}
+
+impl MappedSource {
+    /// Maps the file at `path` and detects its encoding.
+    ///
+    /// # Safety
+    ///
+    /// The file must not be modified or truncated while the `MappedSource` exists; see [`Mmap::map`].
+    pub unsafe fn open(path: impl AsRef<Path>) -> io::Result<Self> {
+        let file = File::open(path)?;
+        // Zero-length files can't be mapped on every platform.
+        let map = if file.metadata()?.len() == 0 {
+            None
+        } else {
+            Some(Mmap::map(&file)?)
+        };
+        let (encoding, bom_len) = SourceEncoding::detect(map.as_deref().unwrap_or_default());
+        Ok(Self {
+            map,
+            encoding,
+            bom_len,
+        })
+    }
+
+    pub fn encoding(&self) -> SourceEncoding {
+        self.encoding
+    }
+
+    /// Length of the byte order mark, or 0 if there is none.
+    pub fn bom_len(&self) -> usize {
+        self.bom_len
+    }
+
+    /// The text after the byte order mark, in [`encoding`](Self::encoding).
+    pub fn text(&self) -> &[u8] {
+        &self.map.as_deref().unwrap_or_default()[self.bom_len..]
+    }
+
+    /// Parses the text with `parser`, which must have been set to this grammar. `old_tree` is as for
+    /// [`Parser::parse`].
+    pub fn parse(&self, parser: &mut Parser, old_tree: Option<&Tree>) -> Option<Tree> {
+        let text = self.text();
+        match self.encoding {
+            SourceEncoding::Utf8 => parser.parse_with_options(
+                &mut |offset, _| &text[offset.min(text.len())..text.len().min(offset + CHUNK)],
+                old_tree,
+                None,
+            ),
+            SourceEncoding::Utf16Le => {
+                let units = utf16_units(text);
+                parser.parse_utf16_le_with_options(
+                    &mut |offset, _| chunk(units, offset),
+                    old_tree,
+                    None,
+                )
+            }
+            SourceEncoding::Utf16Be => {
+                let units = utf16_units(text);
+                parser.parse_utf16_be_with_options(
+                    &mut |offset, _| chunk(units, offset),
+                    old_tree,
+                    None,
+                )
+            }
+        }
+    }
+}
+
+/// Maps and parses the file at `path` in one go; see [`MappedSource`].
+///
+/// # Safety
+///
+/// As for [`MappedSource::open`]. The mapping is dropped before this returns.
+pub unsafe fn parse_file(parser: &mut Parser, path: impl AsRef<Path>) -> io::Result<Option<Tree>> {
+    Ok(MappedSource::open(path)?.parse(parser, None))
+}
+
+/// The text as UTF-16 code units, without copying. The runtime reads them back as bytes in the order they're stored,
+/// so this is correct for either byte order on any host. A trailing odd byte is dropped.
+fn utf16_units(text: &[u8]) -> &[u16] {
+    // Safety: any two bytes are a valid u16.
+    let (head, units, _) = unsafe { text.align_to::<u16>() };
+    // Maps are page-aligned and byte order marks are two bytes, so the text always starts on a unit boundary.
+    assert!(head.is_empty(), "UTF-16 text is not 2-byte aligned");
+    units
+}
+
+fn chunk(units: &[u16], offset: usize) -> &[u16] {
+    &units[offset.min(units.len())..units.len().min(offset + CHUNK / 2)]
+}
@@ -0,0 +1,117 @@
+// Coverage-guided fuzz target for the grammar, aimed mostly at the external scanner.
+//
+// Every input is parsed once and its tree walked. Besides the crashes, leaks and undefined behaviour the sanitizers
+// catch, an input fails when it parses too slowly for its size: more than AHK_FUZZ_MAX_NS_PER_BYTE nanoseconds per
+// byte (default below), counting inputs shorter than AHK_FUZZ_MIN_BUDGET_BYTES as that long so tiny inputs aren't
+// judged on timer noise. A slow parse is retried before failing, so a preempted run doesn't count. libFuzzer's own
+// -timeout catches hangs outright.
+//
+// Built as `tree-sitter-autohotkey-fuzz` with -DTREE_SITTER_AHK_FUZZ=ON and Clang; with other compilers only the
+// replay driver, `tree-sitter-autohotkey-fuzz-replay`, is built. It runs the same checks over the files it's given:
+//
+//   tree-sitter-autohotkey-fuzz-replay slow-unit-0123abcd test/pathological/*.ahk
+
+#include <tree_sitter/api.h>
+#include <tree_sitter/tree-sitter-autohotkey.h>
+
+#include "support.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DEFAULT_MAX_NS_PER_BYTE 20000
+#define DEFAULT_MIN_BUDGET_BYTES 4096
+#define SLOW_RETRIES 2
+
+static TSParser *parser;
+static double max_ns_per_byte = DEFAULT_MAX_NS_PER_BYTE;
+static size_t min_budget_bytes = DEFAULT_MIN_BUDGET_BYTES;
+static uint64_t last_ns;  ///< fastest parse of the last input, for the replay driver
+
+static double env_number(const char *name, double fallback) {
+  const char *value = getenv(name);
+  if (!value || !*value) return fallback;
+  char *end;
+  double number = strtod(value, &end);
+  if (*end || number <= 0) {
+    fprintf(stderr, "%s must be a positive number, not '%s'\n", name, value);
+    exit(2);
+  }
+  return number;
+}
+
+int LLVMFuzzerInitialize(int *argc, char ***argv) {
+  (void)argc;
+  (void)argv;
+  parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_autohotkey());
+  max_ns_per_byte = env_number("AHK_FUZZ_MAX_NS_PER_BYTE", DEFAULT_MAX_NS_PER_BYTE);
+  min_budget_bytes = (size_t)env_number("AHK_FUZZ_MIN_BUDGET_BYTES", DEFAULT_MIN_BUDGET_BYTES);
+  return 0;
+}
+
+/// Parses `data` and visits every node, so the tree is read back as well as built. Returns the parse time.
+static uint64_t parse(const uint8_t *data, uint32_t size) {
+  uint64_t start = now_ns();
+  TSTree *tree = ts_parser_parse_string(parser, NULL, (const char *)data, size);
+  uint64_t elapsed = now_ns() - start;
+  if (!tree) {
+    fprintf(stderr, "parse returned no tree\n");
+    abort();
+  }
+
+  TSNode root = ts_tree_root_node(tree);
+  if (ts_node_end_byte(root) > size) {
+    fprintf(stderr, "root node ends at byte %u of a %u-byte input\n", ts_node_end_byte(root), size);
+    abort();
+  }
+  TSTreeCursor cursor = ts_tree_cursor_new(root);
+  for (;;) {
+    if (ts_tree_cursor_goto_first_child(&cursor)) continue;
+    while (!ts_tree_cursor_goto_next_sibling(&cursor)) {
+      if (!ts_tree_cursor_goto_parent(&cursor)) goto done;
+    }
+  }
+done:
+  ts_tree_cursor_delete(&cursor);
+  ts_tree_delete(tree);
+  return elapsed;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (size > UINT32_MAX) return -1;
+  double budget = (double)(size > min_budget_bytes ? size : min_budget_bytes) * max_ns_per_byte;
+
+  last_ns = parse(data, (uint32_t)size);
+  for (int retry = 0; retry < SLOW_RETRIES && last_ns > budget; retry++) {
+    uint64_t again = parse(data, (uint32_t)size);
+    if (again < last_ns) last_ns = again;
+  }
+  if (last_ns > budget) {
+    // Minimize with -minimize_crash=1 and add the result to test/pathological (see CONTRIBUTING.md).
+    fprintf(stderr, "slow input: %zu bytes parsed in %.1f ms, %.0f ns/byte (limit %.0f ns/byte)\n", size,
+            (double)last_ns / 1e6, (double)last_ns / (double)(size ? size : 1), max_ns_per_byte);
+    abort();
+  }
+  return 0;
+}
+
+#ifdef TREE_SITTER_AHK_FUZZ_REPLAY
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s FILE...\n", argv[0]);
+    return 2;
+  }
+  LLVMFuzzerInitialize(&argc, &argv);
+  for (int i = 1; i < argc; i++) {
+    Buffer input = {0};
+    if (!read_file(argv[i], &input)) return 1;
+    LLVMFuzzerTestOneInput((const uint8_t *)input.data, input.len);
+    printf("%s: %zu bytes, %.1f ms\n", argv[i], input.len, (double)last_ns / 1e6);
+    free(input.data);
+  }
+  ts_parser_delete(parser);
+  return 0;
+}
+#endif
@@ -0,0 +1,23 @@
+; Fold queries for tree-sitter-autohotkey.
+; Each @fold capture is a foldable range: bodies of definitions and control flow, bracketed literals spanning lines,
+; and the multi-line comments and continuation sections that tend to be long. Editors only fold captures that span
+; more than one line, so single-line bodies cost nothing.
+
+[
+  (function_body)
+  (class_body)
+  (struct_body)
+  (property_declaration_block)
+  (block)
+  (switch_body)
+] @fold
+
+[
+  (object_literal)
+  (array_literal)
+] @fold
+
+[
+  (block_comment)
+  (continuation_section)
+] @fold
@@ -2,6 +2,10 @@
 ; Standard tree-sitter capture names, shoudl be usable by editors (Neovim, Helix, …) and used in
 ; the web playground. Later patterns win over earlier ones on the same range, and narrower (child)
 ; captures win over wider (parent) ones - the consumer is expected to resolve overlaps that way.
+;
+; Patterns are structural wherever the tree allows it. Text predicates are checked by the consumer
+; on every match of their pattern, so the few that remain are grouped near the end and written as
+; a single check per node.
 
 ; --- Directives -------------------------------------------------------------
 [
@@ -59,11 +63,13 @@
 
 (struct_declaration name: (identifier) @type)
 (struct_declaration superclass: (identifier) @type)
-(struct_declaration superclass: (identifier) @type)
+(struct_declaration superclass: (member_access member: (identifier) @type))
 
-; Struct type classes (v2.1 - see https://www.autohotkey.com/docs/alpha/Structs.htm#numeric-types).
-((identifier) @type 
-  (#any-of? @type "Int8" "Int16" "Int32" "Int64" "UInt8" "UInt16" "UInt32" "IntPtr" "Float32" "Float64" ))
+; Field types (v2.1 - see https://www.autohotkey.com/docs/alpha/Structs.htm#type-specs). Covers the
+; numeric types (Int32, Float64, ...) by position rather than by name.
+(type_specifier (identifier) @type)
+(type_specifier (index_access object: (identifier) @type))
+(type_specifier (member_access member: (identifier) @type))
 
 ; --- Parameters -------------------------------------------------------------
 (param_sequence (identifier) @variable.parameter)
@@ -88,13 +94,6 @@
 (call_statement function: (identifier) @function.call)
 (function_call function: (member_access member: (identifier) @function.method))
 
-; --- Builtin variables ------------------------------------------------------
-; A_* automatic variables and `this`.
-((identifier) @variable.builtin
-  (#match? @variable.builtin "^[Aa]_"))
-((identifier) @variable.builtin
-  (#eq? @variable.builtin "this"))
-
 ; --- Literals ---------------------------------------------------------------
 [
   (integer_literal)
@@ -125,6 +124,12 @@
 (hotstring_trigger) @constant.macro
 (hotstring_replacement) @string
 
+; --- Predicate-guarded patterns ---------------------------------------------
+; Builtin variables: A_* automatic variables and `this` (names are case-insensitive). Nothing in the
+; tree tells them apart from other identifiers, so this is one regex per identifier; keep it to one.
+((identifier) @variable.builtin
+  (#match? @variable.builtin "^([Aa]_|[Tt][Hh][Ii][Ss]$)"))
+
 ; --- Comments (last, so they win everywhere) --------------------------------
 [
   (line_comment)
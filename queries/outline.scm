@@ -0,0 +1,23 @@
+; Outline queries for tree-sitter-autohotkey.
+; Editor outline captures (Zed's convention): each match is one @item named by its @name capture, with the words of
+; its signature in @context. The same items bindings/c/outline.c (tree-sitter-autohotkey-outline.h) finds by walking
+; the top of the tree; this query also reports definitions nested in function bodies, which that walk skips.
+; `tree-sitter-autohotkey-outline-bench` compares the two.
+
+; --- Hotkeys, hotstrings & remaps ------------------------------------------
+(hotkey trigger: (hotkey_trigger) @name) @item
+(hotstring trigger: (hotstring_trigger) @name) @item
+(remap origin: (remap_origin) @name) @item
+
+; `#HotIf expr` opens a context the hotkeys after it belong to; a bare `#HotIf` closes it.
+(hotif_directive directive: (directive_name) @context expression: (_)? @name) @item
+
+; --- Functions, classes & structs ------------------------------------------
+(function_declaration name: (identifier) @name) @item
+
+(class_declaration (class) @context name: (identifier) @name) @item
+(struct_declaration (struct) @context name: (identifier) @name) @item
+
+(method_declaration name: (identifier) @name) @item
+(property_declaration name: (identifier) @name) @item
+(typed_property_declaration name: (identifier) @name) @item
@@ -0,0 +1,49 @@
+; Symbol tagging queries for tree-sitter-autohotkey.
+; Standard tree-sitter tag captures (`tree-sitter tags`, GitHub code navigation, indexers): each
+; match is one @definition.* or @reference.* tag named by its @name capture.
+;
+; Built to be run as a single query pass over large codebases: every pattern is rooted at the one
+; node type it tags and reaches its name through a field, and none uses a predicate or a wildcard
+; root, so the cost tracks the number of matches rather than the size of the tree. Keep it that
+; way - a `(_)` or `(identifier)` root pattern makes every node a candidate, and predicates here
+; are filtered by the consumer after the fact. `tree-sitter-autohotkey-bench --query` measures it.
+
+; --- Functions & methods ----------------------------------------------------
+(function_declaration name: (identifier) @name) @definition.function
+(function_expression name: (identifier) @name) @definition.function
+
+(method_declaration name: (identifier) @name) @definition.method
+(property_declaration name: (identifier) @name) @definition.property
+(typed_property_declaration name: (identifier) @name) @definition.property
+
+; --- Classes & structs ------------------------------------------------------
+(class_declaration name: (identifier) @name) @definition.class
+(struct_declaration name: (identifier) @name) @definition.struct
+
+; --- Exports ----------------------------------------------------------------
+; The declaration itself is also tagged above; this adds the module-interface entry.
+(export_declaration declaration: (function_declaration name: (identifier) @name)) @definition.export
+(export_declaration declaration: (class_declaration name: (identifier) @name)) @definition.export
+(export_declaration declaration: (struct_declaration name: (identifier) @name)) @definition.export
+(export_declaration (variable_declaration name: (identifier) @name)) @definition.export
+
+; --- Hotkeys & hotstrings ---------------------------------------------------
+(hotkey trigger: (hotkey_trigger) @name) @definition.hotkey
+(hotstring trigger: (hotstring_trigger) @name) @definition.hotstring
+
+(label name: (identifier) @name) @definition.label
+
+; --- References -------------------------------------------------------------
+(function_call function: (identifier) @name) @reference.call
+(function_call function: (member_access member: (identifier) @name)) @reference.call
+(call_statement function: (identifier) @name) @reference.call
+(call_statement function: (member_access member: (identifier) @name)) @reference.call
+
+(class_declaration superclass: (identifier) @name) @reference.class
+(class_declaration superclass: (member_access member: (identifier) @name)) @reference.class
+(struct_declaration superclass: (identifier) @name) @reference.class
+
+(import_directive module: (identifier) @name) @reference.module
+(import_directive (export_name export: (identifier) @name)) @reference.export
+
+(goto_statement label: (identifier) @name) @reference.label
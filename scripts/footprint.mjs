@@ -0,0 +1,148 @@
+#!/usr/bin/env node
+//
+// Reports the parser's footprint: parse table shape and size from src/parser.c, and optionally the size of built
+// artifacts, checked against the budget in scripts/footprint-budget.json. Run it after `tree-sitter generate` to see
+// whether a grammar change grew the tables:
+//
+//   node scripts/footprint.mjs
+//   node scripts/footprint.mjs --lib libtree-sitter-autohotkey.so --wasm tree-sitter-autohotkey.wasm --check
+//
+// Usage: scripts/footprint.mjs [--lib FILE] [--wasm FILE] [--check] [--json] [--update-budget]
+//   --lib FILE        include the size of a built shared library, and of its lexer functions when `nm` can see them
+//   --wasm FILE       include the size of a built wasm module
+//   --check           exit non-zero if any reported metric exceeds its budget
+//   --json            print the metrics as JSON instead of a table
+//   --update-budget   write the current metrics into the budget file (commit the result alongside the grammar change
+//                     that moved them); sizes of built artifacts get ARTIFACT_HEADROOM on top
+
+import { execFileSync } from 'node:child_process';
+import { readFileSync, statSync, writeFileSync } from 'node:fs';
+import { dirname, join } from 'node:path';
+import { fileURLToPath } from 'node:url';
+
+const ROOT = join(dirname(fileURLToPath(import.meta.url)), '..');
+const PARSER = join(ROOT, 'src', 'parser.c');
+const BUDGET = join(ROOT, 'scripts', 'footprint-budget.json');
+
+// Table metrics come straight from parser.c and are budgeted exactly. Built artifacts also move with the compiler and
+// its flags, so --update-budget leaves them this much room, rounded up to a multiple of 100 bytes.
+const ARTIFACT_KEYS = ['lib_bytes', 'lex_code_bytes', 'keyword_lex_code_bytes', 'wasm_bytes'];
+const ARTIFACT_HEADROOM = 0.1;
+
+function parseArgs(argv) {
+  const args = { lib: null, wasm: null, check: false, json: false, updateBudget: false };
+  for (let i = 0; i < argv.length; i++) {
+    switch (argv[i]) {
+      case '--lib': args.lib = argv[++i]; break;
+      case '--wasm': args.wasm = argv[++i]; break;
+      case '--check': args.check = true; break;
+      case '--json': args.json = true; break;
+      case '--update-budget': args.updateBudget = true; break;
+      default:
+        console.error(`unknown argument '${argv[i]}'`);
+        process.exit(2);
+    }
+  }
+  return args;
+}
+
+function define(source, name) {
+  const m = source.match(new RegExp(`^#define ${name} (\\d+)$`, 'm'));
+  if (!m) throw new Error(`src/parser.c has no ${name}`);
+  return Number(m[1]);
+}
+
+/// Body of the top-level declaration that starts with `head`, up to the closing brace at column 0
+function block(source, head) {
+  const start = source.indexOf(head);
+  if (start < 0) throw new Error(`src/parser.c has no '${head}'`);
+  const end = source.indexOf('\n}', start);
+  return source.slice(start + head.length, end);
+}
+
+const lineCount = text => text.split('\n').length - 1;
+
+/// Number of uint16 words in ts_small_parse_table: one per top-level comma, `[n] =` designators aside
+function smallTableWords(source) {
+  return block(source, 'static const uint16_t ts_small_parse_table[] = {').split(',').length - 1;
+}
+
+/// Machine-code sizes of the generated lexer functions in a built library, from `nm -S`. They are static, so this
+/// needs an unstripped library; returns {} when nm isn't available or the symbols aren't there.
+function lexerCodeSizes(lib) {
+  let symbols;
+  try {
+    symbols = execFileSync('nm', ['-S', lib], { encoding: 'utf8', stdio: ['ignore', 'pipe', 'ignore'] });
+  } catch {
+    return {};
+  }
+  const sizes = {};
+  for (const line of symbols.split('\n')) {
+    const m = line.match(/^[0-9a-f]+ ([0-9a-f]+) [tT] (ts_lex|ts_lex_keywords)$/);
+    if (m) sizes[m[2] === 'ts_lex' ? 'lex_code_bytes' : 'keyword_lex_code_bytes'] = parseInt(m[1], 16);
+  }
+  return sizes;
+}
+
+function measure(args) {
+  const source = readFileSync(PARSER, 'utf8');
+  const states = define(source, 'STATE_COUNT');
+  const largeStates = define(source, 'LARGE_STATE_COUNT');
+  const symbols = define(source, 'SYMBOL_COUNT');
+  const smallWords = smallTableWords(source);
+
+  const metrics = {
+    state_count: states,
+    large_state_count: largeStates,
+    symbol_count: symbols,
+    token_count: define(source, 'TOKEN_COUNT'),
+    // Each large state is a dense row of one uint16 per symbol; the rest share the compressed small table.
+    large_table_bytes: largeStates * symbols * 2,
+    small_table_bytes: smallWords * 2,
+    lex_function_lines: lineCount(block(source, 'static bool ts_lex(TSLexer *lexer, TSStateId state) {')),
+    keyword_lex_function_lines: lineCount(block(source, 'static bool ts_lex_keywords(TSLexer *lexer, TSStateId state) {')),
+  };
+  if (args.lib) Object.assign(metrics, { lib_bytes: statSync(args.lib).size }, lexerCodeSizes(args.lib));
+  if (args.wasm) metrics.wasm_bytes = statSync(args.wasm).size;
+  return metrics;
+}
+
+function readBudget() {
+  try {
+    return JSON.parse(readFileSync(BUDGET, 'utf8'));
+  } catch {
+    return {};
+  }
+}
+
+const args = parseArgs(process.argv.slice(2));
+const metrics = measure(args);
+const budget = readBudget();
+
+if (args.updateBudget) {
+  const limits = Object.fromEntries(Object.entries(metrics).map(([k, v]) =>
+    [k, ARTIFACT_KEYS.includes(k) ? Math.ceil(v * (1 + ARTIFACT_HEADROOM) / 100) * 100 : v]));
+  writeFileSync(BUDGET, JSON.stringify({ ...budget, ...limits }, null, 2) + '\n');
+  console.log(`wrote ${BUDGET}`);
+  process.exit(0);
+}
+
+const over = Object.keys(metrics).filter(k => budget[k] !== undefined && metrics[k] > budget[k]);
+
+if (args.json) {
+  console.log(JSON.stringify(metrics, null, 2));
+} else {
+  const rows = Object.entries(metrics).map(([k, v]) => {
+    const limit = budget[k];
+    const delta = limit === undefined ? '' : `${v - limit >= 0 ? '+' : ''}${v - limit}`;
+    return [k, String(v), limit === undefined ? '-' : String(limit), delta, over.includes(k) ? 'OVER' : ''];
+  });
+  console.log(['| metric | value | budget | vs. budget | |', '| --- | ---: | ---: | ---: | --- |',
+    ...rows.map(r => `| ${r.join(' | ')} |`)].join('\n'));
+}
+
+if (args.check && over.length > 0) {
+  console.error(`\nover budget: ${over.join(', ')}. If the growth is intended, run with --update-budget and commit ` +
+    'scripts/footprint-budget.json.');
+  process.exit(1);
+}
@@ -0,0 +1,74 @@
+#!/usr/bin/env node
+//
+// Writes the source of every test in test/corpus, and every script in test/pathological, to a directory as one file
+// each, to seed the fuzzer (see fuzz/fuzz_parse.c). Sources are extracted the same way bench/bench.c extracts them.
+// The `fuzz` CMake target runs this for you:
+//
+//   node scripts/fuzz-seeds.mjs build/fuzz/seeds
+//
+// Usage: scripts/fuzz-seeds.mjs DIR
+//
+// DIR is created if need be. Seeds from an earlier run (the .ahk files directly in DIR) are replaced; nothing else in
+// it is touched.
+
+import { mkdirSync, readdirSync, readFileSync, unlinkSync, writeFileSync } from 'node:fs';
+import { basename, dirname, join } from 'node:path';
+import { fileURLToPath } from 'node:url';
+
+const ROOT = join(dirname(fileURLToPath(import.meta.url)), '..');
+
+const isDelimiter = (line, c) => line.startsWith(c.repeat(3));
+
+/** The source of each test in a corpus file */
+function corpusSources(text) {
+  const sources = [];
+  let state = 'before';
+  let lines = [];
+  for (const line of text.split(/(?<=\n)/)) {
+    const bare = line.replace(/\r?\n$/, '');
+    if ((state === 'before' || state === 'expected') && isDelimiter(bare, '=')) {
+      state = 'header';
+    } else if (state === 'header' && isDelimiter(bare, '=')) {
+      state = 'source';
+      lines = [];
+    } else if (state === 'source' && isDelimiter(bare, '-')) {
+      sources.push(lines.join(''));
+      state = 'expected';
+    } else if (state === 'source') {
+      lines.push(line);
+    }
+  }
+  return sources;
+}
+
+function listDir(dir, suffix) {
+  try {
+    return readdirSync(dir).filter((f) => f.endsWith(suffix)).sort().map((f) => join(dir, f));
+  } catch {
+    return [];
+  }
+}
+
+const out = process.argv[2];
+if (!out || out.startsWith('-') || process.argv.length > 3) {
+  console.error('usage: scripts/fuzz-seeds.mjs DIR');
+  process.exit(2);
+}
+
+mkdirSync(out, { recursive: true });
+for (const entry of readdirSync(out, { withFileTypes: true })) {
+  if (entry.isFile() && entry.name.endsWith('.ahk')) unlinkSync(join(out, entry.name));
+}
+
+let count = 0;
+for (const file of listDir(join(ROOT, 'test', 'corpus'), '.txt')) {
+  corpusSources(readFileSync(file, 'utf8')).forEach((source, i) => {
+    writeFileSync(join(out, `${basename(file, '.txt')}-${i + 1}.ahk`), source);
+    count++;
+  });
+}
+for (const file of listDir(join(ROOT, 'test', 'pathological'), '.ahk')) {
+  writeFileSync(join(out, basename(file)), readFileSync(file));
+  count++;
+}
+console.log(`wrote ${count} seeds to ${out}`);
@@ -0,0 +1,259 @@
+#!/usr/bin/env node
+//
+// Generates src/keywords.h, the external scanner's word classifier, from the key table below.
+//
+// Every word the scanner needs to recognize (keywords, key names, continuation options, ...) is listed once
+// together with the classes it belongs to. The generator builds a minimal-ish perfect hash over the case-folded
+// words (FNV-1a plus a per-bucket displacement), so a lookup is one hash over the word plus one compare, regardless
+// of how many entries there are. Edit the table, then run:
+//
+//   node scripts/gen-keywords.mjs
+//
+// Usage: scripts/gen-keywords.mjs [--check]
+//   --check  exit non-zero if src/keywords.h is out of date instead of rewriting it
+
+import { readFileSync, writeFileSync } from 'node:fs';
+import { dirname, join } from 'node:path';
+import { fileURLToPath } from 'node:url';
+
+const OUTPUT = join(dirname(fileURLToPath(import.meta.url)), '..', 'src', 'keywords.h');
+
+const args = process.argv.slice(2);
+if (args.length > 1 || (args.length === 1 && args[0] !== '--check')) {
+  console.error('usage: scripts/gen-keywords.mjs [--check]');
+  process.exit(2);
+}
+const check = args.length === 1;
+
+// Word classes, in bit order. Descriptions end up as comments in the generated header.
+const CLASSES = [
+  ['FLOW', 'Control-flow keyword; functions may not be named after one'],
+  ['OPERATOR', 'Word operator; functions may not be named after one'],
+  ['CONCAT_BREAK', 'Word operator that ends an implicit concatenation (`a and b` is not `a . "and" . b`)'],
+  ['LINE_CONTINUATION', 'Word operator that, at the start of a line, continues the previous line'],
+  ['STATIC', '`static`, which may prefix a function or method declaration'],
+  ['EXPORT', 'The `export` keyword'],
+  ['EXPORT_FOLLOWER', 'Word that, after `export`, always begins an export declaration'],
+  ['ALTTAB', 'AltTab command, which is a hotkey action rather than a remap destination'],
+  ['REMAP_KEY', 'Named key that can be a remap destination (see https://www.autohotkey.com/docs/v2/KeyList.htm)'],
+  ['CONT_COMMENTS', 'Continuation section `Comments` option and its abbreviations'],
+  ['CONT_TRIM', 'Continuation section trim option'],
+];
+
+const range = (lo, hi) => Array.from({ length: hi - lo + 1 }, (_, i) => lo + i);
+
+// Single-character keys and the Sc###/Vk## code forms are matched algorithmically by the scanner and are not
+// listed here.
+const TABLE = {
+  FLOW: ['if', 'else', 'while', 'for', 'loop', 'throw', 'try', 'catch', 'finally', 'break', 'continue', 'as', 'in',
+    'switch', 'case', 'default', 'goto', 'return'],
+  OPERATOR: ['and', 'not', 'is', 'or', 'contains'],
+  CONCAT_BREAK: ['and', 'not', 'is', 'or'],
+  LINE_CONTINUATION: ['and', 'or', 'is'],
+  STATIC: ['static'],
+  EXPORT: ['export'],
+  EXPORT_FOLLOWER: ['default', 'global', 'class', 'struct'],
+  ALTTAB: ['AltTab', 'ShiftAltTab', 'AltTabMenu', 'AltTabAndMenu', 'AltTabMenuDismiss'],
+  REMAP_KEY: [
+    'Alt', 'AppsKey',
+    'Backspace', 'BS', 'Browser_Back', 'Browser_Forward', 'Browser_Refresh', 'Browser_Stop', 'Browser_Search',
+    'Browser_Favorites', 'Browser_Home',
+    'CapsLock', 'Control', 'Ctrl', 'CtrlBreak',
+    'Delete', 'Del', 'Down',
+    'End', 'Enter', 'Escape', 'Esc',
+    ...range(1, 24).map(n => `F${n}`),
+    'Help', 'Home',
+    'Insert', 'Ins',
+    'LAlt', 'Launch_Mail', 'Launch_Media', 'Launch_App1', 'Launch_App2', 'LButton', 'LControl', 'LCtrl', 'Left',
+    'LShift', 'LWin',
+    'MButton', 'Media_Next', 'Media_Prev', 'Media_Stop', 'Media_Play_Pause',
+    'NumLock',
+    ...range(0, 9).map(n => `Numpad${n}`),
+    ...['Ins', 'End', 'Down', 'PgDn', 'Left', 'Clear', 'Right', 'Home', 'Up', 'PgUp', 'Del', 'Dot', 'Div', 'Mult',
+      'Add', 'Sub', 'Enter'].map(s => `Numpad${s}`),
+    'Pause', 'PgDn', 'PgUp', 'PrintScreen',
+    'RAlt', 'RButton', 'RControl', 'RCtrl', 'Right', 'RShift', 'RWin',
+    'ScrollLock', 'Shift', 'Sleep', 'Space',
+    'Tab',
+    'Up',
+    'Volume_Mute', 'Volume_Down', 'Volume_Up',
+    'WheelDown', 'WheelUp', 'WheelLeft', 'WheelRight',
+    'XButton1', 'XButton2',
+  ],
+  CONT_COMMENTS: ['comments', 'comment', 'com', 'c'],
+  CONT_TRIM: ['ltrim', 'ltrim0', 'rtrim0'],
+};
+
+const FNV_SEED = 0x811c9dc5;
+const FNV_PRIME = 0x01000193;
+const MIX = 0x9e3779b1;
+
+function fnv(word) {
+  let h = FNV_SEED;
+  for (const ch of word) {
+    h = Math.imul(h ^ ch.charCodeAt(0), FNV_PRIME) >>> 0;
+  }
+  return h;
+}
+
+const bucketOf = (h, bucketBits) => h >>> (32 - bucketBits);
+const slotOf = (h, disp, slotBits) => Math.imul((h ^ disp) >>> 0, MIX) >>> (32 - slotBits);
+
+function buildEntries() {
+  const entries = new Map();
+  for (const [bit, [cls]] of CLASSES.entries()) {
+    for (const word of TABLE[cls]) {
+      if (!/^[A-Za-z0-9_]+$/.test(word)) {
+        throw new Error(`${cls}: '${word}' is not an identifier-like word`);
+      }
+      const key = word.toLowerCase();
+      entries.set(key, (entries.get(key) ?? 0) | (1 << bit));
+    }
+  }
+  return [...entries].map(([word, classes]) => ({ word, classes }));
+}
+
+// Hash-and-displace: words are grouped into buckets by the top bits of their hash, and each bucket gets a
+// displacement that sends all of its words to free slots. Buckets are placed largest first.
+function buildTable(entries) {
+  for (let slotBits = Math.ceil(Math.log2(entries.length * 1.25)); slotBits <= 16; slotBits++) {
+    const bucketBits = Math.max(1, slotBits - 2);
+    const buckets = Array.from({ length: 1 << bucketBits }, () => []);
+    entries.forEach((e, i) => buckets[bucketOf(fnv(e.word), bucketBits)].push(i));
+
+    const disps = new Array(1 << bucketBits).fill(0);
+    const slots = new Array(1 << slotBits).fill(0);
+    const order = [...buckets.keys()].sort((a, b) => buckets[b].length - buckets[a].length);
+
+    const placed = order.every(b => {
+      if (buckets[b].length === 0) return true;
+      for (let disp = 0; disp < 0x10000; disp++) {
+        const targets = buckets[b].map(i => slotOf(fnv(entries[i].word), disp, slotBits));
+        if (new Set(targets).size === targets.length && targets.every(t => slots[t] === 0)) {
+          targets.forEach((t, k) => { slots[t] = buckets[b][k] + 1; });
+          disps[b] = disp;
+          return true;
+        }
+      }
+      return false;
+    });
+
+    if (placed) {
+      return { bucketBits, slotBits, disps, slots };
+    }
+  }
+  throw new Error('could not place every word');
+}
+
+function render(entries, { bucketBits, slotBits, disps, slots }) {
+  const maxLen = Math.max(...entries.map(e => e.word.length));
+  const classMaxLen = bit => Math.max(...entries.filter(e => e.classes & (1 << bit)).map(e => e.word.length));
+  const indexType = entries.length < 255 ? 'uint8_t' : 'uint16_t';
+
+  const hex = n => `0x${n.toString(16).padStart(8, '0')}u`;
+  const classMask = c => CLASSES.filter((_, bit) => c & (1 << bit)).map(([name]) => `KW_${name}`).join(' | ');
+  const rows = items => {
+    const out = [];
+    for (let i = 0; i < items.length; i += 16) out.push(`  ${items.slice(i, i + 16).join(', ')},`);
+    return out.join('\n');
+  };
+
+  return `// Generated by scripts/gen-keywords.mjs from the key table in that script. Do not edit by hand.
+
+#ifndef TREE_SITTER_AUTOHOTKEY_KEYWORDS_H_
+#define TREE_SITTER_AUTOHOTKEY_KEYWORDS_H_
+
+#include <stdint.h>
+
+// Word classes. A word may belong to several.
+${CLASSES.map(([name, desc], bit) => `#define KW_${name} (1u << ${bit})  ///< ${desc}`).join('\n')}
+
+/// Length of the longest word in the table; anything longer is not a keyword
+#define KW_MAX_LEN ${maxLen}
+
+/// Size for identifier buffers passed to keyword_classes: the longest word plus a terminator
+#define KW_BUF_SIZE (KW_MAX_LEN + 1)
+
+// Length of the longest word in each class. A probe that only tests one class can stop reading a word one character
+// past this, since a longer word can't be in it; reading less keeps the token's lookahead (what an edit invalidates)
+// short.
+${CLASSES.map(([name], bit) => `#define KW_${name}_MAX_LEN ${classMaxLen(bit)}`).join('\n')}
+
+#define KW_BUCKET_BITS ${bucketBits}
+#define KW_SLOT_BITS ${slotBits}
+
+typedef struct {
+  const char *word;  ///< lowercase
+  uint8_t len;
+  uint16_t classes;
+} KeywordEntry;
+
+static const KeywordEntry keyword_entries[${entries.length}] = {
+${entries.map(e => `  {"${e.word}", ${e.word.length}, ${classMask(e.classes)}},`).join('\n')}
+};
+
+/// Per-bucket hash displacement
+static const uint16_t keyword_displacements[1 << KW_BUCKET_BITS] = {
+${rows(disps.map(String))}
+};
+
+/// Hash slot -> 1 + index into keyword_entries, 0 for an empty slot
+static const ${indexType} keyword_slots[1 << KW_SLOT_BITS] = {
+${rows(slots.map(String))}
+};
+
+/// @brief Classifies a word against the keyword table. Case-insensitive, ASCII only.
+/// @param word the word's characters; need not be terminated
+/// @param len length of the word. Words longer than KW_MAX_LEN never match, so callers may pass the full length
+///        of an identifier whose buffer only kept its first KW_MAX_LEN characters
+/// @return bitmask of KW_* classes the word belongs to, 0 if it is not in the table
+static inline uint16_t keyword_classes(const char *word, int len) {
+  if (len <= 0 || len > KW_MAX_LEN) {
+    return 0;
+  }
+
+  uint32_t h = ${hex(FNV_SEED)};
+  for (int i = 0; i < len; i++) {
+    char c = word[i];
+    if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+    h = (h ^ (uint8_t)c) * ${hex(FNV_PRIME)};
+  }
+
+  uint32_t disp = keyword_displacements[h >> (32 - KW_BUCKET_BITS)];
+  uint32_t slot = keyword_slots[((h ^ disp) * ${hex(MIX)}) >> (32 - KW_SLOT_BITS)];
+  if (slot == 0) {
+    return 0;
+  }
+
+  const KeywordEntry *entry = &keyword_entries[slot - 1];
+  if (entry->len != len) {
+    return 0;
+  }
+  for (int i = 0; i < len; i++) {
+    char c = word[i];
+    if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+    if (c != entry->word[i]) {
+      return 0;
+    }
+  }
+  return entry->classes;
+}
+
+#endif // TREE_SITTER_AUTOHOTKEY_KEYWORDS_H_
+`;
+}
+
+const entries = buildEntries().sort((a, b) => (a.word < b.word ? -1 : a.word > b.word ? 1 : 0));
+const header = render(entries, buildTable(entries));
+
+if (check) {
+  let current = '';
+  try { current = readFileSync(OUTPUT, 'utf8'); } catch { /* missing counts as stale */ }
+  if (current !== header) {
+    console.error('src/keywords.h is out of date; run `node scripts/gen-keywords.mjs`');
+    process.exit(1);
+  }
+} else {
+  writeFileSync(OUTPUT, header);
+  console.log(`wrote ${OUTPUT} (${entries.length} words)`);
+}
@@ -1,4 +1,6 @@
-from os import path
+from os import environ, path
+from shutil import which
+from subprocess import run
 from sysconfig import get_config_var
 
 from setuptools import Extension, find_packages, setup
@@ -8,6 +10,30 @@ from setuptools.command.egg_info import egg_info
 from wheel.bdist_wheel import bdist_wheel
 
 
+def find_runtime():
+    """Sources or flags for the tree-sitter runtime, which parse_many needs, or None to build without it.
+
+    TREE_SITTER_RUNTIME_DIR may point at the lib/ directory of a tree-sitter checkout, whose amalgamated lib.c is then
+    compiled in; otherwise an installed runtime is looked up through pkg-config.
+    """
+    root = environ.get("TREE_SITTER_RUNTIME_DIR")
+    if root:
+        return {
+            "sources": [path.join(root, "src", "lib.c")],
+            "include_dirs": [path.join(root, "include"), path.join(root, "src")],
+            "define_macros": [("_DEFAULT_SOURCE", None)],
+        }
+    if which("pkg-config"):
+        cflags = run(["pkg-config", "--cflags-only-I", "tree-sitter"], capture_output=True, text=True)
+        libs = run(["pkg-config", "--libs", "tree-sitter"], capture_output=True, text=True)
+        if cflags.returncode == 0 and libs.returncode == 0:
+            return {
+                "include_dirs": [flag[2:] for flag in cflags.stdout.split()],
+                "extra_link_args": libs.stdout.split(),
+            }
+    return None
+
+
 class Build(build):
     def run(self):
         if path.isdir("queries"):
@@ -26,6 +52,15 @@ class BuildExt(build_ext):
             ext.sources.append("src/scanner.c")
         if ext.py_limited_api:
             ext.define_macros.append(("Py_LIMITED_API", "0x030A0000"))
+        runtime = find_runtime()
+        if runtime:
+            ext.sources += runtime.get("sources", []) + ["bindings/c/export.c"]
+            ext.include_dirs += runtime.get("include_dirs", []) + ["bindings/c"]
+            ext.define_macros += runtime.get("define_macros", [])
+            ext.extra_link_args += runtime.get("extra_link_args", [])
+            if self.compiler.compiler_type != "msvc":
+                ext.extra_link_args.append("-pthread")
+            ext.define_macros.append(("TREE_SITTER_AHK_PARSE_MANY", None))
         super().build_extension(ext)
 
 
@@ -41,7 +76,10 @@ class EggInfo(egg_info):
     def find_sources(self):
         super().find_sources()
         self.filelist.recursive_include("queries", "*.scm")
+        self.filelist.include("src/*.h")
         self.filelist.include("src/tree_sitter/*.h")
+        self.filelist.include("bindings/c/export.c")
+        self.filelist.include("bindings/c/tree_sitter/tree-sitter-autohotkey-export.h")
 
 
 setup(
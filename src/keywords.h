@@ -0,0 +1,279 @@
+// Generated by scripts/gen-keywords.mjs from the key table in that script. Do not edit by hand.
+
+#ifndef TREE_SITTER_AUTOHOTKEY_KEYWORDS_H_
+#define TREE_SITTER_AUTOHOTKEY_KEYWORDS_H_
+
+#include <stdint.h>
+
+// Word classes. A word may belong to several.
+#define KW_FLOW (1u << 0)  ///< Control-flow keyword; functions may not be named after one
+#define KW_OPERATOR (1u << 1)  ///< Word operator; functions may not be named after one
+#define KW_CONCAT_BREAK (1u << 2)  ///< Word operator that ends an implicit concatenation (`a and b` is not `a . "and" . b`)
+#define KW_LINE_CONTINUATION (1u << 3)  ///< Word operator that, at the start of a line, continues the previous line
+#define KW_STATIC (1u << 4)  ///< `static`, which may prefix a function or method declaration
+#define KW_EXPORT (1u << 5)  ///< The `export` keyword
+#define KW_EXPORT_FOLLOWER (1u << 6)  ///< Word that, after `export`, always begins an export declaration
+#define KW_ALTTAB (1u << 7)  ///< AltTab command, which is a hotkey action rather than a remap destination
+#define KW_REMAP_KEY (1u << 8)  ///< Named key that can be a remap destination (see https://www.autohotkey.com/docs/v2/KeyList.htm)
+#define KW_CONT_COMMENTS (1u << 9)  ///< Continuation section `Comments` option and its abbreviations
+#define KW_CONT_TRIM (1u << 10)  ///< Continuation section trim option
+
+/// Length of the longest word in the table; anything longer is not a keyword
+#define KW_MAX_LEN 17
+
+/// Size for identifier buffers passed to keyword_classes: the longest word plus a terminator
+#define KW_BUF_SIZE (KW_MAX_LEN + 1)
+
+// Length of the longest word in each class. A probe that only tests one class can stop reading a word one character
+// past this, since a longer word can't be in it; reading less keeps the token's lookahead (what an edit invalidates)
+// short.
+#define KW_FLOW_MAX_LEN 8
+#define KW_OPERATOR_MAX_LEN 8
+#define KW_CONCAT_BREAK_MAX_LEN 3
+#define KW_LINE_CONTINUATION_MAX_LEN 3
+#define KW_STATIC_MAX_LEN 6
+#define KW_EXPORT_MAX_LEN 6
+#define KW_EXPORT_FOLLOWER_MAX_LEN 7
+#define KW_ALTTAB_MAX_LEN 17
+#define KW_REMAP_KEY_MAX_LEN 17
+#define KW_CONT_COMMENTS_MAX_LEN 8
+#define KW_CONT_TRIM_MAX_LEN 6
+
+#define KW_BUCKET_BITS 6
+#define KW_SLOT_BITS 8
+
+typedef struct {
+  const char *word;  ///< lowercase
+  uint8_t len;
+  uint16_t classes;
+} KeywordEntry;
+
+static const KeywordEntry keyword_entries[160] = {
+  {"alt", 3, KW_REMAP_KEY},
+  {"alttab", 6, KW_ALTTAB},
+  {"alttabandmenu", 13, KW_ALTTAB},
+  {"alttabmenu", 10, KW_ALTTAB},
+  {"alttabmenudismiss", 17, KW_ALTTAB},
+  {"and", 3, KW_OPERATOR | KW_CONCAT_BREAK | KW_LINE_CONTINUATION},
+  {"appskey", 7, KW_REMAP_KEY},
+  {"as", 2, KW_FLOW},
+  {"backspace", 9, KW_REMAP_KEY},
+  {"break", 5, KW_FLOW},
+  {"browser_back", 12, KW_REMAP_KEY},
+  {"browser_favorites", 17, KW_REMAP_KEY},
+  {"browser_forward", 15, KW_REMAP_KEY},
+  {"browser_home", 12, KW_REMAP_KEY},
+  {"browser_refresh", 15, KW_REMAP_KEY},
+  {"browser_search", 14, KW_REMAP_KEY},
+  {"browser_stop", 12, KW_REMAP_KEY},
+  {"bs", 2, KW_REMAP_KEY},
+  {"c", 1, KW_CONT_COMMENTS},
+  {"capslock", 8, KW_REMAP_KEY},
+  {"case", 4, KW_FLOW},
+  {"catch", 5, KW_FLOW},
+  {"class", 5, KW_EXPORT_FOLLOWER},
+  {"com", 3, KW_CONT_COMMENTS},
+  {"comment", 7, KW_CONT_COMMENTS},
+  {"comments", 8, KW_CONT_COMMENTS},
+  {"contains", 8, KW_OPERATOR},
+  {"continue", 8, KW_FLOW},
+  {"control", 7, KW_REMAP_KEY},
+  {"ctrl", 4, KW_REMAP_KEY},
+  {"ctrlbreak", 9, KW_REMAP_KEY},
+  {"default", 7, KW_FLOW | KW_EXPORT_FOLLOWER},
+  {"del", 3, KW_REMAP_KEY},
+  {"delete", 6, KW_REMAP_KEY},
+  {"down", 4, KW_REMAP_KEY},
+  {"else", 4, KW_FLOW},
+  {"end", 3, KW_REMAP_KEY},
+  {"enter", 5, KW_REMAP_KEY},
+  {"esc", 3, KW_REMAP_KEY},
+  {"escape", 6, KW_REMAP_KEY},
+  {"export", 6, KW_EXPORT},
+  {"f1", 2, KW_REMAP_KEY},
+  {"f10", 3, KW_REMAP_KEY},
+  {"f11", 3, KW_REMAP_KEY},
+  {"f12", 3, KW_REMAP_KEY},
+  {"f13", 3, KW_REMAP_KEY},
+  {"f14", 3, KW_REMAP_KEY},
+  {"f15", 3, KW_REMAP_KEY},
+  {"f16", 3, KW_REMAP_KEY},
+  {"f17", 3, KW_REMAP_KEY},
+  {"f18", 3, KW_REMAP_KEY},
+  {"f19", 3, KW_REMAP_KEY},
+  {"f2", 2, KW_REMAP_KEY},
+  {"f20", 3, KW_REMAP_KEY},
+  {"f21", 3, KW_REMAP_KEY},
+  {"f22", 3, KW_REMAP_KEY},
+  {"f23", 3, KW_REMAP_KEY},
+  {"f24", 3, KW_REMAP_KEY},
+  {"f3", 2, KW_REMAP_KEY},
+  {"f4", 2, KW_REMAP_KEY},
+  {"f5", 2, KW_REMAP_KEY},
+  {"f6", 2, KW_REMAP_KEY},
+  {"f7", 2, KW_REMAP_KEY},
+  {"f8", 2, KW_REMAP_KEY},
+  {"f9", 2, KW_REMAP_KEY},
+  {"finally", 7, KW_FLOW},
+  {"for", 3, KW_FLOW},
+  {"global", 6, KW_EXPORT_FOLLOWER},
+  {"goto", 4, KW_FLOW},
+  {"help", 4, KW_REMAP_KEY},
+  {"home", 4, KW_REMAP_KEY},
+  {"if", 2, KW_FLOW},
+  {"in", 2, KW_FLOW},
+  {"ins", 3, KW_REMAP_KEY},
+  {"insert", 6, KW_REMAP_KEY},
+  {"is", 2, KW_OPERATOR | KW_CONCAT_BREAK | KW_LINE_CONTINUATION},
+  {"lalt", 4, KW_REMAP_KEY},
+  {"launch_app1", 11, KW_REMAP_KEY},
+  {"launch_app2", 11, KW_REMAP_KEY},
+  {"launch_mail", 11, KW_REMAP_KEY},
+  {"launch_media", 12, KW_REMAP_KEY},
+  {"lbutton", 7, KW_REMAP_KEY},
+  {"lcontrol", 8, KW_REMAP_KEY},
+  {"lctrl", 5, KW_REMAP_KEY},
+  {"left", 4, KW_REMAP_KEY},
+  {"loop", 4, KW_FLOW},
+  {"lshift", 6, KW_REMAP_KEY},
+  {"ltrim", 5, KW_CONT_TRIM},
+  {"ltrim0", 6, KW_CONT_TRIM},
+  {"lwin", 4, KW_REMAP_KEY},
+  {"mbutton", 7, KW_REMAP_KEY},
+  {"media_next", 10, KW_REMAP_KEY},
+  {"media_play_pause", 16, KW_REMAP_KEY},
+  {"media_prev", 10, KW_REMAP_KEY},
+  {"media_stop", 10, KW_REMAP_KEY},
+  {"not", 3, KW_OPERATOR | KW_CONCAT_BREAK},
+  {"numlock", 7, KW_REMAP_KEY},
+  {"numpad0", 7, KW_REMAP_KEY},
+  {"numpad1", 7, KW_REMAP_KEY},
+  {"numpad2", 7, KW_REMAP_KEY},
+  {"numpad3", 7, KW_REMAP_KEY},
+  {"numpad4", 7, KW_REMAP_KEY},
+  {"numpad5", 7, KW_REMAP_KEY},
+  {"numpad6", 7, KW_REMAP_KEY},
+  {"numpad7", 7, KW_REMAP_KEY},
+  {"numpad8", 7, KW_REMAP_KEY},
+  {"numpad9", 7, KW_REMAP_KEY},
+  {"numpadadd", 9, KW_REMAP_KEY},
+  {"numpadclear", 11, KW_REMAP_KEY},
+  {"numpaddel", 9, KW_REMAP_KEY},
+  {"numpaddiv", 9, KW_REMAP_KEY},
+  {"numpaddot", 9, KW_REMAP_KEY},
+  {"numpaddown", 10, KW_REMAP_KEY},
+  {"numpadend", 9, KW_REMAP_KEY},
+  {"numpadenter", 11, KW_REMAP_KEY},
+  {"numpadhome", 10, KW_REMAP_KEY},
+  {"numpadins", 9, KW_REMAP_KEY},
+  {"numpadleft", 10, KW_REMAP_KEY},
+  {"numpadmult", 10, KW_REMAP_KEY},
+  {"numpadpgdn", 10, KW_REMAP_KEY},
+  {"numpadpgup", 10, KW_REMAP_KEY},
+  {"numpadright", 11, KW_REMAP_KEY},
+  {"numpadsub", 9, KW_REMAP_KEY},
+  {"numpadup", 8, KW_REMAP_KEY},
+  {"or", 2, KW_OPERATOR | KW_CONCAT_BREAK | KW_LINE_CONTINUATION},
+  {"pause", 5, KW_REMAP_KEY},
+  {"pgdn", 4, KW_REMAP_KEY},
+  {"pgup", 4, KW_REMAP_KEY},
+  {"printscreen", 11, KW_REMAP_KEY},
+  {"ralt", 4, KW_REMAP_KEY},
+  {"rbutton", 7, KW_REMAP_KEY},
+  {"rcontrol", 8, KW_REMAP_KEY},
+  {"rctrl", 5, KW_REMAP_KEY},
+  {"return", 6, KW_FLOW},
+  {"right", 5, KW_REMAP_KEY},
+  {"rshift", 6, KW_REMAP_KEY},
+  {"rtrim0", 6, KW_CONT_TRIM},
+  {"rwin", 4, KW_REMAP_KEY},
+  {"scrolllock", 10, KW_REMAP_KEY},
+  {"shift", 5, KW_REMAP_KEY},
+  {"shiftalttab", 11, KW_ALTTAB},
+  {"sleep", 5, KW_REMAP_KEY},
+  {"space", 5, KW_REMAP_KEY},
+  {"static", 6, KW_STATIC},
+  {"struct", 6, KW_EXPORT_FOLLOWER},
+  {"switch", 6, KW_FLOW},
+  {"tab", 3, KW_REMAP_KEY},
+  {"throw", 5, KW_FLOW},
+  {"try", 3, KW_FLOW},
+  {"up", 2, KW_REMAP_KEY},
+  {"volume_down", 11, KW_REMAP_KEY},
+  {"volume_mute", 11, KW_REMAP_KEY},
+  {"volume_up", 9, KW_REMAP_KEY},
+  {"wheeldown", 9, KW_REMAP_KEY},
+  {"wheelleft", 9, KW_REMAP_KEY},
+  {"wheelright", 10, KW_REMAP_KEY},
+  {"wheelup", 7, KW_REMAP_KEY},
+  {"while", 5, KW_FLOW},
+  {"xbutton1", 8, KW_REMAP_KEY},
+  {"xbutton2", 8, KW_REMAP_KEY},
+};
+
+/// Per-bucket hash displacement
+static const uint16_t keyword_displacements[1 << KW_BUCKET_BITS] = {
+  1, 0, 0, 2, 7, 2, 2, 0, 0, 0, 6, 0, 0, 1, 3, 3,
+  7, 2, 0, 11, 3, 9, 2, 0, 9, 19, 9, 0, 1, 0, 3, 1,
+  1, 7, 0, 1, 0, 1, 2, 0, 4, 0, 1, 2, 2, 1, 0, 4,
+  0, 2, 0, 1, 1, 0, 1, 6, 1, 1, 1, 0, 0, 1, 1, 2,
+};
+
+/// Hash slot -> 1 + index into keyword_entries, 0 for an empty slot
+static const uint8_t keyword_slots[1 << KW_SLOT_BITS] = {
+  0, 0, 42, 47, 0, 45, 29, 88, 0, 0, 20, 0, 61, 67, 59, 0,
+  0, 23, 141, 0, 76, 0, 0, 63, 0, 0, 68, 0, 159, 145, 155, 0,
+  22, 15, 28, 0, 0, 105, 14, 110, 148, 0, 57, 0, 34, 66, 0, 25,
+  100, 99, 102, 0, 0, 55, 0, 74, 30, 64, 0, 0, 82, 0, 0, 0,
+  46, 0, 6, 149, 0, 90, 81, 156, 139, 53, 111, 0, 48, 0, 106, 85,
+  0, 0, 0, 62, 0, 60, 0, 0, 0, 0, 160, 43, 112, 24, 136, 0,
+  0, 86, 0, 84, 0, 127, 0, 54, 0, 151, 92, 1, 142, 52, 126, 50,
+  40, 11, 115, 17, 39, 0, 132, 113, 94, 7, 0, 0, 125, 0, 122, 118,
+  31, 0, 0, 0, 21, 137, 13, 27, 144, 0, 146, 0, 0, 33, 73, 19,
+  83, 5, 91, 0, 97, 77, 0, 9, 0, 16, 119, 32, 130, 140, 0, 38,
+  10, 0, 108, 89, 0, 70, 0, 143, 8, 150, 51, 120, 87, 0, 147, 71,
+  26, 157, 0, 0, 0, 79, 128, 3, 103, 114, 134, 0, 80, 0, 133, 121,
+  78, 0, 0, 138, 0, 131, 135, 0, 0, 0, 95, 0, 0, 35, 0, 153,
+  96, 0, 58, 0, 107, 0, 154, 116, 75, 0, 0, 158, 0, 0, 0, 0,
+  0, 44, 37, 12, 69, 0, 0, 117, 98, 49, 104, 0, 56, 124, 152, 123,
+  65, 0, 101, 0, 41, 72, 129, 18, 0, 93, 4, 0, 2, 36, 0, 109,
+};
+
+/// @brief Classifies a word against the keyword table. Case-insensitive, ASCII only.
+/// @param word the word's characters; need not be terminated
+/// @param len length of the word. Words longer than KW_MAX_LEN never match, so callers may pass the full length
+///        of an identifier whose buffer only kept its first KW_MAX_LEN characters
+/// @return bitmask of KW_* classes the word belongs to, 0 if it is not in the table
+static inline uint16_t keyword_classes(const char *word, int len) {
+  if (len <= 0 || len > KW_MAX_LEN) {
+    return 0;
+  }
+
+  uint32_t h = 0x811c9dc5u;
+  for (int i = 0; i < len; i++) {
+    char c = word[i];
+    if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+    h = (h ^ (uint8_t)c) * 0x01000193u;
+  }
+
+  uint32_t disp = keyword_displacements[h >> (32 - KW_BUCKET_BITS)];
+  uint32_t slot = keyword_slots[((h ^ disp) * 0x9e3779b1u) >> (32 - KW_SLOT_BITS)];
+  if (slot == 0) {
+    return 0;
+  }
+
+  const KeywordEntry *entry = &keyword_entries[slot - 1];
+  if (entry->len != len) {
+    return 0;
+  }
+  for (int i = 0; i < len; i++) {
+    char c = word[i];
+    if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+    if (c != entry->word[i]) {
+      return 0;
+    }
+  }
+  return entry->classes;
+}
+
+#endif // TREE_SITTER_AUTOHOTKEY_KEYWORDS_H_
@@ -1,5 +1,5 @@
 #include "tree_sitter/parser.h"
-#include <ctype.h>
+#include "keywords.h"
 #include <string.h>
 
 // This external scanner currently handles lookaheads for:
@@ -20,30 +20,6 @@
 // every use here is on ASCII bytes (key names, identifiers), so roll our own.
 #define ascii_tolower(c) (((c) >= 'A' && (c) <= 'Z') ? ((c) + 32) : (c))
 
-#define STRCASEEQ_ANY_1(s, a)          strcaseeq(s, a)
-#define STRCASEEQ_ANY_2(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_1(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_3(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_2(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_4(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_3(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_5(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_4(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_6(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_5(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_7(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_6(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_8(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_7(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_9(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_8(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_10(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_9(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_11(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_10(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_12(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_11(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_13(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_12(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_14(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_13(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_15(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_14(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_16(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_15(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_17(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_16(s, __VA_ARGS__)
-#define STRCASEEQ_ANY_18(s, a, ...)     strcaseeq(s, a) || STRCASEEQ_ANY_17(s, __VA_ARGS__)
-
-#define _STRCASEEQ_ANY_N(_1,_2,_3,_4,_5,_6,_7,_8,_9,_10,_11,_12,_13,_14,_15,_16,_17,_18,N,...) STRCASEEQ_ANY_##N
-/// Performs a case-insensitive comparison of `s` against up to 12 character arrays, returns true if any match
-#define strcaseeq_any(s, ...) \
-    (_STRCASEEQ_ANY_N(__VA_ARGS__, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1)(s, __VA_ARGS__))
-
 /// Skips all whitespace, including newlines
 #define skip_whitespace(lexer)  while (is_whitespace(lexer->lookahead)) { \
                                   lexer->advance(lexer, true);            \
@@ -54,31 +30,26 @@
                                     lexer->advance(lexer, false);                                 \
                                   }
 
-#define skip_eol(lexer) while(is_eol(lexer->lookahead)) { lexer->advance(lexer, true); }
+// is_eol is also true at EOF, where advancing does nothing, so stop there explicitly
+#define skip_eol(lexer) while(is_eol(lexer->lookahead) && !is_eof(lexer)) { lexer->advance(lexer, true); }
 
 #define is_eof(lexer) (lexer->eof(lexer))
 
 /// Check to see if a character is a hotkey modifier symbol
 #define is_hotkey_modifier(c) ((c) && strchr("^!#+<>~$", c))
 
-/// Check to see if an identifier is an AltTab command
-#define is_alttab_command(ident) \
-  (strcaseeq_any(ident, "AltTab", "ShiftAltTab", "AltTabMenu", "AltTabAndMenu", "AltTabMenuDismiss"))
+// Word lookups go through the generated classifier in keywords.h; to add a keyword or key name, edit the table in
+// scripts/gen-keywords.mjs and regenerate. `ident` and `len` come from skip_identifier.
 
-/// Check to see if ident is an operator keyword like "and" or "is". Get `ident` from skip_identifier
-#define is_operator_keyword(ident) \
-  (strcaseeq_any(ident, "and", "not", "is", "or", "contains"))
+/// Check to see if an identifier is an AltTab command
+#define is_alttab_command(ident, len) (keyword_classes(ident, len) & KW_ALTTAB)
 
 /// Check to see if a character could start an operator keyword
 #define starts_operator_keyword(c) ((c) && strchr("aAnNiIoOcC", c))
 
-/// Check to see if ident is a control-flow keyword like "if"
-#define is_flow_keyword(ident) \
-  (strcaseeq_any(ident, "if", "else", "while", "for", "loop", "throw", "try", "catch", \
-    "finally", "break", "continue", "as", "in", "switch", "case", "default", "goto", "return"))
-
-/// Check to see if ident is a reserved word in general
-#define is_keyword(ident) (is_operator_keyword(ident) || is_flow_keyword(ident))
+/// Check to see if ident is a reserved word in general (a control-flow keyword like "if" or an operator keyword
+/// like "and")
+#define is_keyword(ident, len) (keyword_classes(ident, len) & (KW_FLOW | KW_OPERATOR))
 
 enum TokenType {
   OPTIONAL_MARKER,
@@ -94,19 +65,30 @@ enum TokenType {
   HOTKEY_DOUBLE_COLON,
   REMAP_DOUBLE_COLON,
   EXPORT_DEF_MARKER,
-  OTB_BRACE
+  OTB_BRACE,
+  TOKEN_TYPE_COUNT
 };
 
+// With TREE_SITTER_AHK_STATS defined, every probe for an external token is counted (see the end of this file and
+// bindings/c/tree_sitter/tree-sitter-autohotkey.h). STATS_PROBE marks the start of a probe; it compiles to nothing
+// otherwise.
+#ifdef TREE_SITTER_AHK_STATS
+static void stats_begin_probe(enum TokenType token);
+#define STATS_PROBE(token) stats_begin_probe(token)
+#else
+#define STATS_PROBE(token) ((void)0)
+#endif
+
 void *tree_sitter_autohotkey_external_scanner_create() { return NULL; }
 void tree_sitter_autohotkey_external_scanner_destroy(void *payload) {}
-void tree_sitter_autohotkey_external_scanner_reset(void *payload) {}
 unsigned tree_sitter_autohotkey_external_scanner_serialize(void *payload, char *buffer) { return 0; }
 void tree_sitter_autohotkey_external_scanner_deserialize(void *payload, const char *buffer, unsigned length) {}
 
 /// @brief Skips an identifier, returning its length and putting up to the first `buf_size` characters of it into
 ///        `buf` for later comparison.
 /// @param lexer the lexer
-/// @param buf buffer in which to store characters. Can be null (but `buf_size` must be 0)
+/// @param buf buffer in which to store characters. Can be null (but `buf_size` must be 0). Always terminated, even
+///        when the identifier is truncated
 /// @param buf_size size of `buf` in characters
 /// @return the total number of characters skipped
 static int skip_identifier(TSLexer *lexer, char *buf, int buf_size) {
@@ -119,9 +101,31 @@ static int skip_identifier(TSLexer *lexer, char *buf, int buf_size) {
     lexer->advance(lexer, false);
   }
 
-  if (buf && len < buf_size)
-    buf[len] = '\0';
+  if (buf && buf_size > 0)
+    buf[len < buf_size ? len : buf_size - 1] = '\0';
+
+  return len;
+}
+
+/// @brief skip_identifier for a word that only matters if it's in one keyword class: reads at most `max_len` + 1
+///        characters, where `max_len` is the class's KW_*_MAX_LEN, since a word that long can't be in the class
+///        anyway. Leaving the rest of a longer identifier unread keeps it out of the token's lookahead, which is what
+///        tree-sitter invalidates around an edit.
+/// @param lexer the lexer
+/// @param buf buffer of KW_BUF_SIZE characters for the word
+/// @param max_len longest word in the class; at most KW_MAX_LEN
+/// @return the number of characters skipped, `max_len` + 1 for any longer word
+static int skip_keyword(TSLexer *lexer, char *buf, int max_len) {
+  int len = 0;
+  while (len <= max_len && is_identifier_char(lexer->lookahead)) {
+    if (len < KW_BUF_SIZE - 1) {
+      buf[len] = (char)(lexer->lookahead);
+    }
+    len++;
+    lexer->advance(lexer, false);
+  }
 
+  buf[len < KW_BUF_SIZE ? len : KW_BUF_SIZE - 1] = '\0';
   return len;
 }
 
@@ -150,16 +154,48 @@ static inline bool strcaseeq(const char *a, const char *b) {
   return *a == *b;
 }
 
-/// @brief Forward scan to see if the next statement is a function or method declaration. This is required to
-///        differentiate `function_call block` from `function_declaration`, since e.g. `MyFunnc(arg)` could be the 
-///        start of either. Methods and functions are structurally similar but have slightly different naming
-///        constraints
-///        Call `lexer->mark_end` before this
+/// Upper bounds on how far a declaration probe may read past the opening `(` of a candidate function head before
+/// giving up. Without them an unbalanced `(` (e.g. a half-typed call in an editor) makes every statement-start probe
+/// scan to the end of the file, which is quadratic over the whole parse. Real heads are far shorter than either cap;
+/// override at build time (e.g. `-DDECL_LOOKAHEAD_MAX_CHARS=8192`) if a codebase has unusually long parameter lists.
+#ifndef DECL_LOOKAHEAD_MAX_CHARS
+#define DECL_LOOKAHEAD_MAX_CHARS 4096
+#endif
+
+#ifndef DECL_LOOKAHEAD_MAX_LINES
+#define DECL_LOOKAHEAD_MAX_LINES 64
+#endif
+
+/// Remaining lookahead allowance for a single declaration probe
+typedef struct {
+  unsigned chars;
+  unsigned lines;
+} LookaheadBudget;
+
+/// @brief Advances the lexer by one character, charging it against `budget`
 /// @param lexer tree-sitter lexer
-/// @param method true to scan for a method instead of a function
-/// @return true if the next statement is a function declaration, false otherwise
+/// @param budget the probe's remaining allowance
+/// @param skip passed through to `lexer->advance`
+/// @return false if the budget is exhausted, in which case the probe should give up
+static inline bool budget_advance(TSLexer *lexer, LookaheadBudget *budget, bool skip) {
+  if (budget->chars == 0) {
+    return false;
+  }
+  if (lexer->lookahead == '\n') {
+    if (budget->lines == 0) {
+      return false;
+    }
+    budget->lines--;
+  }
+  budget->chars--;
+  lexer->advance(lexer, skip);
+  return true;
+}
+
 /// @brief Given the lexer is positioned immediately after a (potential) function name, check whether a
-///        function head and body follow: `( ... )` then either `{` or `=>`. Advances the lexer.
+///        function head and body follow: `( ... )` then either `{` or `=>`. Advances the lexer. The scan is bounded
+///        by DECL_LOOKAHEAD_MAX_CHARS / DECL_LOOKAHEAD_MAX_LINES; a head that doesn't resolve within them is
+///        treated as not being a declaration.
 /// @param lexer tree-sitter lexer
 /// @param block_only if true, only a block body `{` counts (a fat-arrow `=>` body does not)
 /// @return true if a function head + body follows
@@ -170,17 +206,21 @@ static bool is_function_body_follows(TSLexer *lexer, bool block_only) {
   }
   lexer->advance(lexer, false);
 
+  LookaheadBudget budget = { DECL_LOOKAHEAD_MAX_CHARS, DECL_LOOKAHEAD_MAX_LINES };
+
   // Match parens...
   int depth = 1;
   while (depth > 0 && lexer->lookahead != 0) {
     if (lexer->lookahead == '(') depth++;
     else if (lexer->lookahead == ')') depth--;
-    lexer->advance(lexer, false);
+    if (!budget_advance(lexer, &budget, false)) return false;
   }
   if (depth != 0) return false;
 
   // Skip all whitespace (including newlines), check for '{' or '=>'
-  skip_whitespace(lexer);
+  while (is_whitespace(lexer->lookahead)) {
+    if (!budget_advance(lexer, &budget, true)) return false;
+  }
 
   // Function body can start with either '{' or '=>'
   if (lexer->lookahead == '{') {
@@ -194,6 +234,14 @@ static bool is_function_body_follows(TSLexer *lexer, bool block_only) {
   return false;
 }
 
+/// @brief Forward scan to see if the next statement is a function or method declaration. This is required to
+///        differentiate `function_call block` from `function_declaration`, since e.g. `MyFunnc(arg)` could be the 
+///        start of either. Methods and functions are structurally similar but have slightly different naming
+///        constraints
+///        Call `lexer->mark_end` before this
+/// @param lexer tree-sitter lexer
+/// @param method true to scan for a method instead of a function
+/// @return true if the next statement is a function declaration, false otherwise
 static bool is_function_declaration(TSLexer *lexer, bool method) {
   // Skip any leading whitespace (including newlines)
   skip_whitespace(lexer);
@@ -202,11 +250,11 @@ static bool is_function_declaration(TSLexer *lexer, bool method) {
     return false;
   }
 
-  char ident[16];
-  skip_identifier(lexer, ident, sizeof(ident));
+  char ident[KW_BUF_SIZE];
+  int len = skip_identifier(lexer, ident, sizeof(ident));
 
   // Methods can be static, as can functions that aren't in the auto-execute section
-  if (strcaseeq(ident, "static")) {
+  if (keyword_classes(ident, len) & KW_STATIC) {
     if (!skip_horizontal_ws(lexer)) {
       return false;  // need space after static
     }
@@ -220,7 +268,7 @@ static bool is_function_declaration(TSLexer *lexer, bool method) {
       return false;
     }
   }
-  else if(!method && is_keyword(ident)) {
+  else if(!method && is_keyword(ident, len)) {
     // Functions cannot shadow keywords (methods can)
     return false;
   }
@@ -246,11 +294,11 @@ static bool export_decl_follows(TSLexer *lexer) {
     return false;  // e.g. `export {`, `export "str"` — not a declaration
   }
 
-  char w[16];
-  skip_identifier(lexer, w, sizeof(w));
+  char w[KW_BUF_SIZE];
+  int len = skip_identifier(lexer, w, sizeof(w));
 
   // Keyword followers unambiguously begin a declaration.
-  if (strcaseeq_any(w, "default", "global", "class", "struct")) {
+  if (keyword_classes(w, len) & KW_EXPORT_FOLLOWER) {
     return true;
   }
 
@@ -376,10 +424,10 @@ static bool is_implicit_concatenation(TSLexer *lexer) {
 
     // Check to see if this is an operator keyword
     if(starts_operator_keyword(lexer->lookahead)) {
-      char ident[4];
-      int len = skip_identifier(lexer, ident, sizeof(ident));
+      char ident[KW_BUF_SIZE];
+      int len = skip_keyword(lexer, ident, KW_CONCAT_BREAK_MAX_LEN);
 
-      if(is_operator_keyword(ident)) {
+      if(keyword_classes(ident, len) & KW_CONCAT_BREAK) {
         return false;
       }
     }
@@ -407,10 +455,9 @@ typedef enum {
 ///         consumed but is not a continuation; CONT_NONE otherwise (no '(' consumed).
 static ContinuationResult is_continuation_start(TSLexer* lexer) {
   skip_horizontal_ws(lexer);
-  if(is_eof(lexer))
-    return CONT_NONE;
-
-  if(!is_eol(lexer->lookahead)) {
+  // This probe runs at the end of nearly every expression, so test the lookahead before paying for lexer->eof,
+  // which can only be true when the lookahead is '\0'.
+  if(!is_eol(lexer->lookahead) || (lexer->lookahead == '\0' && is_eof(lexer))) {
     // "(" must start on new line
     return CONT_NONE;
   }
@@ -427,7 +474,7 @@ static ContinuationResult is_continuation_start(TSLexer* lexer) {
   // scan ahead to ensure that we only find continuation options up until the newline. Anything else and this can't
   // be a continuation section start
 
-  char opt[10] = {0};
+  char opt[KW_BUF_SIZE] = {0};
 
   while(!is_eol(lexer->lookahead)) {
     if(is_eof(lexer)) {
@@ -454,8 +501,7 @@ static ContinuationResult is_continuation_start(TSLexer* lexer) {
       case 'c':
       case 'C':
         //Comment
-        skip_identifier(lexer, opt, sizeof(opt));
-        if(!strcaseeq_any(opt, "comments", "comment", "com", "c")) {
+        if(!(keyword_classes(opt, skip_keyword(lexer, opt, KW_CONT_COMMENTS_MAX_LEN)) & KW_CONT_COMMENTS)) {
           return CONT_PAREN_EXPR;
         }
 
@@ -467,8 +513,7 @@ static ContinuationResult is_continuation_start(TSLexer* lexer) {
       case 'r':
       case 'R':
         // ltrim or rtrim option
-        skip_identifier(lexer, opt, sizeof(opt));
-        if(!strcaseeq_any(opt, "ltrim", "ltrim0", "rtrim0")) {
+        if(!(keyword_classes(opt, skip_keyword(lexer, opt, KW_CONT_TRIM_MAX_LEN)) & KW_CONT_TRIM)) {
           return CONT_PAREN_EXPR;
         }
 
@@ -497,7 +542,7 @@ static ContinuationResult is_continuation_start(TSLexer* lexer) {
 /// @return true if a newline was found, false if not
 static bool scan_continuation_newline(TSLexer *lexer) {
   skip_horizontal_ws(lexer);
-  if(is_eof(lexer))
+  if(lexer->lookahead == '\0' && is_eof(lexer))
     return false;
 
   if(is_eol(lexer->lookahead)) {
@@ -555,9 +600,9 @@ static bool starts_continuation_line(TSLexer *lexer) {
     default:
       if(starts_operator_keyword(lexer->lookahead)) {
         // Word operators: a line may start with "and", "or" or "is" to continue the previous line.
-        char word[16] = {0};
-        skip_identifier(lexer, word, sizeof(word));
-        return strcaseeq_any(word, "and", "or", "is");
+        char word[KW_BUF_SIZE];
+        int len = skip_keyword(lexer, word, KW_LINE_CONTINUATION_MAX_LEN);
+        return keyword_classes(word, len) & KW_LINE_CONTINUATION;
       }
       return false;
   }
@@ -565,7 +610,13 @@ static bool starts_continuation_line(TSLexer *lexer) {
 
 /// @brief Scans for a block comment. In AHK v2, block comments open with /* and close with */,
 ///        but the closing */ must be the LAST non-whitespace content on its line. A */ followed by
-///        more content on the same line does NOT close the comment.
+///        more content on the same line does NOT close the comment, unless the */ begins the line
+///        (directly after a single '\n', with no indentation).
+///
+///        Comment bodies are often long (license headers, commented-out code), so the body loop only
+///        looks for the two characters that matter, '*' and line ends, and touches every other
+///        character exactly once. EOF is only checked when the lookahead is '\0', the one character
+///        the lexer reports there, instead of through lexer->eof for every character.
 /// @param lexer the lexer (should be positioned at the start of the potential comment)
 /// @return true if a block comment was found and consumed
 static bool scan_block_comment(TSLexer *lexer) {
@@ -575,57 +626,58 @@ static bool scan_block_comment(TSLexer *lexer) {
   if (lexer->lookahead != '*') return false;
   lexer->advance(lexer, false);
 
-  // Scan for closing */ that is either the first or last non-whitespace on its line
-  while (!lexer->eof(lexer)) {
-    bool is_line_start = is_eol(lexer->lookahead);
-    if (is_line_start)
-      lexer->advance(lexer, false);
-    
-    if (lexer->lookahead == '*') {
+  for (;;) {
+    while (lexer->lookahead != '*' && !is_eol(lexer->lookahead)) {
       lexer->advance(lexer, false);
-      if (lexer->eof(lexer)) return false;
+    }
 
-      if (lexer->lookahead == '/') {
+    bool is_line_start = false;
+    if (lexer->lookahead != '*') {
+      if (lexer->lookahead == '\0' && is_eof(lexer)) return false;
+      lexer->advance(lexer, false);
+      if (lexer->lookahead != '*') {
+        // Only a '*' right after the line end counts as starting the line; whatever else is there is part of the
+        // body, even another line end (so a */ after a blank line or a "\r\n" has to end its line to close).
         lexer->advance(lexer, false);
+        continue;
+      }
+      is_line_start = true;
+    }
 
-        // Check if this */ is the last non-whitespace before EOL/EOF
-        while (lexer->lookahead == ' ' || lexer->lookahead == '\t') {
-          lexer->advance(lexer, false);
-        }
-
-        if (is_line_start || is_eol(lexer->lookahead) || lexer->eof(lexer)) {
-          // Consume the newline, if any
-          if (lexer->lookahead == '\r') lexer->advance(lexer, false);
-          if (lexer->lookahead == '\n') lexer->advance(lexer, false);
+    lexer->advance(lexer, false);
+    if (lexer->lookahead == '\0' && is_eof(lexer)) return false;
+    if (lexer->lookahead != '/') continue;  // * not followed by /; it may be followed by another *
+    lexer->advance(lexer, false);
 
-          // Consume leading whitespace on the next line so that indentation after the
-          // comment isn't misinterpreted as implicit concatenation whitespace.
-          // We must use advance(false) here, NOT advance(true), because advance(true)
-          // moves the token START position forward, which would collapse the span.
-          while ((lexer->lookahead == ' ' || lexer->lookahead == '\t') && !lexer->eof(lexer)) {
-            lexer->advance(lexer, false);
-          }
+    // Check if this */ is the last non-whitespace before EOL/EOF
+    while (lexer->lookahead == ' ' || lexer->lookahead == '\t') {
+      lexer->advance(lexer, false);
+    }
 
-          lexer->mark_end(lexer);
-          return true;
-        }
+    if (is_line_start || is_eol(lexer->lookahead)) {
+      // Consume the newline, if any
+      if (lexer->lookahead == '\r') lexer->advance(lexer, false);
+      if (lexer->lookahead == '\n') lexer->advance(lexer, false);
 
-        // */ was not at start or end of line — continue scanning the comment body
-        continue;
+      // Consume leading whitespace on the next line so that indentation after the
+      // comment isn't misinterpreted as implicit concatenation whitespace.
+      // We must use advance(false) here, NOT advance(true), because advance(true)
+      // moves the token START position forward, which would collapse the span.
+      while (lexer->lookahead == ' ' || lexer->lookahead == '\t') {
+        lexer->advance(lexer, false);
       }
-      // * not followed by /, continue
-      continue;
+
+      lexer->mark_end(lexer);
+      return true;
     }
-    lexer->advance(lexer, false);
-  }
 
-  // EOF without a valid closing */
-  return false;
+    // */ was not at start or end of line — continue scanning the comment body
+  }
 }
 
 /// @brief Checks if an identifier is a valid AHK key name for remap destinations.
 ///        See: https://www.autohotkey.com/docs/v2/KeyList.htm
-/// @param key null-terminated key name buffer
+/// @param key key name buffer from skip_identifier
 /// @param len actual length of the identifier (may exceed buffer if truncated)
 /// @return true if the identifier is a recognized key name
 static bool is_remap_key(const char *key, int len) {
@@ -634,125 +686,202 @@ static bool is_remap_key(const char *key, int len) {
   // Single alphanumeric character is always a valid key (letter or digit key)
   if (len == 1) return is_alnum(key[0]);
 
-  switch (ascii_tolower(key[0])) {
-    case 'a':
-      return strcaseeq_any(key, "Alt", "AppsKey"); 
+  // Named keys, including F1-F24 and the Numpad keys
+  if (keyword_classes(key, len) & KW_REMAP_KEY) {
+    return true;
+  }
 
-    case 'b':
-      return strcaseeq_any(key, "Backspace", "BS", "Browser_Back", "Browser_Forward", "Browser_Refresh", 
-        "Browser_Stop", "Browser_Search", "Browser_Favorites", "Browser_Home");
+  // Sc scan codes: Sc followed by 3 hex digits
+  if (len == 5 && ascii_tolower(key[0]) == 's' && ascii_tolower(key[1]) == 'c') {
+    return is_xdigit(key[2]) && is_xdigit(key[3]) && is_xdigit(key[4]);
+  }
 
-    case 'c':
-      return strcaseeq_any(key, "CapsLock", "Control", "Ctrl", "CtrlBreak"); 
+  // Vk virtual key codes: Vk followed by 2 hex digits
+  if (len == 4 && ascii_tolower(key[0]) == 'v' && ascii_tolower(key[1]) == 'k') {
+    return is_xdigit(key[2]) && is_xdigit(key[3]);
+  }
 
-    case 'd':
-      return strcaseeq_any(key, "Delete", "Del", "Down"); 
+  return false;
+}
 
-    case 'e':
-      return strcaseeq_any(key, "End", "Enter", "Escape", "Esc"); 
+/// @brief Checks for an array expansion marker vs a multiplication operator. Both are '*' immediately after an
+///        expression; we disambiguate by looking ahead: array expansion is always the last thing in an arg list, so
+///        '*' must be followed by ')' or ']'. No other external token starts with '*'.
+/// @param lexer the lexer, positioned at the '*'
+/// @return true if an array expansion marker was lexed
+static bool scan_array_expansion(TSLexer *lexer) {
+  STATS_PROBE(ARRAY_EXPANSION_MARKER);
+  lexer->advance(lexer, false);
+  lexer->mark_end(lexer);
 
-    case 'f':
-      // F1-F24
-      if (len >= 2 && len <= 3 && is_digit(key[1])) {
-        int num = key[1] - '0';
-        if (len == 3) {
-          if (!is_digit(key[2])) return false;
-          num = num * 10 + (key[2] - '0');
-        }
-        return num >= 1 && num <= 24;
-      }
-      return false;
+  // Skip whitespace to see what follows
+  skip_whitespace(lexer);
 
-    case 'h':
-      return strcaseeq_any(key, "Help", "Home");
+  if (lexer->lookahead == ')' || lexer->lookahead == ']') {
+    lexer->result_symbol = ARRAY_EXPANSION_MARKER;
+    return true;
+  }
 
-    case 'i':
-      return strcaseeq_any(key, "Insert", "Ins"); 
+  // Not array expansion — it's a multiplication operator.
+  return false;
+}
 
-    case 'l':
-      return strcaseeq_any(key, "LAlt", "Launch_Mail", "Launch_Media", "Launch_App1", "Launch_App2",
-        "LButton", "LControl", "LCtrl", "Left", "LShift", "LWin"); 
+/// @brief Scans a "::" and decides between a hotkey and a remap from what follows it.
+///        A remap is: trigger :: [modifiers] key EOL (single key on same line)
+///        A hotkey is: trigger :: body (anything else)
+/// @param lexer the lexer, positioned at the first ':'
+/// @param valid_symbols valid symbols; at least one of HOTKEY_DOUBLE_COLON and REMAP_DOUBLE_COLON is valid
+/// @return true if a token was lexed. A single ':' is never our token
+static bool scan_double_colon(TSLexer *lexer, const bool *valid_symbols) {
+  // One probe serves both tokens. It's counted against the remap when that is valid, since the lookahead past the
+  // colons exists to detect remaps.
+  STATS_PROBE(valid_symbols[REMAP_DOUBLE_COLON] ? REMAP_DOUBLE_COLON : HOTKEY_DOUBLE_COLON);
+  lexer->advance(lexer, false);
+  if (lexer->lookahead != ':') {
+    // Single ":" — not our token, let the regular lexer handle it
+    return false;
+  }
+  lexer->advance(lexer, false);
+  lexer->mark_end(lexer);  // token is just "::"
 
-    case 'm':
-      return strcaseeq_any(key, "MButton", "Media_Next", "Media_Prev", "Media_Stop", "Media_Play_Pause"); 
+  // Everything past the colons only tells a remap from a hotkey. When a remap can't follow, don't read it: it would
+  // only stretch this token's lookahead over the hotkey's body.
+  if (!valid_symbols[REMAP_DOUBLE_COLON]) {
+    goto hotkey_colon;
+  }
 
-    case 'n':
-      if (strcaseeq(key, "NumLock")) return true;
-      // Numpad keys: Numpad0-9 and named variants
-      if (len >= 7 && ascii_tolower(key[1]) == 'u' && ascii_tolower(key[2]) == 'm' &&
-          ascii_tolower(key[3]) == 'p' && ascii_tolower(key[4]) == 'a' && ascii_tolower(key[5]) == 'd') {
-        const char *suffix = key + 6;
+  // Look ahead to determine if this is a remap or hotkey
+  // Skip optional hotkey modifier symbols
+  while (is_hotkey_modifier(lexer->lookahead)) {
+    lexer->advance(lexer, false);
+  }
 
-        if (len == 7 && is_digit(suffix[0])) return true;  // Numpad0-Numpad9
+  // Check what follows to determine if this is a remap destination
+  bool found_key = false;
 
-        return strcaseeq_any(suffix, "Ins", "End", "Down", "PgDn", "Left", "Clear", "Right", "Home",
-          "Up", "PgUp", "Del", "Dot", "Div", "Mult", "Add", "Sub", "Enter");
-      }
-      return false;
+  if (is_identifier_char(lexer->lookahead)) {
+    // Word-like key: read identifier and validate against key list. Key names (Sc### and Vk## codes included) and
+    // AltTab commands are all at most KW_REMAP_KEY_MAX_LEN long, so nothing past that is read.
+    char key_buf[KW_BUF_SIZE];
+    int key_len = skip_keyword(lexer, key_buf, KW_REMAP_KEY_MAX_LEN);
 
-    case 'p':
-      return strcaseeq_any(key, "Pause", "PgDn", "PgUp", "PrintScreen"); 
+    // AltTab commands are hotkey bodies, not remap destinations
+    if (is_alttab_command(key_buf, key_len)) {
+      goto hotkey_colon;
+    }
 
-    case 'r':
-      return strcaseeq_any(key, "RAlt", "RButton", "RControl", "RCtrl", "Right", "RShift", "RWin");
+    found_key = is_remap_key(key_buf, key_len);
+  } else if (lexer->lookahead == '`') {
+    // Backtick escape sequence (e.g., `{ for literal open brace)
+    lexer->advance(lexer, false);
+    if (!is_eol(lexer->lookahead) && !is_eof(lexer)) {
+      lexer->advance(lexer, false);  // consume the escaped char
+      found_key = true;
+    }
+  } else if (!is_eol(lexer->lookahead) && !is_eof(lexer) &&
+             lexer->lookahead != ' ' && lexer->lookahead != '\t' &&
+             lexer->lookahead != '{') {
+    // Single non-identifier char key (e.g., }, (, -, .)
+    // Excludes { which starts a hotkey body block
+    lexer->advance(lexer, false);
+    found_key = true;
+  }
 
-    case 's':
-      if (strcaseeq_any(key, "ScrollLock", "Shift", "Sleep", "Space")) {
-        return true;
-      }
-      // Sc scan codes: Sc followed by 3 hex digits
-      if (len == 5 && ascii_tolower(key[1]) == 'c') {
-        return is_xdigit(key[2]) && is_xdigit(key[3]) && is_xdigit(key[4]);
-      }
-      return false;
+  if (found_key) {
+    // After the key, must be EOL (nothing else on the line)
+    skip_horizontal_ws(lexer);
+    if (is_eol(lexer->lookahead) || is_eof(lexer) || lexer->lookahead == ';') {
+      lexer->result_symbol = REMAP_DOUBLE_COLON;
+      return true;
+    }
+  }
+
+  hotkey_colon:
+  if (valid_symbols[HOTKEY_DOUBLE_COLON]) {
+    lexer->result_symbol = HOTKEY_DOUBLE_COLON;
+    return true;
+  }
+  return false;
+}
 
-    case 't':
-      return strcaseeq_any(key, "Tab");
+/// @brief Scans a statement-level declaration head marker. Export declaration, function declaration and method
+///        declaration all begin with a leading identifier, so they can be valid simultaneously and must be resolved
+///        in a single pass: once we advance past that identifier we cannot rewind, so a fall-through to a second
+///        check would scan from a corrupted position.
+///
+///        All three emit a zero-width marker anchored here; for export declarations the `export` keyword itself is
+///        then lexed normally by the internal lexer.
+/// @param lexer the lexer
+/// @param valid_symbols valid symbols; at least one of the three markers is valid
+/// @return true if a marker was lexed
+static bool scan_declaration_marker(TSLexer *lexer, const bool *valid_symbols) {
+  lexer->mark_end(lexer);
 
-    case 'u':
-      return strcaseeq_any(key, "Up");
+  // Only the export path needs to advance past the leading word before the function/method
+  // check, so it has to fully resolve the declaration here. We gate it on a cheap first-char
+  // test so ordinary declarations (whose name does not start with 'e') reach the untouched
+  // function/method check below.
+  if (valid_symbols[EXPORT_DEF_MARKER]) {
+    STATS_PROBE(EXPORT_DEF_MARKER);
+    skip_whitespace(lexer);
+    if (lexer->lookahead == 'e' || lexer->lookahead == 'E') {
+      char w[KW_BUF_SIZE];
+      int wl = skip_identifier(lexer, w, sizeof(w));
 
-    case 'v':
-      if (strcaseeq_any(key, "Volume_Mute", "Volume_Down", "Volume_Up")) {
+      if ((keyword_classes(w, wl) & KW_EXPORT) && export_decl_follows(lexer)) {
+        lexer->result_symbol = EXPORT_DEF_MARKER;
         return true;
       }
-      // Vk virtual key codes: Vk followed by 2 hex digits
-      if (len == 4 && ascii_tolower(key[1]) == 'k') {
-        return is_xdigit(key[2]) && is_xdigit(key[3]);
-      }
-      return false;
-
-    case 'w':
-      return strcaseeq_any(key, "WheelDown", "WheelUp", "WheelLeft", "WheelRight");
 
-    case 'x':
-      return strcaseeq_any(key, "XButton1", "XButton2");
+      // The 'e' word is an ordinary name (either not "export", or "export" not beginning a
+      // declaration, e.g. a function literally named `export`). The only declaration it can
+      // still begin is a function/method definition `name(...) { | =>`. Functions — unlike
+      // methods — cannot shadow keywords.
+      bool method = !valid_symbols[FUNCTION_DEF_MARKER] && valid_symbols[METHOD_DEF_MARKER];
+      if (!(!method && is_keyword(w, wl)) && is_function_body_follows(lexer, false)) {
+        lexer->result_symbol = valid_symbols[FUNCTION_DEF_MARKER]
+                                 ? FUNCTION_DEF_MARKER : METHOD_DEF_MARKER;
+        return true;
+      }
 
-    default:
       return false;
+    }
   }
-}
 
-/// @brief Main scan function. See https://tree-sitter.github.io/tree-sitter/creating-parsers/4-external-scanners.html#scan
-/// @param payload no touching
-/// @param lexer the lexer, see the link above
-/// @param valid_symbols list of external tokens expected by the parser
-/// @return true if a token was succesfuly lexed, false otherwise. Set lexer->result_symbol before returning true
-bool tree_sitter_autohotkey_external_scanner_scan(void *payload, TSLexer *lexer, const bool *valid_symbols) {
-  // Check optional marker vs ternary operator
-  if (valid_symbols[OPTIONAL_MARKER]) {
-    if (is_optional_marker(lexer)) {
-      lexer->result_symbol = OPTIONAL_MARKER;
+  if (valid_symbols[FUNCTION_DEF_MARKER]) {
+    STATS_PROBE(FUNCTION_DEF_MARKER);
+    if (is_function_declaration(lexer, false)) {
+      lexer->result_symbol = FUNCTION_DEF_MARKER;
+      return true;
+    }
+  }
+
+  if (valid_symbols[METHOD_DEF_MARKER]) {
+    STATS_PROBE(METHOD_DEF_MARKER);
+    if (is_function_declaration(lexer, true)) {
+      lexer->result_symbol = METHOD_DEF_MARKER;
       return true;
     }
   }
 
+  return false;
+}
+
+/// @brief Scans for a token when the lookahead is whitespace or NUL (EOF). Most probes skip leading whitespace
+///        themselves, so the first character doesn't tell us which token this will be, and every probe runs in a
+///        fixed order. Each may advance the shared lexer before failing, so order matters here. (The optional
+///        marker is missing since it can't follow whitespace.)
+/// @param lexer the lexer
+/// @param valid_symbols valid symbols
+/// @return true if a token was lexed
+static bool scan_from_whitespace(TSLexer *lexer, const bool *valid_symbols) {
   // OTB ("one true brace") marker: a zero-width token emitted only when the next '{' is on the
   // same line — i.e. reached after skipping only horizontal whitespace, with no intervening
   // newline. It lets the grammar require an unenclosed function-expression body's brace to be
   // OTB (`f() {`), so that `f()` followed by a brace on the *next* line is read as a call plus a
   // separate block rather than a function expression. Only valid right after a function head.
   if (valid_symbols[OTB_BRACE]) {
+    STATS_PROBE(OTB_BRACE);
     lexer->mark_end(lexer);  // zero-width: the '{' itself is lexed normally by the block rule
 
     while (lexer->lookahead == ' ' || lexer->lookahead == '\t') {
@@ -767,6 +896,7 @@ bool tree_sitter_autohotkey_external_scanner_scan(void *payload, TSLexer *lexer,
 
   // Check for empty arg
   if(valid_symbols[EMPTY_ARG]) {
+    STATS_PROBE(EMPTY_ARG);
     lexer->mark_end(lexer);
 
     if (is_empty_arg(lexer)) {
@@ -776,6 +906,7 @@ bool tree_sitter_autohotkey_external_scanner_scan(void *payload, TSLexer *lexer,
   }
 
   if(valid_symbols[IMPLICIT_CONCAT_MARKER]) {
+    STATS_PROBE(IMPLICIT_CONCAT_MARKER);
     lexer->mark_end(lexer);
 
     if(is_implicit_concatenation(lexer)) {
@@ -784,27 +915,13 @@ bool tree_sitter_autohotkey_external_scanner_scan(void *payload, TSLexer *lexer,
     }
   }
 
-  // Check for array expansion marker vs multiplication operator.
-  // Both are '*' immediately after an expression; we disambiguate by looking ahead:
-  // array expansion is always the last thing in an arg list, so '*' must be followed by ')' or ']'.
+  // The probes above may have skipped whitespace, so the lookahead can be a '*' by now.
   if (valid_symbols[ARRAY_EXPANSION_MARKER] && lexer->lookahead == '*') {
-    lexer->advance(lexer, false);
-    lexer->mark_end(lexer);
-
-    // Skip whitespace to see what follows
-    skip_whitespace(lexer);
-
-    if (lexer->lookahead == ')' || lexer->lookahead == ']') {
-      lexer->result_symbol = ARRAY_EXPANSION_MARKER;
-      return true;
-    }
-
-    // Not array expansion — it's a multiplication operator.
-    // No other external token starts with '*', so return false to let the regular lexer handle it.
-    return false;
+    return scan_array_expansion(lexer);
   }
 
   if(valid_symbols[CONTINUATION_SECTION_START]) {
+    STATS_PROBE(CONTINUATION_SECTION_START);
     lexer->mark_end(lexer);
 
     ContinuationResult cont = is_continuation_start(lexer);
@@ -825,6 +942,7 @@ bool tree_sitter_autohotkey_external_scanner_scan(void *payload, TSLexer *lexer,
   }
 
   if(valid_symbols[CONTINUATION_NEWLINE]) {
+    STATS_PROBE(CONTINUATION_NEWLINE);
     lexer->mark_end(lexer);
 
     if(scan_continuation_newline(lexer)) {
@@ -833,75 +951,14 @@ bool tree_sitter_autohotkey_external_scanner_scan(void *payload, TSLexer *lexer,
     }
   }
 
-  // Disambiguate hotkey :: from remap :: by looking ahead after "::"
-  // A remap is: trigger :: [modifiers] key EOL (single key on same line)
-  // A hotkey is: trigger :: body (anything else)
   if (valid_symbols[HOTKEY_DOUBLE_COLON] || valid_symbols[REMAP_DOUBLE_COLON]) {
     if (lexer->lookahead == ':') {
-      lexer->advance(lexer, false);
-      if (lexer->lookahead == ':') {
-        lexer->advance(lexer, false);
-        lexer->mark_end(lexer);  // token is just "::"
-
-        // Look ahead to determine if this is a remap or hotkey
-        // Skip optional hotkey modifier symbols
-        while (is_hotkey_modifier(lexer->lookahead)) {
-          lexer->advance(lexer, false);
-        }
-
-        // Check what follows to determine if this is a remap destination
-        bool found_key = false;
-
-        if (is_identifier_char(lexer->lookahead)) {
-          // Word-like key: read identifier and validate against key list
-          char key_buf[24] = {0};
-          int key_len = skip_identifier(lexer, key_buf, sizeof(key_buf));
-
-          // AltTab commands are hotkey bodies, not remap destinations
-          if (is_alttab_command(key_buf)) {
-            goto hotkey_colon;
-          }
-
-          found_key = is_remap_key(key_buf, key_len);
-        } else if (lexer->lookahead == '`') {
-          // Backtick escape sequence (e.g., `{ for literal open brace)
-          lexer->advance(lexer, false);
-          if (!is_eol(lexer->lookahead) && !is_eof(lexer)) {
-            lexer->advance(lexer, false);  // consume the escaped char
-            found_key = true;
-          }
-        } else if (!is_eol(lexer->lookahead) && !is_eof(lexer) &&
-                   lexer->lookahead != ' ' && lexer->lookahead != '\t' &&
-                   lexer->lookahead != '{') {
-          // Single non-identifier char key (e.g., }, (, -, .)
-          // Excludes { which starts a hotkey body block
-          lexer->advance(lexer, false);
-          found_key = true;
-        }
-
-        if (found_key) {
-          // After the key, must be EOL (nothing else on the line)
-          skip_horizontal_ws(lexer);
-          if (is_eol(lexer->lookahead) || is_eof(lexer) || lexer->lookahead == ';') {
-            if (valid_symbols[REMAP_DOUBLE_COLON]) {
-              lexer->result_symbol = REMAP_DOUBLE_COLON;
-              return true;
-            }
-          }
-        }
-
-        hotkey_colon:
-        if (valid_symbols[HOTKEY_DOUBLE_COLON]) {
-          lexer->result_symbol = HOTKEY_DOUBLE_COLON;
-          return true;
-        }
-      }
-      // Single ":" — not our token, let the regular lexer handle it
-      return false;
+      return scan_double_colon(lexer, valid_symbols);
     }
   }
 
   if(valid_symbols[EOL]) {
+    STATS_PROBE(EOL);
     lexer->mark_end(lexer);
 
     if(is_last_element(lexer)) {
@@ -927,6 +984,7 @@ bool tree_sitter_autohotkey_external_scanner_scan(void *payload, TSLexer *lexer,
   // the leading whitespace isn't folded into the comment token; on a non-comment the lexer is reset
   // when scan() ultimately returns false.
   if (valid_symbols[BLOCK_COMMENT]) {
+    STATS_PROBE(BLOCK_COMMENT);
     skip_whitespace(lexer);
     if (lexer->lookahead == '/' && scan_block_comment(lexer)) {
       lexer->result_symbol = BLOCK_COMMENT;
@@ -934,58 +992,259 @@ bool tree_sitter_autohotkey_external_scanner_scan(void *payload, TSLexer *lexer,
     }
   }
 
-  // Statement-level declaration heads — export declaration, function declaration and method
-  // declaration all begin with a leading identifier, so they can be valid simultaneously and
-  // must be resolved in a single pass: once we advance past that identifier we cannot rewind,
-  // so a fall-through to a second block would scan from a corrupted position.
-  //
-  // All three emit a zero-width marker anchored here; for export declarations the `export`
-  // keyword itself is then lexed normally by the internal lexer.
   // We need to check this last.
   if (valid_symbols[FUNCTION_DEF_MARKER] || valid_symbols[METHOD_DEF_MARKER] ||
       valid_symbols[EXPORT_DEF_MARKER]) {
-    lexer->mark_end(lexer);
+    return scan_declaration_marker(lexer, valid_symbols);
+  }
 
-    // Only the export path needs to advance past the leading word before the function/method
-    // check, so it has to fully resolve the declaration here. We gate it on a cheap first-char
-    // test so ordinary declarations (whose name does not start with 'e') reach the untouched
-    // function/method check below.
-    if (valid_symbols[EXPORT_DEF_MARKER]) {
-      skip_whitespace(lexer);
-      if (lexer->lookahead == 'e' || lexer->lookahead == 'E') {
-        char w[16];
-        int wl = skip_identifier(lexer, w, sizeof(w));
-
-        if (wl == 6 && strcaseeq(w, "export") && export_decl_follows(lexer)) {
-          lexer->result_symbol = EXPORT_DEF_MARKER;
+  return false;
+}
+
+/// @brief Scans for an external token; see tree_sitter_autohotkey_external_scanner_scan
+static bool scan(TSLexer *lexer, const bool *valid_symbols) {
+  // Apart from whitespace, each external token can only begin with one particular character (or, for the
+  // declaration markers, an identifier character), so dispatch on the lookahead and run just the probe that can
+  // match. Besides saving work, this keeps a probe that advances and then fails from handing a corrupted position
+  // to the next one.
+  switch (lexer->lookahead) {
+    case ' ':
+    case '\t':
+    case '\r':
+    case '\n':
+    case '\0':
+      return scan_from_whitespace(lexer, valid_symbols);
+
+    // Optional marker vs ternary operator
+    case '?':
+      if (valid_symbols[OPTIONAL_MARKER]) {
+        STATS_PROBE(OPTIONAL_MARKER);
+        if (is_optional_marker(lexer)) {
+          lexer->result_symbol = OPTIONAL_MARKER;
           return true;
         }
+      }
+      return false;
+
+    // OTB brace with no whitespace before it, e.g. `f(){`
+    case '{':
+      if (valid_symbols[OTB_BRACE]) {
+        STATS_PROBE(OTB_BRACE);
+        lexer->mark_end(lexer);
+        lexer->result_symbol = OTB_BRACE;
+        return true;
+      }
+      return false;
+
+    case ',':
+      if (valid_symbols[EMPTY_ARG]) {
+        STATS_PROBE(EMPTY_ARG);
+        lexer->mark_end(lexer);
+        lexer->result_symbol = EMPTY_ARG;
+        return true;
+      }
+      return false;
+
+    case '*':
+      if (valid_symbols[ARRAY_EXPANSION_MARKER]) {
+        return scan_array_expansion(lexer);
+      }
+      // Multiplication operator, which the regular lexer handles
+      return false;
 
-        // The 'e' word is an ordinary name (either not "export", or "export" not beginning a
-        // declaration, e.g. a function literally named `export`). The only declaration it can
-        // still begin is a function/method definition `name(...) { | =>`. Functions — unlike
-        // methods — cannot shadow keywords.
-        bool method = !valid_symbols[FUNCTION_DEF_MARKER] && valid_symbols[METHOD_DEF_MARKER];
-        if (!(!method && is_keyword(w)) && is_function_body_follows(lexer, false)) {
-          lexer->result_symbol = valid_symbols[FUNCTION_DEF_MARKER]
-                                   ? FUNCTION_DEF_MARKER : METHOD_DEF_MARKER;
+    case ':':
+      if (valid_symbols[HOTKEY_DOUBLE_COLON] || valid_symbols[REMAP_DOUBLE_COLON]) {
+        return scan_double_colon(lexer, valid_symbols);
+      }
+      return false;
+
+    // A line comment ends the line just like a newline does
+    case ';':
+      if (valid_symbols[EOL]) {
+        STATS_PROBE(EOL);
+        lexer->mark_end(lexer);
+        lexer->result_symbol = EOL;
+        return true;
+      }
+      return false;
+
+    case '/':
+      if (valid_symbols[BLOCK_COMMENT]) {
+        STATS_PROBE(BLOCK_COMMENT);
+        if (scan_block_comment(lexer)) {
+          lexer->result_symbol = BLOCK_COMMENT;
           return true;
         }
+      }
+      return false;
 
-        return false;
+    default:
+      if (is_identifier_char(lexer->lookahead) &&
+          (valid_symbols[FUNCTION_DEF_MARKER] || valid_symbols[METHOD_DEF_MARKER] ||
+           valid_symbols[EXPORT_DEF_MARKER])) {
+        return scan_declaration_marker(lexer, valid_symbols);
       }
-    }
+      return false;
+  }
+}
 
-    if (valid_symbols[FUNCTION_DEF_MARKER] && is_function_declaration(lexer, false)) {
-      lexer->result_symbol = FUNCTION_DEF_MARKER;
-      return true;
-    }
+#ifdef TREE_SITTER_AHK_STATS
+
+// Probe instrumentation. scan() runs against a proxy lexer that forwards to the real one and counts every advance
+// against the probe that made it. Counters are process-wide and unsynchronized, so read them from a single-threaded
+// benchmark. A "byte" here is one lexer advance, i.e. one code point. The header isn't shipped in src/, so a stats build
+// needs bindings/c on the include path, as the CMake build adds with TREE_SITTER_AHK_STATS.
+
+#include <tree_sitter/tree-sitter-autohotkey.h>
+#include <stdint.h>
+
+_Static_assert(TOKEN_TYPE_COUNT == TREE_SITTER_AUTOHOTKEY_EXTERNAL_TOKEN_COUNT,
+               "TREE_SITTER_AUTOHOTKEY_EXTERNAL_TOKEN_COUNT is out of sync with enum TokenType");
+
+/// Most probes one scan() call can run: every token once, plus the function and method checks after export
+#define MAX_PROBES_PER_SCAN (TOKEN_TYPE_COUNT + 2)
+
+typedef struct {
+  TSLexer lexer;   ///< handed to scan(); must be first
+  TSLexer *inner;  ///< the runtime's lexer
+  uint32_t offset; ///< advances so far in this call
+  uint32_t marked; ///< offset at the last mark_end, or UINT32_MAX if there wasn't one
+} StatsLexer;
+
+typedef struct {
+  enum TokenType token;
+  uint32_t start;  ///< offset at which the probe began
+} ProbeSpan;
+
+/// Indexed by TokenType; spelled as in grammar.js
+static const char *const token_names[TOKEN_TYPE_COUNT] = {
+  "optional_marker",
+  "_function_def_marker",
+  "_method_def_marker",
+  "empty_arg",
+  "_implicit_concat_marker",
+  "_continuation_section_start",
+  "_continuation_newline",
+  "_eol",
+  "block_comment",
+  "array_expansion_marker",
+  "_hotkey_double_colon",
+  "_remap_double_colon",
+  "_export_def_marker",
+  "_otb_brace",
+};
 
-    if (valid_symbols[METHOD_DEF_MARKER] && is_function_declaration(lexer, true)) {
-      lexer->result_symbol = METHOD_DEF_MARKER;
-      return true;
+static TSAutohotkeyTokenStats token_stats[TOKEN_TYPE_COUNT];
+static ProbeSpan probe_spans[MAX_PROBES_PER_SCAN];
+static uint32_t probe_count;
+static StatsLexer *active_lexer;
+
+static void stats_begin_probe(enum TokenType token) {
+  token_stats[token].probes++;
+  if (probe_count < MAX_PROBES_PER_SCAN) {
+    probe_spans[probe_count].token = token;
+    probe_spans[probe_count].start = active_lexer->offset;
+    probe_count++;
+  }
+}
+
+static void stats_advance(TSLexer *lexer, bool skip) {
+  StatsLexer *stats = (StatsLexer *)lexer;
+  stats->inner->advance(stats->inner, skip);
+  lexer->lookahead = stats->inner->lookahead;
+  stats->offset++;
+  if (probe_count > 0) {
+    token_stats[probe_spans[probe_count - 1].token].advanced++;
+  }
+}
+
+static void stats_mark_end(TSLexer *lexer) {
+  StatsLexer *stats = (StatsLexer *)lexer;
+  stats->inner->mark_end(stats->inner);
+  stats->marked = stats->offset;
+}
+
+static uint32_t stats_get_column(TSLexer *lexer) {
+  StatsLexer *stats = (StatsLexer *)lexer;
+  return stats->inner->get_column(stats->inner);
+}
+
+static bool stats_is_at_included_range_start(const TSLexer *lexer) {
+  const StatsLexer *stats = (const StatsLexer *)lexer;
+  return stats->inner->is_at_included_range_start(stats->inner);
+}
+
+static bool stats_eof(const TSLexer *lexer) {
+  const StatsLexer *stats = (const StatsLexer *)lexer;
+  return stats->inner->eof(stats->inner);
+}
+
+static bool stats_scan(TSLexer *inner, const bool *valid_symbols) {
+  StatsLexer stats = {
+    .lexer = {
+      .lookahead = inner->lookahead,
+      .result_symbol = inner->result_symbol,
+      .advance = stats_advance,
+      .mark_end = stats_mark_end,
+      .get_column = stats_get_column,
+      .is_at_included_range_start = stats_is_at_included_range_start,
+      .eof = stats_eof,
+    },
+    .inner = inner,
+    .offset = 0,
+    .marked = UINT32_MAX,
+  };
+  active_lexer = &stats;
+  probe_count = 0;
+
+  bool found = scan(&stats.lexer, valid_symbols);
+  if (found) {
+    inner->result_symbol = stats.lexer.result_symbol;
+    token_stats[stats.lexer.result_symbol].hits++;
+  }
+
+  // Everything a probe advanced past the end of the returned token - or all of it, if there was no token - is read
+  // again by whatever lexes next. Without a mark_end the token ends wherever the lexer stopped.
+  uint32_t kept = found ? (stats.marked == UINT32_MAX ? stats.offset : stats.marked) : 0;
+  for (uint32_t i = 0; i < probe_count; i++) {
+    uint32_t start = probe_spans[i].start;
+    uint32_t end = i + 1 < probe_count ? probe_spans[i + 1].start : stats.offset;
+    if (end > kept) {
+      token_stats[probe_spans[i].token].discarded += end - (start > kept ? start : kept);
     }
   }
 
-  return false;
-}
\ No newline at end of file
+  active_lexer = NULL;
+  return found;
+}
+
+uint32_t tree_sitter_autohotkey_scanner_stats(TSAutohotkeyTokenStats *stats, uint32_t count) {
+  uint32_t i;
+  for (i = 0; i < count && i < TOKEN_TYPE_COUNT; i++) {
+    stats[i] = token_stats[i];
+  }
+  return i;
+}
+
+const char *tree_sitter_autohotkey_scanner_token_name(uint32_t index) {
+  return index < TOKEN_TYPE_COUNT ? token_names[index] : NULL;
+}
+
+void tree_sitter_autohotkey_scanner_stats_reset(void) {
+  memset(token_stats, 0, sizeof(token_stats));
+}
+
+#endif
+
+/// @brief Main scan function. See https://tree-sitter.github.io/tree-sitter/creating-parsers/4-external-scanners.html#scan
+/// @param payload no touching
+/// @param lexer the lexer, see the link above
+/// @param valid_symbols list of external tokens expected by the parser
+/// @return true if a token was succesfuly lexed, false otherwise. Set lexer->result_symbol before returning true
+bool tree_sitter_autohotkey_external_scanner_scan(void *payload, TSLexer *lexer, const bool *valid_symbols) {
+#ifdef TREE_SITTER_AHK_STATS
+  return stats_scan(lexer, valid_symbols);
+#else
+  return scan(lexer, valid_symbols);
+#endif
+}
@@ -1,25 +1,69 @@
 // Builds the grammar's WebAssembly binary from the parent repo and copies it into
 // public/ so the app can fetch it at runtime. The .wasm is a build artifact (gitignored),
 // so this runs automatically before `dev` and `build` (see package.json predev/prebuild).
+//
+// Two profiles post-process the CLI's output with binaryen's wasm-opt:
+//   size   (default) -Oz: smallest download, for the deployed site
+//   speed            -O3: fastest parsing, for profiling in the playground
+// Pick one with `--profile speed` or GRAMMAR_WASM_PROFILE=speed. Without wasm-opt on PATH the
+// CLI's output is used as-is (and the manifest says so).
+//
+// The copy in public/ is named after a hash of its contents, and public/grammar-manifest.json
+// points the app at it, so browsers can cache the module (and its compiled code) per version.
 import { execFileSync } from "node:child_process";
-import { copyFileSync, existsSync, mkdirSync } from "node:fs";
+import { createHash } from "node:crypto";
+import {
+  copyFileSync,
+  existsSync,
+  mkdirSync,
+  readdirSync,
+  readFileSync,
+  rmSync,
+  writeFileSync,
+} from "node:fs";
 import { dirname, join } from "node:path";
 import { fileURLToPath } from "node:url";
 
+const PROFILES = {
+  size: ["-Oz"],
+  speed: ["-O3"],
+};
+
+// Features the CLI's Emscripten toolchain emits; wasm-opt must be told it may keep them.
+const FEATURES = [
+  "--enable-bulk-memory",
+  "--enable-mutable-globals",
+  "--enable-sign-ext",
+  "--enable-nontrapping-float-to-int",
+];
+
 const here = dirname(fileURLToPath(import.meta.url));
 const repoRoot = join(here, "..", "..");
 const wasmName = "tree-sitter-autohotkey.wasm";
 const builtWasm = join(repoRoot, wasmName);
 const publicDir = join(here, "..", "public");
-const dest = join(publicDir, wasmName);
+const manifestPath = join(publicDir, "grammar-manifest.json");
 
-console.log("[build-grammar-wasm] tree-sitter build --wasm (in %s)", repoRoot);
-try {
-  execFileSync("tree-sitter", ["build", "--wasm"], {
+const profileArg = process.argv.indexOf("--profile");
+const profile =
+  (profileArg !== -1 ? process.argv[profileArg + 1] : process.env.GRAMMAR_WASM_PROFILE) ?? "size";
+if (!(profile in PROFILES)) {
+  throw new Error(
+    `[build-grammar-wasm] Unknown profile '${profile}' (expected ${Object.keys(PROFILES).join(" or ")}).`,
+  );
+}
+
+function run(command, args) {
+  execFileSync(command, args, {
     cwd: repoRoot,
     stdio: "inherit",
     shell: process.platform === "win32", // resolve tree-sitter.cmd on Windows
   });
+}
+
+console.log("[build-grammar-wasm] tree-sitter build --wasm (in %s)", repoRoot);
+try {
+  run("tree-sitter", ["build", "--wasm"]);
 } catch (err) {
   console.error(
     "\n[build-grammar-wasm] Failed to build the wasm. Is the tree-sitter CLI installed and on PATH?",
@@ -34,5 +78,44 @@ if (!existsSync(builtWasm)) {
 }
 
 mkdirSync(publicDir, { recursive: true });
-copyFileSync(builtWasm, dest);
-console.log("[build-grammar-wasm] Copied %s -> %s", wasmName, dest);
+const staged = join(publicDir, wasmName);
+
+let optimized = true;
+try {
+  run("wasm-opt", [...PROFILES[profile], ...FEATURES, builtWasm, "-o", staged]);
+} catch {
+  console.warn(
+    "[build-grammar-wasm] wasm-opt (binaryen) not found or failed; using the unoptimized build.",
+  );
+  copyFileSync(builtWasm, staged);
+  optimized = false;
+}
+
+const bytes = readFileSync(staged);
+const version = createHash("sha256").update(bytes).digest("hex").slice(0, 16);
+const file = `tree-sitter-autohotkey.${version}.wasm`;
+
+// Drop copies from earlier builds so public/ holds exactly the version the manifest names.
+for (const old of readdirSync(publicDir)) {
+  if (/^tree-sitter-autohotkey\.[0-9a-f]+\.wasm$/.test(old) && old !== file) {
+    rmSync(join(publicDir, old));
+  }
+}
+copyFileSync(staged, join(publicDir, file));
+rmSync(staged);
+
+writeFileSync(
+  manifestPath,
+  JSON.stringify(
+    { file, version, profile: optimized ? profile : "unoptimized", bytes: bytes.length },
+    null,
+    2,
+  ) + "\n",
+);
+console.log(
+  "[build-grammar-wasm] %s -> %s (%s, %d bytes)",
+  wasmName,
+  join(publicDir, file),
+  optimized ? profile : "unoptimized",
+  bytes.length,
+);
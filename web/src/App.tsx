@@ -1,30 +1,44 @@
 import { useEffect, useMemo, useRef, useState } from "react";
 import { Editor, type HighlightRange } from "./components/Editor";
 import { TreeView } from "./components/TreeView";
-import {
-  parse,
-  type Highlight,
-  type QueryResult,
-  type SyntaxNode,
+import type {
+  ParseStats,
+  ParseTimeout,
+  QueryResult,
+  SourceEdit,
+  StartupTimings,
 } from "./lib/parser";
+import { highlight, parse } from "./lib/parseClient";
+import { NO_SPANS, type Spans } from "./lib/spans";
+import type { FlatTree, SyntaxNode } from "./lib/flatTree";
 import { decodeSource, encodeSource } from "./lib/urlState";
 import { SAMPLE_AHK } from "./sample";
 import "./App.css";
 
 const PARSE_DEBOUNCE_MS = 150;
+const HIGHLIGHT_DEBOUNCE_MS = 50;
+// Well beyond any real script; only a pathological input, or a grammar bug, takes this long.
+const PARSE_TIMEOUT_MS = 5000;
 
 export function App() {
   const [source, setSource] = useState("");
   const [query, setQuery] = useState("");
-  const [root, setRoot] = useState<SyntaxNode | null>(null);
-  const [highlights, setHighlights] = useState<Highlight[]>([]);
+  const [tree, setTree] = useState<FlatTree | null>(null);
+  const [highlights, setHighlights] = useState<Spans>(NO_SPANS);
   const [queryResult, setQueryResult] = useState<QueryResult | null>(null);
   const [error, setError] = useState<string | null>(null);
+  const [stats, setStats] = useState<ParseStats | null>(null);
+  const [timedOut, setTimedOut] = useState<ParseTimeout | null>(null);
+  const [startup, setStartup] = useState<StartupTimings | null>(null);
   const [showAnonymous, setShowAnonymous] = useState(false);
 
   const [hovered, setHovered] = useState<SyntaxNode | null>(null);
   const [selected, setSelected] = useState<SyntaxNode | null>(null);
 
+  // Editor edits made since the last parse started, so the parser can re-use its previous tree.
+  // Null when the source was replaced outright and the edits no longer describe it.
+  const pendingEdits = useRef<SourceEdit[] | null>([]);
+
   // Read text off the 'src' key in the URL fragment if we have one. The
   // fragment (never sent to the server) sidesteps request-line length limits.
   useEffect(() => {
@@ -37,26 +51,60 @@ export function App() {
     if (encoded) {
       const decoded = decodeSource(encoded);
       if (decoded !== null) {
+        pendingEdits.current = null;
         setSource(decoded);
         return;
       }
     }
 
     // No source or failed to decode
+    pendingEdits.current = null;
     setSource(SAMPLE_AHK);
   }, []);
 
+  // Rendered editor range. Highlights are only computed around it, so scrolling re-requests them.
+  const viewport = useRef<HighlightRange>({ from: 0, to: 0 });
+  const highlightTimer = useRef<ReturnType<typeof setTimeout> | undefined>(undefined);
+  const highlightId = useRef(0);
+  const onViewportChange = (range: HighlightRange) => {
+    viewport.current = range;
+    clearTimeout(highlightTimer.current);
+    highlightTimer.current = setTimeout(async () => {
+      const id = ++highlightId.current;
+      try {
+        const spans = await highlight(viewport.current);
+        if (spans && id === highlightId.current) setHighlights(spans);
+      } catch {
+        // Surfaced by the next parse, which fails the same way.
+      }
+    }, HIGHLIGHT_DEBOUNCE_MS);
+  };
+  useEffect(() => () => clearTimeout(highlightTimer.current), []);
+
   // Debounced, race-safe parsing: each run tags itself and only the latest applies.
   const runId = useRef(0);
   useEffect(() => {
     const id = ++runId.current;
     const timer = setTimeout(async () => {
+      // Drained here rather than when the effect runs: a cancelled run leaves its edits for the next.
+      const edits = pendingEdits.current;
+      pendingEdits.current = [];
       try {
-        const { root: tree, highlights: hl, query: qr } = await parse(source, query);
-        if (id === runId.current) {
-          setRoot(tree);
+        const result = await parse(source, query, edits, viewport.current, PARSE_TIMEOUT_MS);
+        // Null: the worker skipped this request for a newer one, which carries its edits.
+        if (result && "timedOut" in result) {
+          // The tree and highlights from the last complete parse stay up, flagged as stale.
+          if (id === runId.current) setTimedOut(result);
+        } else if (result && id === runId.current) {
+          const { tree: flat, highlights: hl, query: qr, stats: st } = result;
+          // Newer than any highlight-only request already in flight.
+          highlightId.current++;
+          setTree(flat);
           setHighlights(hl);
           setQueryResult(qr);
+          setStats(st);
+          if (result.startup) setStartup(result.startup);
+          setTimedOut(null);
           setError(null);
         }
       } catch (err) {
@@ -79,7 +127,8 @@ export function App() {
   }, [source, query]);
 
   // Editing invalidates the previously selected/hovered nodes (their ids are per-parse).
-  const onChange = (value: string) => {
+  const onChange = (value: string, edits: SourceEdit[]) => {
+    pendingEdits.current?.push(...edits);
     setSource(value);
     setHovered(null);
     setSelected(null);
@@ -94,7 +143,7 @@ export function App() {
 
   // Query outputs, with stable references so the editor doesn't re-dispatch every render.
   const queryMatches = useMemo(
-    () => queryResult?.matches ?? [],
+    () => queryResult?.matches ?? NO_SPANS,
     [queryResult],
   );
   const matchedIds = queryResult?.matchedIds ?? null;
@@ -106,11 +155,21 @@ export function App() {
         <span className="app-subtitle">
           Parse tree playground · hover or click a node to highlight its source
         </span>
+        {startup && (
+          <span
+            className="app-startup push-right"
+            title={`Grammar ${startup.version} (${startup.profile}, ${startup.wasmBytes} bytes)`}
+          >
+            runtime {startup.runtimeMs.toFixed(0)} ms · fetch{" "}
+            {startup.cached ? "cached" : `${startup.fetchMs.toFixed(0)} ms`} · compile{" "}
+            {startup.compileMs.toFixed(0)} ms · first parse {startup.firstParseMs.toFixed(0)} ms
+          </span>
+        )}
         <a
           href="https://github.com/holy-tao/tree-sitter-autohotkey"
           target="_blank"
           rel="noopener noreferrer"
-          className="push-right"
+          className={startup ? undefined : "push-right"}
         >
           GitHub
         </a>
@@ -123,12 +182,15 @@ export function App() {
             highlight={highlight}
             highlights={highlights}
             queryMatches={queryMatches}
+            onViewportChange={onViewportChange}
           />
         </section>
         <section className="pane pane-tree">
           <TreeView
-            root={root}
+            tree={tree}
             error={error}
+            stats={stats}
+            timedOut={timedOut}
             showAnonymous={showAnonymous}
             onToggleAnonymous={setShowAnonymous}
             selectedId={selected?.id ?? null}
@@ -1,11 +1,13 @@
 // Left pane: a CodeMirror 6 editor. Beyond editing, it exposes a single imperative
 // affordance the playground needs -- highlighting an arbitrary source range -- driven
 // by the `highlight` prop and implemented with a StateField-backed decoration.
-import { useEffect, useRef } from "react";
+import { useEffect, useMemo, useRef } from "react";
 import CodeMirror, { type ReactCodeMirrorRef } from "@uiw/react-codemirror";
 import { EditorView, Decoration, type DecorationSet } from "@codemirror/view";
 import { StateEffect, StateField, RangeSetBuilder } from "@codemirror/state";
-import type { Highlight } from "../lib/parser";
+import type { SourceEdit } from "../lib/parser";
+import { SPAN_STRIDE, spanCount, type Highlight, type Spans } from "../lib/spans";
+import { editsFromChanges } from "../lib/edits";
 
 export interface HighlightRange {
   from: number;
@@ -63,25 +65,22 @@ const highlightField = StateField.define<DecorationSet>({
 // Tree-sitter captures can overlap (a parent node and its child both match). Flatten them
 // into non-overlapping spans where the narrower - and, for equal spans, later - capture wins,
 // matching the usual tree-sitter highlighting precedence.
-function resolveHighlights(highlights: Highlight[]): Highlight[] {
-  if (highlights.length === 0) return [];
+function resolveHighlights(spans: Spans): Highlight[] {
+  const count = spanCount(spans);
+  if (count === 0) return [];
+  const d = spans.data;
   let maxTo = 0;
-  for (const h of highlights) if (h.to > maxTo) maxTo = h.to;
+  for (let i = 0; i < count; i++) maxTo = Math.max(maxTo, d[i * SPAN_STRIDE + 1]);
 
   const winner = new Int32Array(maxTo).fill(-1);
-  const order = highlights
-    .map((_, i) => i)
-    .sort((a, b) => {
-      const span =
-        highlights[b].to -
-        highlights[b].from -
-        (highlights[a].to - highlights[a].from);
-
-      return span || a - b; // longest first; ties keep original (earlier) order so later paints last
-    });
+  const width = (i: number) => d[i * SPAN_STRIDE + 1] - d[i * SPAN_STRIDE];
+  const order = Array.from({ length: count }, (_, i) => i).sort(
+    // longest first; ties keep original (earlier) order so later paints last
+    (a, b) => width(b) - width(a) || a - b,
+  );
   for (const i of order) {
-    const { from, to } = highlights[i];
-    for (let p = from; p < to; p++) winner[p] = i;
+    const to = d[i * SPAN_STRIDE + 1];
+    for (let p = d[i * SPAN_STRIDE]; p < to; p++) winner[p] = i;
   }
 
   // Coalesce contiguous runs of the same winning capture into single spans.
@@ -96,7 +95,7 @@ function resolveHighlights(highlights: Highlight[]): Highlight[] {
     let q = p + 1;
     while (q < maxTo && winner[q] === w) q++;
 
-    out.push({ from: p, to: q, type: highlights[w].type });
+    out.push({ from: p, to: q, type: spans.names[d[w * SPAN_STRIDE + 2]] });
     p = q;
   }
 
@@ -129,7 +128,7 @@ function markFor(type: string): Decoration {
   return mark;
 }
 
-const setSyntax = StateEffect.define<Highlight[]>();
+const setSyntax = StateEffect.define<Spans>();
 
 const syntaxField = StateField.define<DecorationSet>({
   create() {
@@ -157,7 +156,7 @@ const syntaxField = StateField.define<DecorationSet>({
 
 // Query-match layer: paints every source range captured by the playground query. Distinct from
 // the hover highlight (single node) and syntax coloring, so matches stand out on their own.
-const setQueryMatches = StateEffect.define<Highlight[]>();
+const setQueryMatches = StateEffect.define<Spans>();
 
 const queryMatchMark = Decoration.mark({ class: "cm-query-match" });
 
@@ -171,8 +170,11 @@ const queryMatchField = StateField.define<DecorationSet>({
       if (effect.is(setQueryMatches)) {
         const len = tr.state.doc.length;
         // Captures may overlap; sort by start so the RangeSetBuilder gets ascending ranges.
-        const ranges = effect.value
-          .map((h) => ({ from: Math.min(h.from, len), to: Math.min(h.to, len) }))
+        const d = effect.value.data;
+        const ranges = Array.from({ length: spanCount(effect.value) }, (_, i) => ({
+          from: Math.min(d[i * SPAN_STRIDE], len),
+          to: Math.min(d[i * SPAN_STRIDE + 1], len),
+        }))
           .filter((r) => r.to > r.from)
           .sort((a, b) => a.from - b.from || a.to - b.to);
 
@@ -188,10 +190,13 @@ const queryMatchField = StateField.define<DecorationSet>({
 
 interface EditorProps {
   value: string;
-  onChange: (value: string) => void;
+  /** Called on user edits with the new text and the tree-sitter edits that produced it. */
+  onChange: (value: string, edits: SourceEdit[]) => void;
   highlight: HighlightRange | null;
-  highlights: Highlight[];
-  queryMatches: Highlight[];
+  highlights: Spans;
+  queryMatches: Spans;
+  /** Called with the rendered document range whenever it changes (scrolling, resizing, edits). */
+  onViewportChange: (viewport: HighlightRange) => void;
 }
 
 export function Editor({
@@ -200,9 +205,21 @@ export function Editor({
   highlight,
   highlights,
   queryMatches,
+  onViewportChange,
 }: EditorProps) {
   const ref = useRef<ReactCodeMirrorRef>(null);
 
+  // The listener extension is created once; route it through a ref to reach the latest callback.
+  const viewportCallback = useRef(onViewportChange);
+  viewportCallback.current = onViewportChange;
+  const viewportListener = useMemo(
+    () =>
+      EditorView.updateListener.of((update) => {
+        if (update.viewportChanged) viewportCallback.current(update.view.viewport);
+      }),
+    [],
+  );
+
   // Push highlight changes into CodeMirror imperatively; clamp to the current doc
   // length so a stale range (mid-edit) can never dispatch an out-of-bounds decoration.
   useEffect(() => {
@@ -234,13 +251,19 @@ export function Editor({
       ref={ref}
       className="editor"
       value={value}
-      onChange={onChange}
+      onChange={(text, update) =>
+        onChange(
+          text,
+          editsFromChanges(update.changes, update.startState.doc, update.state.doc),
+        )
+      }
       theme="none"
       extensions={[
         editorTheme,
         syntaxField,
         queryMatchField,
         highlightField,
+        viewportListener,
         EditorView.lineWrapping,
       ]}
       basicSetup={{ foldGutter: false, highlightActiveLine: false }}
@@ -1,12 +1,15 @@
-// One row of the s-expression tree, rendered recursively. Handles its own collapse
-// state and reports hover/selection up so the editor can highlight the matching source.
-import { useState } from "react";
-import type { SyntaxNode } from "../lib/parser";
+// One row of the s-expression tree. Rows are laid out flat by TreeView (indentation comes
+// from the node's depth); each reports hover/selection up so the editor can highlight the
+// matching source, and toggling asks TreeView to collapse or expand its subtree.
+import type { SyntaxNode } from "../lib/flatTree";
 
 interface TreeNodeProps {
   node: SyntaxNode;
-  depth: number;
-  showAnonymous: boolean;
+  /** Row height in pixels; TreeView relies on every row having exactly this height. */
+  height: number;
+  hasChildren: boolean;
+  collapsed: boolean;
+  onToggle: (node: SyntaxNode) => void;
   selectedId: number | null;
   hoveredId: number | null;
   /** Ids of nodes captured by the active query, or null when no query is active. */
@@ -22,21 +25,16 @@ function formatPoint(node: SyntaxNode): string {
 
 export function TreeNode({
   node,
-  depth,
-  showAnonymous,
+  height,
+  hasChildren,
+  collapsed,
+  onToggle,
   selectedId,
   hoveredId,
   matchedIds,
   onHover,
   onSelect,
 }: TreeNodeProps) {
-  const [collapsed, setCollapsed] = useState(false);
-
-  const visibleChildren = showAnonymous
-    ? node.children
-    : node.children.filter((c) => c.isNamed || c.isError || c.isMissing);
-  const hasChildren = visibleChildren.length > 0;
-
   const classes = ["tree-row"];
   if (node.id === selectedId) classes.push("selected");
   if (node.id === hoveredId) classes.push("hovered");
@@ -45,48 +43,26 @@ export function TreeNode({
   else if (!node.isNamed) classes.push("anonymous");
 
   return (
-    <div className="tree-node">
-      <div
-        className={classes.join(" ")}
-        style={{ paddingLeft: `${depth * 1.25 + 0.25}rem` }}
-        onMouseEnter={() => onHover(node)}
-        onMouseLeave={() => onHover(null)}
-        onClick={() => onSelect(node)}
+    <div
+      className={classes.join(" ")}
+      style={{ height, paddingLeft: `${node.depth * 1.25 + 0.25}rem` }}
+      onMouseEnter={() => onHover(node)}
+      onMouseLeave={() => onHover(null)}
+      onClick={() => onSelect(node)}
+    >
+      <span
+        className="tree-toggle"
+        onClick={(e) => {
+          e.stopPropagation();
+          if (hasChildren) onToggle(node);
+        }}
       >
-        <span
-          className="tree-toggle"
-          onClick={(e) => {
-            e.stopPropagation();
-            if (hasChildren) setCollapsed((c) => !c);
-          }}
-        >
-          {hasChildren ? (collapsed ? "▶" : "▼") : "·"}
-        </span>
-        {node.fieldName && (
-          <span className="tree-field">{node.fieldName}: </span>
-        )}
-        <span className="tree-type">{node.type}</span>
-        {node.isMissing && <span className="tree-flag"> MISSING</span>}
-        <span className="tree-pos">{formatPoint(node)}</span>
-      </div>
-
-      {hasChildren && !collapsed && (
-        <div className="tree-children">
-          {visibleChildren.map((child) => (
-            <TreeNode
-              key={child.id}
-              node={child}
-              depth={depth + 1}
-              showAnonymous={showAnonymous}
-              selectedId={selectedId}
-              hoveredId={hoveredId}
-              matchedIds={matchedIds}
-              onHover={onHover}
-              onSelect={onSelect}
-            />
-          ))}
-        </div>
-      )}
+        {hasChildren ? (collapsed ? "▶" : "▼") : "·"}
+      </span>
+      {node.fieldName && <span className="tree-field">{node.fieldName}: </span>}
+      <span className="tree-type">{node.type}</span>
+      {node.isMissing && <span className="tree-flag"> MISSING</span>}
+      <span className="tree-pos">{formatPoint(node)}</span>
     </div>
   );
 }
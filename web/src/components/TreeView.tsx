@@ -1,13 +1,30 @@
 // Right pane: a tree-sitter query box, the scrollable s-expression tree, and a
-// "show anonymous nodes" toggle.
-import { useId } from "react";
-import type { SyntaxNode } from "../lib/parser";
+// "show anonymous nodes" toggle. The tree is virtualized: only rows in (or near) the
+// viewport are materialized and rendered, so its cost follows the pane size, not the file.
+import { useId, useLayoutEffect, useMemo, useRef, useState } from "react";
+import type { ParseStats, ParseTimeout } from "../lib/parser";
+import {
+  hasVisibleChildren,
+  nodeAt,
+  visibleRows,
+  type FlatTree,
+  type SyntaxNode,
+} from "../lib/flatTree";
 import { TreeNode } from "./TreeNode";
 import { QueryBox } from "./QueryBox";
 
+/** Fixed height of a tree row in pixels, so the visible slice follows from the scroll offset. */
+const ROW_HEIGHT = 20;
+/** Rows rendered beyond each edge of the viewport, so fast scrolling doesn't flash blank. */
+const OVERSCAN = 20;
+
 interface TreeViewProps {
-  root: SyntaxNode | null;
+  tree: FlatTree | null;
   error: string | null;
+  /** Figures from the last parse, shown in the toolbar, or null before the first one. */
+  stats: ParseStats | null;
+  /** Set when the latest parse ran out of time, so the tree shown is from an older source. */
+  timedOut: ParseTimeout | null;
   /** If true, show anonymous (_-prefixed) nodes */
   showAnonymous: boolean;
   onToggleAnonymous: (value: boolean) => void;
@@ -23,12 +40,18 @@ interface TreeViewProps {
   onSelect: (node: SyntaxNode) => void;
 }
 
+function reusedPercent(stats: ParseStats): string {
+  return ((100 * stats.reusedNodes) / Math.max(stats.nodeCount, 1)).toFixed(1);
+}
+
 /**
  * Right-pane TreeView component shows the parsed file
  */
 export function TreeView({
-  root,
+  tree,
   error,
+  stats,
+  timedOut,
   showAnonymous,
   onToggleAnonymous,
   selectedId,
@@ -42,6 +65,44 @@ export function TreeView({
 }: TreeViewProps) {
   const showAnonId = useId();
 
+  // Collapsed rows, by pre-order index. Kept across parses, so a collapsed node stays collapsed
+  // while edits elsewhere leave its position in the tree unchanged.
+  const [collapsed, setCollapsed] = useState<ReadonlySet<number>>(() => new Set());
+  const onToggle = (node: SyntaxNode) =>
+    setCollapsed((prev) => {
+      const next = new Set(prev);
+      if (!next.delete(node.id)) next.add(node.id);
+      return next;
+    });
+
+  const rows = useMemo(
+    () => (tree ? visibleRows(tree, showAnonymous, collapsed) : new Uint32Array(0)),
+    [tree, showAnonymous, collapsed],
+  );
+
+  // Track the scroll offset and pane height to know which rows are on screen.
+  const scrollRef = useRef<HTMLDivElement>(null);
+  const [viewport, setViewport] = useState({ top: 0, height: 0 });
+  useLayoutEffect(() => {
+    const el = scrollRef.current;
+    if (!el) return;
+    const update = () => setViewport({ top: el.scrollTop, height: el.clientHeight });
+    update();
+    const observer = new ResizeObserver(update);
+    observer.observe(el);
+    el.addEventListener("scroll", update, { passive: true });
+    return () => {
+      observer.disconnect();
+      el.removeEventListener("scroll", update);
+    };
+  }, []);
+
+  const first = Math.max(0, Math.floor(viewport.top / ROW_HEIGHT) - OVERSCAN);
+  const last = Math.min(
+    rows.length,
+    Math.ceil((viewport.top + viewport.height) / ROW_HEIGHT) + OVERSCAN,
+  );
+
   return (
     <div className="tree-view">
       <QueryBox value={query} onChange={onQueryChange} error={queryError} />
@@ -55,21 +116,54 @@ export function TreeView({
           />
           Show anonymous nodes
         </label>
+        {stats && (
+          <span
+            className="parse-stats push-right"
+            title="Time in parser.parse and in the highlight query; reused nodes lie outside every changed range"
+          >
+            {stats.incremental ? "incremental" : "full"} parse{" "}
+            {stats.parseMs.toFixed(1)} ms
+            {stats.incremental &&
+              ` · ${reusedPercent(stats)}% of ${stats.nodeCount} nodes reused`}
+            {` · highlight ${stats.highlightMs.toFixed(1)} ms`}
+          </span>
+        )}
+        {timedOut && (
+          <span
+            className={stats ? "parse-timeout" : "parse-timeout push-right"}
+            title="The tree and highlights are from the last parse that finished"
+          >
+            parse stopped after {(timedOut.timeoutMs / 1000).toFixed(0)} s · showing an older tree
+          </span>
+        )}
       </div>
-      <div className="tree-scroll" onMouseLeave={() => onHover(null)}>
+      <div
+        ref={scrollRef}
+        className="tree-scroll"
+        onMouseLeave={() => onHover(null)}
+      >
         {error ? (
           <div className="tree-error">{error}</div>
-        ) : root ? (
-          <TreeNode
-            node={root}
-            depth={0}
-            showAnonymous={showAnonymous}
-            selectedId={selectedId}
-            hoveredId={hoveredId}
-            matchedIds={matchedIds}
-            onHover={onHover}
-            onSelect={onSelect}
-          />
+        ) : tree ? (
+          <div className="tree-rows" style={{ height: rows.length * ROW_HEIGHT }}>
+            <div style={{ transform: `translateY(${first * ROW_HEIGHT}px)` }}>
+              {Array.from(rows.subarray(first, last), (i) => (
+                <TreeNode
+                  key={i}
+                  node={nodeAt(tree, i)}
+                  height={ROW_HEIGHT}
+                  hasChildren={hasVisibleChildren(tree, i, showAnonymous)}
+                  collapsed={collapsed.has(i)}
+                  onToggle={onToggle}
+                  selectedId={selectedId}
+                  hoveredId={hoveredId}
+                  matchedIds={matchedIds}
+                  onHover={onHover}
+                  onSelect={onSelect}
+                />
+              ))}
+            </div>
+          </div>
         ) : (
           <div className="tree-loading">Parsing…</div>
         )}
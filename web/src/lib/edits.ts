@@ -0,0 +1,45 @@
+// Translates CodeMirror change sets into the edit records tree-sitter needs to re-use a
+// previous tree. Both sides count in UTF-16 code units, so offsets carry over unchanged.
+import type { ChangeSet, Text } from "@codemirror/state";
+import type { Point, SourceEdit } from "./parser";
+
+function pointAt(doc: Text, pos: number): Point {
+  const line = doc.lineAt(pos);
+  return { row: line.number - 1, column: pos - line.from };
+}
+
+/**
+ * One edit per changed range of `changes`, in the order tree-sitter must apply them. `oldDoc` and
+ * `newDoc` are the documents before and after the whole change set.
+ */
+export function editsFromChanges(
+  changes: ChangeSet,
+  oldDoc: Text,
+  newDoc: Text,
+): SourceEdit[] {
+  const edits: SourceEdit[] = [];
+  changes.iterChanges((fromA, toA, fromB, toB) => {
+    // By the time tree-sitter sees this range, the earlier ones have already been applied, so
+    // everything before it is laid out as in the new document.
+    const startPosition = pointAt(newDoc, fromB);
+    const removedFrom = oldDoc.lineAt(fromA);
+    const removedTo = oldDoc.lineAt(toA);
+    const oldEndPosition =
+      removedFrom.number === removedTo.number
+        ? { row: startPosition.row, column: startPosition.column + (toA - fromA) }
+        : {
+            row: startPosition.row + (removedTo.number - removedFrom.number),
+            column: toA - removedTo.from,
+          };
+
+    edits.push({
+      startIndex: fromB,
+      oldEndIndex: fromB + (toA - fromA),
+      newEndIndex: toB,
+      startPosition,
+      oldEndPosition,
+      newEndPosition: pointAt(newDoc, toB),
+    });
+  });
+  return edits;
+}
@@ -0,0 +1,228 @@
+// Compact, pre-order table of a parse tree. One cursor walk fills a single Uint32Array with a
+// fixed-size record per node; the tree view materializes SyntaxNode objects only for the rows
+// it actually draws, so nothing per-node is allocated on the JS heap for the rest.
+import type { Point, Range, Tree } from "web-tree-sitter";
+
+// Record layout: NODE_STRIDE consecutive words per node, in pre-order.
+const TYPE = 0; // index into FlatTree.types
+const FIELD = 1; // 1 + index into FlatTree.fields, 0 for none
+const FLAGS = 2;
+const DEPTH = 3;
+const END = 4; // pre-order index one past this node's last descendant
+const START_INDEX = 5;
+const END_INDEX = 6;
+const START_ROW = 7;
+const START_COLUMN = 8;
+const END_ROW = 9;
+const END_COLUMN = 10;
+export const NODE_STRIDE = 11;
+
+const NAMED = 1;
+const ERROR = 2;
+const MISSING = 4;
+
+/** A parse tree as flat records plus the type and field names they reference. */
+export interface FlatTree {
+  /** Number of nodes; node 0 is the root. */
+  count: number;
+  data: Uint32Array<ArrayBuffer>;
+  types: string[];
+  fields: string[];
+}
+
+/** One materialized node, built on demand from a FlatTree record. */
+export interface SyntaxNode {
+  /** Pre-order index in the tree, used for React keys and selection. */
+  id: number;
+  type: string;
+  /** Field name this node fills in its parent (e.g. "left"), or null. */
+  fieldName: string | null;
+  isNamed: boolean;
+  isError: boolean;
+  isMissing: boolean;
+  depth: number;
+  /** UTF-16 offsets into the source - these line up 1:1 with CodeMirror positions. */
+  startIndex: number;
+  endIndex: number;
+  startPosition: Point;
+  endPosition: Point;
+}
+
+function intern(names: string[], ids: Map<string, number>, name: string): number {
+  let id = ids.get(name);
+  if (id === undefined) {
+    id = names.length;
+    names.push(name);
+    ids.set(name, id);
+  }
+  return id;
+}
+
+/** True if [start, end) overlaps any of `ranges`, which are sorted and disjoint. */
+function inChangedRange(ranges: Range[], start: number, end: number): boolean {
+  let lo = 0;
+  let hi = ranges.length;
+  // First range that ends after `start`.
+  while (lo < hi) {
+    const mid = (lo + hi) >> 1;
+    if (ranges[mid].endIndex <= start) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo < ranges.length && ranges[lo].startIndex < end;
+}
+
+/**
+ * Flatten `tree` with a single cursor walk. `changed` holds the ranges an incremental parse
+ * changed, or null after a full parse; `reused` counts the nodes lying outside all of them.
+ */
+export function buildFlatTree(
+  tree: Tree,
+  changed: Range[] | null,
+): { flat: FlatTree; reused: number } {
+  const count = tree.rootNode.descendantCount;
+  const data = new Uint32Array(count * NODE_STRIDE);
+  const types: string[] = [];
+  const fields: string[] = [];
+  const typeIds = new Map<string, number>();
+  const fieldIds = new Map<string, number>();
+  // Pre-order indices of the nodes on the path from the root to the cursor.
+  const open: number[] = [];
+  let reused = 0;
+  let n = 0;
+
+  const cursor = tree.walk();
+  try {
+    for (;;) {
+      const at = n * NODE_STRIDE;
+      const type = cursor.nodeType;
+      const field = cursor.currentFieldName;
+      const start = cursor.startPosition;
+      const end = cursor.endPosition;
+
+      data[at + TYPE] = intern(types, typeIds, type);
+      data[at + FIELD] = field ? intern(fields, fieldIds, field) + 1 : 0;
+      data[at + FLAGS] =
+        (cursor.nodeIsNamed ? NAMED : 0) |
+        (type === "ERROR" ? ERROR : 0) |
+        (cursor.nodeIsMissing ? MISSING : 0);
+      data[at + DEPTH] = open.length;
+      data[at + START_INDEX] = cursor.startIndex;
+      data[at + END_INDEX] = cursor.endIndex;
+      data[at + START_ROW] = start.row;
+      data[at + START_COLUMN] = start.column;
+      data[at + END_ROW] = end.row;
+      data[at + END_COLUMN] = end.column;
+      if (changed && !inChangedRange(changed, cursor.startIndex, cursor.endIndex)) reused++;
+      n++;
+
+      if (cursor.gotoFirstChild()) {
+        open.push(n - 1);
+        continue;
+      }
+      // A leaf ends where it starts; then close every ancestor that has no next sibling.
+      data[at + END] = n;
+      while (!cursor.gotoNextSibling()) {
+        const parent = open.pop();
+        if (parent === undefined) return { flat: { count: n, data, types, fields }, reused };
+        data[parent * NODE_STRIDE + END] = n;
+        cursor.gotoParent();
+      }
+    }
+  } finally {
+    cursor.delete();
+  }
+}
+
+/** Pre-order index one past the last descendant of node `i`. */
+export function subtreeEnd(tree: FlatTree, i: number): number {
+  return tree.data[i * NODE_STRIDE + END];
+}
+
+/** Whether the tree view shows node `i` when anonymous nodes are hidden. */
+function isProminent(tree: FlatTree, i: number): boolean {
+  return tree.data[i * NODE_STRIDE + FLAGS] !== 0;
+}
+
+/** Materialize node `i` as a plain object. */
+export function nodeAt(tree: FlatTree, i: number): SyntaxNode {
+  const d = tree.data;
+  const at = i * NODE_STRIDE;
+  const flags = d[at + FLAGS];
+  const field = d[at + FIELD];
+  return {
+    id: i,
+    type: tree.types[d[at + TYPE]],
+    fieldName: field ? tree.fields[field - 1] : null,
+    isNamed: (flags & NAMED) !== 0,
+    isError: (flags & ERROR) !== 0,
+    isMissing: (flags & MISSING) !== 0,
+    depth: d[at + DEPTH],
+    startIndex: d[at + START_INDEX],
+    endIndex: d[at + END_INDEX],
+    startPosition: { row: d[at + START_ROW], column: d[at + START_COLUMN] },
+    endPosition: { row: d[at + END_ROW], column: d[at + END_COLUMN] },
+  };
+}
+
+/** Whether node `i` has any child the tree view would show. */
+export function hasVisibleChildren(
+  tree: FlatTree,
+  i: number,
+  showAnonymous: boolean,
+): boolean {
+  const end = subtreeEnd(tree, i);
+  if (showAnonymous) return end > i + 1;
+  for (let c = i + 1; c < end; c = subtreeEnd(tree, c)) {
+    if (isProminent(tree, c)) return true;
+  }
+  return false;
+}
+
+/**
+ * Pre-order indices of the rows the tree view shows: every node, minus the subtrees of collapsed
+ * nodes and, unless `showAnonymous`, of anonymous nodes. The root is always shown.
+ */
+export function visibleRows(
+  tree: FlatTree,
+  showAnonymous: boolean,
+  collapsed: ReadonlySet<number>,
+): Uint32Array {
+  const rows = new Uint32Array(tree.count);
+  let n = 0;
+  for (let i = 0; i < tree.count; ) {
+    if (i > 0 && !showAnonymous && !isProminent(tree, i)) {
+      i = subtreeEnd(tree, i);
+      continue;
+    }
+    rows[n++] = i;
+    i = collapsed.has(i) ? subtreeEnd(tree, i) : i + 1;
+  }
+  return rows.subarray(0, n);
+}
+
+/**
+ * Pre-order index of the outermost node of type `type` spanning exactly [startIndex, endIndex),
+ * or -1. Used to map query captures, which reference the wasm tree, back onto the table.
+ */
+export function findNode(
+  tree: FlatTree,
+  startIndex: number,
+  endIndex: number,
+  type: string,
+): number {
+  const d = tree.data;
+  // Start offsets never decrease in pre-order, so binary search for the first candidate.
+  let lo = 0;
+  let hi = tree.count;
+  while (lo < hi) {
+    const mid = (lo + hi) >> 1;
+    if (d[mid * NODE_STRIDE + START_INDEX] < startIndex) lo = mid + 1;
+    else hi = mid;
+  }
+  for (let i = lo; i < tree.count; i++) {
+    const at = i * NODE_STRIDE;
+    if (d[at + START_INDEX] !== startIndex) break;
+    if (d[at + END_INDEX] === endIndex && tree.types[d[at + TYPE]] === type) return i;
+  }
+  return -1;
+}
@@ -0,0 +1,115 @@
+// Highlight spans for a window of the document (the editor viewport plus a margin), kept
+// across parses. After an edit the cached spans are shifted rather than recomputed; only the
+// edited text, the ranges tree-sitter reports as changed, and newly exposed parts of the
+// window are queried again, so the cost follows what changed and what's on screen.
+import type { SourceEdit } from "./parser";
+import type { Highlight } from "./spans";
+
+/** A [from, to) range of UTF-16 offsets. */
+export interface Interval {
+  from: number;
+  to: number;
+}
+
+export interface HighlightCache {
+  /** Spans of every capture intersecting the covered window, ordered by start. */
+  spans: Highlight[];
+  /** The covered window; empty when nothing is cached. */
+  from: number;
+  to: number;
+}
+
+export function emptyHighlightCache(): HighlightCache {
+  return { spans: [], from: 0, to: 0 };
+}
+
+const intersects = (a: Interval, b: Interval) => a.from < b.to && b.from < a.to;
+
+/**
+ * Shift the cache through `edits`, applied in order, dropping spans that touch edited text.
+ * Returns the ranges, in post-edit offsets, that must be re-queried because spans were dropped.
+ */
+export function applyEdits(cache: HighlightCache, edits: SourceEdit[]): Interval[] {
+  let dirty: Interval[] = [];
+  for (const e of edits) {
+    const delta = e.newEndIndex - e.oldEndIndex;
+    const mapFrom = (p: number) =>
+      p <= e.startIndex ? p : p >= e.oldEndIndex ? p + delta : e.startIndex;
+    const mapTo = (p: number) =>
+      p <= e.startIndex ? p : p >= e.oldEndIndex ? p + delta : e.newEndIndex;
+
+    // A span that merely touches the edit may still change (typing onto the end of a word).
+    const spans: Highlight[] = [];
+    for (const s of cache.spans) {
+      if (s.to < e.startIndex) spans.push(s);
+      else if (s.from > e.oldEndIndex) spans.push({ ...s, from: s.from + delta, to: s.to + delta });
+    }
+    cache.spans = spans;
+    cache.from = mapFrom(cache.from);
+    cache.to = mapTo(cache.to);
+
+    dirty = dirty.map((d) => ({ from: mapFrom(d.from), to: mapTo(d.to) }));
+    dirty.push({ from: e.startIndex, to: e.newEndIndex });
+  }
+  return dirty;
+}
+
+/** Sort and merge overlapping or adjacent intervals, dropping empty ones. */
+function normalize(intervals: Interval[]): Interval[] {
+  const sorted = intervals.filter((r) => r.to > r.from).sort((a, b) => a.from - b.from);
+  const out: Interval[] = [];
+  for (const r of sorted) {
+    const last = out[out.length - 1];
+    if (last && r.from <= last.to) last.to = Math.max(last.to, r.to);
+    else out.push({ ...r });
+  }
+  return out;
+}
+
+/**
+ * Bring the cache up to date for `window`: query the parts of it not covered yet plus the `dirty`
+ * ranges inside it, and drop spans that lie wholly outside it. `capture` runs the highlight
+ * query over one range and returns the spans of the captures intersecting it.
+ */
+export function refresh(
+  cache: HighlightCache,
+  window: Interval,
+  dirty: Interval[],
+  capture: (range: Interval) => Highlight[],
+): void {
+  const todo: Interval[] = [];
+  if (cache.to <= cache.from || !intersects(cache, window)) {
+    todo.push(window);
+  } else {
+    todo.push({ from: window.from, to: cache.from }, { from: cache.to, to: window.to });
+  }
+  // Widen by a character so zero-width ranges (deletions) and the nodes around them are covered.
+  for (const d of dirty) {
+    todo.push({
+      from: Math.max(window.from, d.from - 1),
+      to: Math.min(window.to, d.to + 1),
+    });
+  }
+  const ranges = normalize(todo);
+
+  const spans = cache.spans.filter(
+    (s) => intersects(s, window) && !ranges.some((r) => intersects(s, r)),
+  );
+  // A capture spanning several ranges comes back once per range.
+  const seen = new Set<string>();
+  for (const r of ranges) {
+    for (const s of capture(r)) {
+      const key = `${s.from}:${s.to}:${s.type}`;
+      if (!seen.has(key)) {
+        seen.add(key);
+        spans.push(s);
+      }
+    }
+  }
+
+  // Stable, so captures of the same node keep their query order (which decides precedence).
+  spans.sort((a, b) => a.from - b.from);
+  cache.spans = spans;
+  cache.from = window.from;
+  cache.to = window.to;
+}
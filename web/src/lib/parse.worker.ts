@@ -0,0 +1,88 @@
+// Parse worker: owns the wasm runtime, the grammar, and the previous tree (see parser.ts).
+// Requests are handled one at a time. Any that queue up behind a running parse are folded
+// into the newest, so a burst of keystrokes costs one parse rather than one per keystroke.
+// Likewise only the newest viewport is highlighted, and not at all if a parse is due anyway.
+import { highlight, parse } from "./parser";
+import type {
+  HighlightRequest,
+  ParseRequest,
+  ParseResponse,
+  WorkerRequest,
+} from "./parseClient";
+
+let pending: ParseRequest | null = null;
+let pendingHighlight: HighlightRequest | null = null;
+let busy = false;
+// The viewport of the newest request of either kind; whatever runs next highlights it.
+let viewport = { from: 0, to: 0 };
+
+function post(msg: ParseResponse, transfer: Transferable[] = []) {
+  self.postMessage(msg, { transfer });
+}
+
+function postError(id: number, err: unknown) {
+  post({ id, kind: "error", message: err instanceof Error ? err.message : String(err) });
+}
+
+async function run() {
+  while (pending || pendingHighlight) {
+    if (pending) {
+      // The parse highlights the newest viewport, so a queued highlight is moot.
+      const req = pending;
+      pending = null;
+      if (pendingHighlight) {
+        post({ id: pendingHighlight.id, kind: "superseded" });
+        pendingHighlight = null;
+      }
+      try {
+        const result = await parse(req.source, req.queryText, req.edits, viewport, req.timeoutMs);
+        if ("timedOut" in result) {
+          post({ id: req.id, kind: "timedOut", timeout: result });
+          continue;
+        }
+        const transfer: ArrayBuffer[] = [result.tree.data.buffer, result.highlights.data.buffer];
+        if (result.query) transfer.push(result.query.matches.data.buffer);
+        post({ id: req.id, kind: "done", result }, transfer);
+      } catch (err) {
+        postError(req.id, err);
+      }
+    } else if (pendingHighlight) {
+      const req = pendingHighlight;
+      pendingHighlight = null;
+      try {
+        const highlights = await highlight(viewport);
+        post(
+          { id: req.id, kind: "highlighted", highlights },
+          highlights ? [highlights.data.buffer] : [],
+        );
+      } catch (err) {
+        postError(req.id, err);
+      }
+    }
+  }
+  busy = false;
+}
+
+function enqueue(req: WorkerRequest) {
+  viewport = req.viewport;
+  if (req.kind === "highlight") {
+    if (pendingHighlight) post({ id: pendingHighlight.id, kind: "superseded" });
+    pendingHighlight = req;
+  } else if (pending) {
+    // The skipped request's edits still happened: the tree has to see them, in order.
+    const edits = pending.edits && req.edits ? [...pending.edits, ...req.edits] : null;
+    post({ id: pending.id, kind: "superseded" });
+    pending = { ...req, edits };
+  } else {
+    pending = req;
+  }
+}
+
+self.onmessage = (e: MessageEvent<WorkerRequest>) => {
+  enqueue(e.data);
+  if (!busy) {
+    busy = true;
+    // Yield once so messages already queued behind this one are folded in before parsing starts.
+    setTimeout(run, 0);
+  }
+};
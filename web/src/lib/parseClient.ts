@@ -0,0 +1,105 @@
+// Main-thread side of the parse worker. Parsing and queries run in parse.worker.ts so a big
+// paste never blocks the editor; results come back as flat typed arrays, transferred rather
+// than copied, and are handed out through the same promise-shaped API parser.ts has.
+import type { ParseResult, ParseTimeout, SourceEdit } from "./parser";
+import type { Interval } from "./highlightCache";
+import type { Spans } from "./spans";
+
+export interface ParseRequest {
+  kind: "parse";
+  id: number;
+  source: string;
+  queryText: string;
+  /** Edits since the previous request's source, or null if unknown. */
+  edits: SourceEdit[] | null;
+  /** Visible editor range to highlight (plus a margin). */
+  viewport: Interval;
+  /** Milliseconds the parse may take before it's abandoned, or 0 for no limit. */
+  timeoutMs: number;
+}
+
+/** Re-highlight the last parse for a scrolled viewport. */
+export interface HighlightRequest {
+  kind: "highlight";
+  id: number;
+  viewport: Interval;
+}
+
+export type WorkerRequest = ParseRequest | HighlightRequest;
+
+export type ParseResponse =
+  | { id: number; kind: "done"; result: ParseResult }
+  | { id: number; kind: "timedOut"; timeout: ParseTimeout }
+  | { id: number; kind: "highlighted"; highlights: Spans | null }
+  | { id: number; kind: "superseded" }
+  | { id: number; kind: "error"; message: string };
+
+interface Waiter {
+  resolve: (result: ParseResult | ParseTimeout | Spans | null) => void;
+  reject: (err: Error) => void;
+}
+
+let worker: Worker | null = null;
+let nextId = 0;
+const waiting = new Map<number, Waiter>();
+
+function getWorker(): Worker {
+  if (!worker) {
+    worker = new Worker(new URL("./parse.worker.ts", import.meta.url), { type: "module" });
+    worker.onmessage = (e: MessageEvent<ParseResponse>) => {
+      const msg = e.data;
+      const waiter = waiting.get(msg.id);
+      if (!waiter) return;
+      waiting.delete(msg.id);
+      if (msg.kind === "done") waiter.resolve(msg.result);
+      else if (msg.kind === "timedOut") waiter.resolve(msg.timeout);
+      else if (msg.kind === "highlighted") waiter.resolve(msg.highlights);
+      else if (msg.kind === "superseded") waiter.resolve(null);
+      else waiter.reject(new Error(msg.message));
+    };
+    // A failure to load the worker or the grammar is fatal for every outstanding request.
+    worker.onerror = (e) => {
+      const err = new Error(e.message || "Parse worker failed");
+      for (const waiter of waiting.values()) waiter.reject(err);
+      waiting.clear();
+    };
+  }
+  return worker;
+}
+
+function send<T>(request: WorkerRequest): Promise<T | null> {
+  return new Promise((resolve, reject) => {
+    waiting.set(request.id, {
+      resolve: resolve as (result: ParseResult | ParseTimeout | Spans | null) => void,
+      reject,
+    });
+    getWorker().postMessage(request);
+  });
+}
+
+/**
+ * Parse `source` in the worker; see parser.ts for what the arguments mean. Resolves to null if a
+ * newer parse arrived before the worker got to this one. The worker then parses only the newest
+ * source, applying the edits of every request it skipped. Resolves to a ParseTimeout if the parse
+ * took longer than `timeoutMs`.
+ *
+ * The timeout is the only way to stop a parse once the worker has started it: the parse runs
+ * synchronously, so the worker can't receive a cancel message until it's over anyway.
+ */
+export function parse(
+  source: string,
+  queryText: string,
+  edits: SourceEdit[] | null,
+  viewport: Interval,
+  timeoutMs = 0,
+): Promise<ParseResult | ParseTimeout | null> {
+  return send({ kind: "parse", id: nextId++, source, queryText, edits, viewport, timeoutMs });
+}
+
+/**
+ * Highlight spans for `viewport` over the last parse. Resolves to null if nothing has been parsed
+ * yet or a newer request made this one moot.
+ */
+export function highlight(viewport: Interval): Promise<Spans | null> {
+  return send({ kind: "highlight", id: nextId++, viewport });
+}
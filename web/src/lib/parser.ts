@@ -1,7 +1,23 @@
-// Thin wrapper around web-tree-sitter: one-time init, grammar load, and a walk that
-// turns a parse Tree into a plain serializable model the React tree view can render
-// without touching the wasm-backed objects (which must not outlive a re-parse).
-import { Parser, Language, Query, type TreeCursor } from "web-tree-sitter";
+// Thin wrapper around web-tree-sitter: one-time init, grammar load, and flattening a
+// parse Tree into a plain table (see flatTree.ts) the React tree view can render
+// without touching the wasm-backed objects (which must not outlive a re-parse). The
+// last Tree is kept so the next parse can be incremental. This module runs in the
+// parse worker (parse.worker.ts); the main thread only imports its types.
+import {
+  Parser,
+  Language,
+  Query,
+  Edit,
+  type Tree,
+} from "web-tree-sitter";
+import { buildFlatTree, findNode, type FlatTree } from "./flatTree";
+import { captureSpan, packSpans, spansFromCaptures, type Spans } from "./spans";
+import {
+  applyEdits,
+  emptyHighlightCache,
+  refresh,
+  type Interval,
+} from "./highlightCache";
 import coreWasmUrl from "web-tree-sitter/web-tree-sitter.wasm?url";
 import highlightsQuery from "../../../queries/highlights.scm?raw";
 
@@ -10,57 +26,113 @@ export interface Point {
   column: number;
 }
 
-/** Plain, JSON-serializable mirror of a tree-sitter node. */
-export interface SyntaxNode {
-  /** Stable-per-parse id, used for React keys and selection. */
-  id: number;
-  type: string;
-  /** Field name this node fills in its parent (e.g. "left"), or null. */
-  fieldName: string | null;
-  isNamed: boolean;
-  isError: boolean;
-  isMissing: boolean;
-  /** UTF-16 offsets into the source - these line up 1:1 with CodeMirror positions. */
-  startIndex: number;
-  endIndex: number;
-  startPosition: Point;
-  endPosition: Point;
-  children: SyntaxNode[];
-}
-
-/** A resolved highlight span: `type` is the tree-sitter capture name (e.g. "function.method"). */
-export interface Highlight {
-  from: number;
-  to: number;
-  type: string;
-}
-
 /** Result of running the user's playground query against a parse. */
 export interface QueryResult {
   /** Query compile error message, or null if the query compiled. */
   error: string | null;
-  /** Model-node ids (SyntaxNode.id) captured by the query, for tree emphasis. */
+  /** Pre-order indices (SyntaxNode.id) of the nodes captured by the query, for tree emphasis. */
   matchedIds: Set<number>;
-  /** Captured source spans for editor highlighting; `type` is the capture name. */
-  matches: Highlight[];
+  /** Captured source spans for editor highlighting, named by capture. */
+  matches: Spans;
+}
+
+/** A source edit since the previous parse. Offsets and columns are UTF-16 code units. */
+export interface SourceEdit {
+  startIndex: number;
+  oldEndIndex: number;
+  newEndIndex: number;
+  startPosition: Point;
+  oldEndPosition: Point;
+  newEndPosition: Point;
 }
 
-/** The full result of a parse: the plain tree plus highlight spans (captures may overlap). */
+/** Timing and reuse figures for one parse, for profiling incremental behavior. */
+export interface ParseStats {
+  /** Time spent in parser.parse alone (not the model walk or queries), in milliseconds. */
+  parseMs: number;
+  /** True if the previous tree was edited and handed to the parser. */
+  incremental: boolean;
+  nodeCount: number;
+  /**
+   * Nodes lying outside every range the parse reported as changed, i.e. structure carried over
+   * from the previous tree. Always 0 for a full parse.
+   */
+  reusedNodes: number;
+  /**
+   * Time spent running the highlight query over the parts of the window that needed it, in
+   * milliseconds. Includes checking its text predicates (#match? and friends), which
+   * web-tree-sitter does in JS for every match of a guarded pattern.
+   */
+  highlightMs: number;
+}
+
+/**
+ * The full result of a parse: the flattened tree plus highlight spans (captures may overlap).
+ * Highlights only cover the window around the viewport the parse was asked for.
+ */
 export interface ParseResult {
-  root: SyntaxNode;
-  highlights: Highlight[];
+  tree: FlatTree;
+  highlights: Spans;
   /** Result of the user's playground query, or null when no query was supplied. */
   query: QueryResult | null;
+  stats: ParseStats;
+  /** How long loading the grammar took; set on the first parse only. */
+  startup: StartupTimings | null;
+}
+
+/**
+ * What a parse that ran over its time budget returns instead of a ParseResult. The runtime stops
+ * it from its progress callback, so no tree comes out; the previous one is kept, with the edits
+ * applied, for the next parse to start from.
+ */
+export interface ParseTimeout {
+  timedOut: true;
+  /** Time spent in parser.parse before it gave up, in milliseconds. */
+  parseMs: number;
+  timeoutMs: number;
+}
+
+/** Written next to the grammar wasm by scripts/build-grammar-wasm.mjs. */
+interface GrammarManifest {
+  /** Content-hashed file name under BASE_URL. */
+  file: string;
+  version: string;
+  /** wasm-opt profile: "size", "speed", or "unoptimized". */
+  profile: string;
+  bytes: number;
+}
+
+/** Phases of loading the grammar, in milliseconds. */
+export interface StartupTimings {
+  profile: string;
+  version: string;
+  wasmBytes: number;
+  /** Initializing the web-tree-sitter runtime itself. */
+  runtimeMs: number;
+  /** Downloading the grammar module (from Resource Timing; 0 if the browser doesn't report it). */
+  fetchMs: number;
+  /** True if the module came from the HTTP cache. */
+  cached: boolean;
+  /** Compiling and instantiating the module, beyond the part overlapped with the download. */
+  compileMs: number;
+  firstParseMs: number;
 }
 
 interface Grammar {
   parser: Parser;
   language: Language;
   query: Query;
+  startup: Omit<StartupTimings, "firstParseMs">;
 }
 
 let grammarPromise: Promise<Grammar> | null = null;
 
+// The last tree produced, and the length of the source it was parsed from.
+let previous: { tree: Tree; length: number } | null = null;
+
+// Highlight spans around the viewport, carried from parse to parse.
+let highlightCache = emptyHighlightCache();
+
 // Compiled user query, cached by its source text so identical re-parses don't recompile.
 let userQueryCache: { text: string; query: Query | null; error: string | null } | null = null;
 
@@ -83,99 +155,189 @@ function getUserQuery(
   return userQueryCache;
 }
 
-/** Lazily initialize the wasm runtime + grammar + highlight query (singleton). */
+/** Highlight window for a viewport: the viewport plus a screenful, or more, on either side. */
+function highlightWindow(viewport: Interval): Interval {
+  const margin = Math.max(viewport.to - viewport.from, 4096);
+  return { from: Math.max(0, viewport.from - margin), to: viewport.to + margin };
+}
+
+/** Bring the highlight cache up to date for `tree` and return it packed. */
+function updateHighlights(
+  tree: Tree,
+  query: Query,
+  viewport: Interval,
+  dirty: Interval[],
+): Spans {
+  refresh(highlightCache, highlightWindow(viewport), dirty, (range) =>
+    query
+      .captures(tree.rootNode, { startIndex: range.from, endIndex: range.to })
+      .map(captureSpan),
+  );
+  return packSpans(highlightCache.spans);
+}
+
+/**
+ * Lazily initialize the wasm runtime + grammar + highlight query (singleton).
+ *
+ * The grammar's file name carries a hash of its contents (see the manifest), so the browser can
+ * keep it, and the machine code it compiles from it, cached per version. Language.load compiles
+ * with WebAssembly.compileStreaming, overlapping compilation with the download.
+ */
 function getGrammar(): Promise<Grammar> {
   if (!grammarPromise) {
     grammarPromise = (async () => {
+      const started = performance.now();
       await Parser.init({ locateFile: () => coreWasmUrl });
+      const runtimeMs = performance.now() - started;
+
+      const base = new URL(import.meta.env.BASE_URL, self.location.href);
+      const response = await fetch(new URL("grammar-manifest.json", base), { cache: "no-cache" });
+      if (!response.ok) throw new Error(`Failed to load grammar manifest: ${response.status}`);
+      const manifest = (await response.json()) as GrammarManifest;
 
-      const grammarUrl = `${import.meta.env.BASE_URL}tree-sitter-autohotkey.wasm`;
+      const grammarUrl = new URL(manifest.file, base).href;
+      const loadStarted = performance.now();
       const language = await Language.load(grammarUrl);
-      const parser = new Parser();
+      const loadMs = performance.now() - loadStarted;
+
+      const timing = performance.getEntriesByName(grammarUrl)[0] as
+        | PerformanceResourceTiming
+        | undefined;
+      const fetchMs = timing ? timing.responseEnd - timing.startTime : 0;
 
+      const parser = new Parser();
       parser.setLanguage(language);
       const query = new Query(language, highlightsQuery);
-      return { parser, language, query };
+      const startup = {
+        profile: manifest.profile,
+        version: manifest.version,
+        wasmBytes: manifest.bytes,
+        runtimeMs,
+        fetchMs,
+        cached: timing !== undefined && timing.transferSize === 0,
+        compileMs: Math.max(0, loadMs - fetchMs),
+      };
+      return { parser, language, query, startup };
     })();
   }
   return grammarPromise;
 }
 
+// Reported with the first parse only.
+let startupReported = false;
+
 /**
  * Parse source and return the root node as a plain model plus highlight spans. When `queryText`
  * is a non-empty query, it's run against the same tree and its result returned in `query`.
+ *
+ * `edits` describes how `source` was derived from the previously parsed source, in order. When
+ * given, the previous tree is edited and re-used; pass null when the relationship is unknown
+ * (e.g. the source was replaced wholesale) to force a full parse.
+ *
+ * Highlights are computed for `viewport` (editor offsets) plus a margin.
+ *
+ * A parse still running after `timeoutMs` is abandoned and a ParseTimeout returned, so a
+ * pathological script can't hang the worker (0 means no limit).
  */
 export async function parse(
   source: string,
-  queryText?: string,
-): Promise<ParseResult> {
-  const { parser, language, query } = await getGrammar();
-  const tree = parser.parse(source);
+  queryText: string,
+  edits: SourceEdit[] | null,
+  viewport: Interval,
+  timeoutMs = 0,
+): Promise<ParseResult | ParseTimeout> {
+  const { parser, language, query, startup } = await getGrammar();
 
-  if (!tree) throw new Error("Parse failed: tree-sitter returned null");
+  // Cheap consistency check: edits that don't account for the length change can't describe this
+  // source, and feeding them to tree-sitter would yield a tree that doesn't match the text.
+  let oldTree: Tree | null = null;
+  if (previous && edits) {
+    let length = previous.length;
+    for (const e of edits) length += e.newEndIndex - e.oldEndIndex;
+    if (length === source.length) {
+      for (const e of edits) previous.tree.edit(new Edit(e));
+      oldTree = previous.tree;
+    }
+  }
+
+  // The grammar has no token for a byte order mark, so a leading one would start the tree with an
+  // ERROR. A space is one UTF-16 unit too, so every offset still lines up with the editor's.
+  const text = source.charCodeAt(0) === 0xfeff ? ` ${source.slice(1)}` : source;
+
+  const started = performance.now();
+  const deadline = timeoutMs > 0 ? started + timeoutMs : Infinity;
+  const tree = parser.parse(text, oldTree, {
+    progressCallback: () => performance.now() >= deadline,
+  });
+  const parseMs = performance.now() - started;
 
-  try {
-    const counter = { n: 0 };
-    // Maps each real tree-sitter node id to its per-parse model id, so query captures
-    // (which reference the wasm tree) can be mapped back onto the plain tree nodes.
-    const tsIdToModelId = new Map<number, number>();
-    const root = walk(tree.walk(), counter, tsIdToModelId);
-    // Captures reference the wasm-backed tree, so pull out plain offsets before it's deleted.
-    const highlights = query.captures(tree.rootNode).map((c) => ({
-      from: c.node.startIndex,
-      to: c.node.endIndex,
-      type: c.name,
-    }));
-
-    let queryResult: QueryResult | null = null;
-    if (queryText && queryText.trim() !== "") {
-      const { query: userQuery, error } = getUserQuery(language, queryText);
-      const matchedIds = new Set<number>();
-      const matches: Highlight[] = [];
-      if (userQuery) {
-        for (const c of userQuery.captures(tree.rootNode)) {
-          const modelId = tsIdToModelId.get(c.node.id);
-          if (modelId !== undefined) matchedIds.add(modelId);
-          matches.push({ from: c.node.startIndex, to: c.node.endIndex, type: c.name });
-        }
-      }
-      queryResult = { error, matchedIds, matches };
+  if (!tree && performance.now() >= deadline) {
+    // Left alone, the parser would resume this parse the next time it's called.
+    parser.reset();
+    // The edited tree still describes `source`, so the next parse can be incremental on it; a
+    // tree the edits weren't applied to doesn't, and is dropped.
+    if (oldTree) {
+      previous = { tree: oldTree, length: source.length };
+    } else {
+      previous?.tree.delete();
+      previous = null;
     }
+    highlightCache = emptyHighlightCache();
+    return { timedOut: true, parseMs, timeoutMs };
+  }
+
+  const changed = oldTree && tree ? oldTree.getChangedRanges(tree) : null;
+  previous?.tree.delete();
+  previous = tree ? { tree, length: source.length } : null;
 
-    return { root, highlights, query: queryResult };
-  } finally {
-    tree.delete();
+  // Cached spans survive only an incremental parse, shifted through the same edits as the tree.
+  let dirty: Interval[] = [];
+  if (oldTree && edits && changed) {
+    dirty = applyEdits(highlightCache, edits);
+    for (const r of changed) dirty.push({ from: r.startIndex, to: r.endIndex });
+  } else {
+    highlightCache = emptyHighlightCache();
   }
-}
 
-/** Depth-first cursor walk into the plain model. Cursor is positioned on the node on entry. */
-function walk(
-  cursor: TreeCursor,
-  counter: { n: number },
-  tsIdToModelId: Map<number, number>,
-): SyntaxNode {
-  const node = cursor.currentNode;
-  const model: SyntaxNode = {
-    id: counter.n++,
-    type: node.type,
-    fieldName: cursor.currentFieldName ?? null,
-    isNamed: node.isNamed,
-    isError: node.isError,
-    isMissing: node.isMissing,
-    startIndex: node.startIndex,
-    endIndex: node.endIndex,
-    startPosition: node.startPosition,
-    endPosition: node.endPosition,
-    children: [],
-  };
-  tsIdToModelId.set(node.id, model.id);
+  if (!tree) throw new Error("Parse failed: tree-sitter returned null");
+
+  const { flat, reused } = buildFlatTree(tree, changed);
+  const highlightStarted = performance.now();
+  const highlights = updateHighlights(tree, query, viewport, dirty);
+  const highlightMs = performance.now() - highlightStarted;
 
-  if (cursor.gotoFirstChild()) {
-    do {
-      model.children.push(walk(cursor, counter, tsIdToModelId));
-    } while (cursor.gotoNextSibling());
-    cursor.gotoParent();
+  let queryResult: QueryResult | null = null;
+  if (queryText && queryText.trim() !== "") {
+    const { query: userQuery, error } = getUserQuery(language, queryText);
+    const matchedIds = new Set<number>();
+    const captures = userQuery ? userQuery.captures(tree.rootNode) : [];
+    for (const { node } of captures) {
+      const index = findNode(flat, node.startIndex, node.endIndex, node.type);
+      if (index !== -1) matchedIds.add(index);
+    }
+    queryResult = { error, matchedIds, matches: spansFromCaptures(captures) };
   }
 
-  return model;
+  const stats: ParseStats = {
+    parseMs,
+    incremental: oldTree !== null,
+    nodeCount: flat.count,
+    reusedNodes: reused,
+    highlightMs,
+  };
+  let startupTimings: StartupTimings | null = null;
+  if (!startupReported) {
+    startupReported = true;
+    startupTimings = { ...startup, firstParseMs: parseMs };
+  }
+  return { tree: flat, highlights, query: queryResult, stats, startup: startupTimings };
+}
+
+/**
+ * Highlights for a new viewport over the last parsed tree, re-using whatever the cache already
+ * covers. Null if nothing has been parsed yet.
+ */
+export async function highlight(viewport: Interval): Promise<Spans | null> {
+  const { query } = await getGrammar();
+  return previous ? updateHighlights(previous.tree, query, viewport, []) : null;
 }
@@ -0,0 +1,52 @@
+// Query captures as flat (from, to, name) triples. Spans cross from the parse worker to the
+// main thread as a single transferable buffer instead of one object per capture.
+import type { QueryCapture } from "web-tree-sitter";
+
+/** A resolved highlight span: `type` is the tree-sitter capture name (e.g. "function.method"). */
+export interface Highlight {
+  from: number;
+  to: number;
+  type: string;
+}
+
+/** Capture spans: `data` holds from, to, and an index into `names` for each span. */
+export interface Spans {
+  data: Uint32Array<ArrayBuffer>;
+  names: string[];
+}
+
+export const SPAN_STRIDE = 3;
+
+export const NO_SPANS: Spans = { data: new Uint32Array(0), names: [] };
+
+export function spanCount(spans: Spans): number {
+  return spans.data.length / SPAN_STRIDE;
+}
+
+/** Pack resolved spans. */
+export function packSpans(highlights: Highlight[]): Spans {
+  const data = new Uint32Array(highlights.length * SPAN_STRIDE);
+  const names: string[] = [];
+  const ids = new Map<string, number>();
+  highlights.forEach((h, i) => {
+    let id = ids.get(h.type);
+    if (id === undefined) {
+      id = names.length;
+      names.push(h.type);
+      ids.set(h.type, id);
+    }
+    data[i * SPAN_STRIDE] = h.from;
+    data[i * SPAN_STRIDE + 1] = h.to;
+    data[i * SPAN_STRIDE + 2] = id;
+  });
+  return { data, names };
+}
+
+/** Pack captures, which reference the wasm-backed tree, into plain offsets. */
+export function spansFromCaptures(captures: QueryCapture[]): Spans {
+  return packSpans(captures.map(captureSpan));
+}
+
+export function captureSpan(c: QueryCapture): Highlight {
+  return { from: c.node.startIndex, to: c.node.endIndex, type: c.name };
+}
@@ -7,6 +7,8 @@ import react from "@vitejs/plugin-react";
 export default defineConfig({
   base: "/tree-sitter-autohotkey/",
   plugins: [react()],
+  // Parsing runs in a module worker (src/lib/parse.worker.ts) that imports web-tree-sitter.
+  worker: { format: "es" },
   // web-tree-sitter ships a .wasm we import with `?url`; Vite handles it natively.
   server: {
     // We import ../../queries/highlights.scm?raw from the parent repo, so let the dev